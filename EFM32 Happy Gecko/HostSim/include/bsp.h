@@ -0,0 +1,21 @@
+/**************************************************************************//**
+ * @file bsp.h
+ * @brief Host simulation stand-in for the kit BSP, LEDs on PF4/PF5.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_BSP_H
+#define HOSTSIM_BSP_H
+
+#include <stdint.h>
+#include "bspconfig.h"
+
+#define BSP_STATUS_OK   0
+
+int BSP_LedsInit(void);
+int BSP_LedClear(int ledNo);
+int BSP_LedSet(int ledNo);
+int BSP_LedToggle(int ledNo);
+uint32_t BSP_LedsGet(void);
+int BSP_LedsSet(uint32_t leds);
+
+#endif /* HOSTSIM_BSP_H */
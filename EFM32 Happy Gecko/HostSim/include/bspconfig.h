@@ -0,0 +1,27 @@
+/**************************************************************************//**
+ * @file bspconfig.h
+ * @brief Host simulation stand-in for the SLSTK3400A kit configuration.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_BSPCONFIG_H
+#define HOSTSIM_BSPCONFIG_H
+
+#define BSP_STK
+#define BSP_STK_3400
+
+#define BSP_NO_OF_LEDS          2
+#define BSP_GPIO_LED0_PORT      gpioPortF
+#define BSP_GPIO_LED0_PIN       4
+#define BSP_GPIO_LED1_PORT      gpioPortF
+#define BSP_GPIO_LED1_PIN       5
+
+#define BSP_GPIO_PB0_PORT       gpioPortC
+#define BSP_GPIO_PB0_PIN        9
+#define BSP_GPIO_PB1_PORT       gpioPortC
+#define BSP_GPIO_PB1_PIN        10
+
+/* PRS channel the display PAL toggles EXTCOMIN on, 64 Hz from RTC COMP0 */
+#define LCD_AUTO_TOGGLE_PRS_CH  4
+#define LCD_AUTO_TOGGLE_HZ      64
+
+#endif /* HOSTSIM_BSPCONFIG_H */
@@ -0,0 +1,253 @@
+/**************************************************************************//**
+ * @file core_cm0plus.h
+ * @brief Host simulation replacement for the CMSIS Cortex-M0+ core header.
+ *
+ * The device header includes this instead of the CMSIS one. It provides the
+ * subset of the core peripherals and intrinsics emlib and the examples use:
+ * NVIC, SCB (SCR, ICSR) and SysTick as memory blocks, and the sleep,
+ * barrier and interrupt masking intrinsics as calls into the simulator.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_CORE_CM0PLUS_H
+#define HOSTSIM_CORE_CM0PLUS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __CM0PLUS_CMSIS_VERSION_MAIN  (5U)
+#define __CM0PLUS_CMSIS_VERSION_SUB   (0U)
+#define __CORTEX_M                    (0U)
+#define __FPU_USED                    0U
+
+#ifdef __cplusplus
+#define __I     volatile
+#else
+#define __I     volatile const
+#endif
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#ifndef __ASM
+#define __ASM             __asm
+#endif
+#ifndef __INLINE
+#define __INLINE          inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE   static inline
+#endif
+#ifndef __STATIC_FORCEINLINE
+#define __STATIC_FORCEINLINE static inline __attribute__((always_inline))
+#endif
+#ifndef __NO_RETURN
+#define __NO_RETURN       __attribute__((noreturn))
+#endif
+#ifndef __USED
+#define __USED            __attribute__((used))
+#endif
+#ifndef __WEAK
+#define __WEAK            __attribute__((weak))
+#endif
+#ifndef __PACKED
+#define __PACKED          __attribute__((packed))
+#endif
+#ifndef __ALIGNED
+#define __ALIGNED(x)      __attribute__((aligned(x)))
+#endif
+
+/* Simulator entry points behind the intrinsics */
+void simWfi(void);
+void simPrimaskSet(uint32_t primask);
+uint32_t simPrimaskGet(void);
+void simNvicUpdate(void);
+void simNvicPrioritySet(int irq, uint32_t priority);
+uint32_t simNvicPriorityGet(int irq);
+void simSystemReset(void);
+
+/*******************************************************************************
+ ******************************   CORE REGISTERS   *****************************
+ ******************************************************************************/
+
+typedef struct {
+  __IOM uint32_t ISER[1U];
+  uint32_t RESERVED0[31U];
+  __IOM uint32_t ICER[1U];
+  uint32_t RSERVED1[31U];
+  __IOM uint32_t ISPR[1U];
+  uint32_t RESERVED2[31U];
+  __IOM uint32_t ICPR[1U];
+  uint32_t RESERVED3[31U];
+  uint32_t RESERVED4[64U];
+  __IOM uint32_t IP[8U];
+} NVIC_Type;
+
+typedef struct {
+  __IM  uint32_t CPUID;
+  __IOM uint32_t ICSR;
+  __IOM uint32_t VTOR;
+  __IOM uint32_t AIRCR;
+  __IOM uint32_t SCR;
+  __IOM uint32_t CCR;
+  uint32_t RESERVED1;
+  __IOM uint32_t SHP[2U];
+  __IOM uint32_t SHCSR;
+} SCB_Type;
+
+typedef struct {
+  __IOM uint32_t CTRL;
+  __IOM uint32_t LOAD;
+  __IOM uint32_t VAL;
+  __IM  uint32_t CALIB;
+} SysTick_Type;
+
+#define SCB_ICSR_NMIPENDSET_Msk        (1UL << 31)
+#define SCB_ICSR_PENDSVSET_Pos         28U
+#define SCB_ICSR_PENDSVSET_Msk         (1UL << SCB_ICSR_PENDSVSET_Pos)
+#define SCB_ICSR_PENDSVCLR_Pos         27U
+#define SCB_ICSR_PENDSVCLR_Msk         (1UL << SCB_ICSR_PENDSVCLR_Pos)
+#define SCB_ICSR_PENDSTSET_Pos         26U
+#define SCB_ICSR_PENDSTSET_Msk         (1UL << SCB_ICSR_PENDSTSET_Pos)
+#define SCB_ICSR_PENDSTCLR_Pos         25U
+#define SCB_ICSR_PENDSTCLR_Msk         (1UL << SCB_ICSR_PENDSTCLR_Pos)
+#define SCB_ICSR_VECTACTIVE_Msk        (0x1FFUL)
+
+#define SCB_AIRCR_VECTKEY_Pos          16U
+#define SCB_AIRCR_VECTKEY_Msk          (0xFFFFUL << SCB_AIRCR_VECTKEY_Pos)
+#define SCB_AIRCR_SYSRESETREQ_Pos      2U
+#define SCB_AIRCR_SYSRESETREQ_Msk      (1UL << SCB_AIRCR_SYSRESETREQ_Pos)
+
+#define SCB_SCR_SEVONPEND_Pos          4U
+#define SCB_SCR_SEVONPEND_Msk          (1UL << SCB_SCR_SEVONPEND_Pos)
+#define SCB_SCR_SLEEPDEEP_Pos          2U
+#define SCB_SCR_SLEEPDEEP_Msk          (1UL << SCB_SCR_SLEEPDEEP_Pos)
+#define SCB_SCR_SLEEPONEXIT_Pos        1U
+#define SCB_SCR_SLEEPONEXIT_Msk        (1UL << SCB_SCR_SLEEPONEXIT_Pos)
+
+#define SysTick_CTRL_COUNTFLAG_Msk     (1UL << 16U)
+#define SysTick_CTRL_CLKSOURCE_Msk     (1UL << 2U)
+#define SysTick_CTRL_TICKINT_Msk       (1UL << 1U)
+#define SysTick_CTRL_ENABLE_Msk        (1UL)
+#define SysTick_LOAD_RELOAD_Msk        (0xFFFFFFUL)
+
+extern NVIC_Type    simNVIC;
+extern SCB_Type     simSCB;
+extern SysTick_Type simSysTick;
+
+#define NVIC     (&simNVIC)
+#define SCB      (&simSCB)
+#define SysTick  (&simSysTick)
+
+/*******************************************************************************
+ ******************************   INTRINSICS   *********************************
+ ******************************************************************************/
+
+__STATIC_INLINE void __enable_irq(void)   { simPrimaskSet(0U); }
+__STATIC_INLINE void __disable_irq(void)  { simPrimaskSet(1U); }
+__STATIC_INLINE uint32_t __get_PRIMASK(void) { return simPrimaskGet(); }
+__STATIC_INLINE void __set_PRIMASK(uint32_t priMask) { simPrimaskSet(priMask & 1U); }
+
+__STATIC_INLINE void __WFI(void) { simWfi(); }
+__STATIC_INLINE void __WFE(void) { simWfi(); }
+__STATIC_INLINE void __SEV(void) { }
+__STATIC_INLINE void __NOP(void) { __asm volatile ("nop"); }
+__STATIC_INLINE void __ISB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __DSB(void) { __sync_synchronize(); }
+__STATIC_INLINE void __DMB(void) { __sync_synchronize(); }
+
+__STATIC_INLINE uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+__STATIC_INLINE uint32_t __REV16(uint32_t value)
+{
+  return ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8);
+}
+__STATIC_INLINE uint32_t __RBIT(uint32_t value)
+{
+  uint32_t result = 0;
+  int i;
+
+  for (i = 0; i < 32; i++) {
+    result = (result << 1) | (value & 1U);
+    value >>= 1;
+  }
+  return result;
+}
+__STATIC_INLINE uint8_t __CLZ(uint32_t value)
+{
+  return value ? (uint8_t)__builtin_clz(value) : 32U;
+}
+
+/*******************************************************************************
+ ******************************   NVIC FUNCTIONS   *****************************
+ ******************************************************************************/
+
+__STATIC_INLINE void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  if ((int32_t)IRQn >= 0) {
+    NVIC->ISER[0U] = 1UL << ((uint32_t)IRQn & 0x1FUL);
+    simNvicUpdate();
+  }
+}
+
+__STATIC_INLINE void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  if ((int32_t)IRQn >= 0) {
+    NVIC->ICER[0U] = 1UL << ((uint32_t)IRQn & 0x1FUL);
+    simNvicUpdate();
+  }
+}
+
+__STATIC_INLINE uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+  simNvicUpdate();
+  return ((int32_t)IRQn >= 0) ? ((NVIC->ISER[0U] >> ((uint32_t)IRQn & 0x1FUL)) & 1UL) : 0U;
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+  simNvicUpdate();
+  return ((int32_t)IRQn >= 0) ? ((NVIC->ISPR[0U] >> ((uint32_t)IRQn & 0x1FUL)) & 1UL) : 0U;
+}
+
+__STATIC_INLINE void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+  if ((int32_t)IRQn >= 0) {
+    NVIC->ISPR[0U] = 1UL << ((uint32_t)IRQn & 0x1FUL);
+    simNvicUpdate();
+  }
+}
+
+__STATIC_INLINE void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+  if ((int32_t)IRQn >= 0) {
+    NVIC->ICPR[0U] = 1UL << ((uint32_t)IRQn & 0x1FUL);
+    simNvicUpdate();
+  }
+}
+
+__STATIC_INLINE void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+  simNvicPrioritySet((int)IRQn, priority & ((1UL << __NVIC_PRIO_BITS) - 1UL));
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPriority(IRQn_Type IRQn)
+{
+  return simNvicPriorityGet((int)IRQn);
+}
+
+__STATIC_INLINE void NVIC_SystemReset(void)
+{
+  simSystemReset();
+  for (;;) {
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_CORE_CM0PLUS_H */
@@ -0,0 +1,37 @@
+/**************************************************************************//**
+ * @file display.h
+ * @brief Host simulation stand-in for the kit display driver.
+ *
+ * The memory LCD is not modelled, text and drawing go to stdout. Init does
+ * take the RTC over for the 64 Hz EXTCOMIN PRS pulses like the real driver,
+ * other code (Ex3) counts those; see displayconfig.h.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_DISPLAY_H
+#define HOSTSIM_DISPLAY_H
+
+#include <stdint.h>
+#include "bspconfig.h"
+
+typedef uint32_t EMSTATUS;
+
+#define DISPLAY_EMSTATUS_OK              (0)
+#define DISPLAY_EMSTATUS_INVALID_PARAM   (1)
+
+#define DISPLAY_GEOMETRY_WIDTH           128
+#define DISPLAY_GEOMETRY_HEIGHT          128
+
+typedef struct {
+  unsigned int width;
+  unsigned int height;
+} DISPLAY_Geometry_t;
+
+typedef struct {
+  const char          *name;
+  DISPLAY_Geometry_t  geometry;
+} DISPLAY_Device_t;
+
+EMSTATUS DISPLAY_Init(void);
+EMSTATUS DISPLAY_DeviceGet(int displayDeviceNo, DISPLAY_Device_t *device);
+
+#endif /* HOSTSIM_DISPLAY_H */
@@ -0,0 +1,31 @@
+/**************************************************************************//**
+ * @file displayconfig.h
+ * @brief Host simulation stand-in for the SLSTK3400A display configuration.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_DISPLAYCONFIG_H
+#define HOSTSIM_DISPLAYCONFIG_H
+
+#include "bspconfig.h"
+
+/* Memory LCD SPI on USART0, chip select driven as GPIO */
+#define PAL_SPI_USART_UNIT      USART0
+#define PAL_SPI_USART_CLOCK     cmuClock_USART0
+#define PAL_SPI_BAUDRATE        1000000
+
+#define LCD_PORT_SCS            gpioPortA
+#define LCD_PIN_SCS             10
+
+/* EXTCOMIN polarity inversion. As on the kit the PAL toggles it from RTC
+ * COMP0 through PRS, unless the project gives PAL_TIMER_REPEAT_FUNCTION to
+ * call the driver's toggle function itself. */
+#define LCD_PORT_EXTCOMIN       gpioPortF
+#define LCD_PIN_EXTCOMIN        3
+
+#define LS013B7DH03_POLARITY_INVERSION_FREQUENCY  LCD_AUTO_TOGGLE_HZ
+
+#ifndef PAL_TIMER_REPEAT_FUNCTION
+#define POLARITY_INVERSION_EXTCOMIN_PAL_AUTO_TOGGLE
+#endif
+
+#endif /* HOSTSIM_DISPLAYCONFIG_H */
@@ -0,0 +1,20 @@
+/**************************************************************************//**
+ * @file displaypal.h
+ * @brief Host simulation stand-in for the display platform abstraction.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_DISPLAYPAL_H
+#define HOSTSIM_DISPLAYPAL_H
+
+#include "display.h"
+
+/* Returns at once, microsecond delays take no virtual time */
+EMSTATUS PAL_TimerMicroSecondsDelay(unsigned int usecs);
+
+#ifdef PAL_TIMER_REPEAT_FUNCTION
+/* Provided by the project, calls pFunction at about frequency Hz */
+int PAL_TIMER_REPEAT_FUNCTION(void (*pFunction)(void *), void *argument,
+                              unsigned int frequency);
+#endif
+
+#endif /* HOSTSIM_DISPLAYPAL_H */
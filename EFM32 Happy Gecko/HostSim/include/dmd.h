@@ -0,0 +1,16 @@
+/**************************************************************************//**
+ * @file dmd.h
+ * @brief Host simulation stand-in for the GLIB dot matrix display driver.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_DMD_H
+#define HOSTSIM_DMD_H
+
+#include "display.h"
+
+#define DMD_OK   (0)
+
+EMSTATUS DMD_init(void *initData);
+EMSTATUS DMD_updateDisplay(void);
+
+#endif /* HOSTSIM_DMD_H */
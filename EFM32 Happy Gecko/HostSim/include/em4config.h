@@ -0,0 +1,17 @@
+/**************************************************************************//**
+ * @file em4config.h
+ * @brief Host simulation stand-in for the SLSTK3400A EM4 example config.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_EM4CONFIG_H
+#define HOSTSIM_EM4CONFIG_H
+
+#include "bspconfig.h"
+
+/* PB0 (PC9) can wake from EM4, PB1 (PC10) can not */
+#define EM4_WU_PB_PORT       BSP_GPIO_PB0_PORT
+#define EM4_WU_PB_PIN        BSP_GPIO_PB0_PIN
+#define EM4_NON_WU_PB_PORT   BSP_GPIO_PB1_PORT
+#define EM4_NON_WU_PB_PIN    BSP_GPIO_PB1_PIN
+
+#endif /* HOSTSIM_EM4CONFIG_H */
@@ -0,0 +1,74 @@
+/**************************************************************************//**
+ * @file em_device.h
+ * @brief Host simulation wrapper around the SDK em_device.h.
+ *
+ * Pulls in the real device header (register layouts, bit fields, IRQ numbers)
+ * and then points the peripheral base macros at the simulator's register
+ * blocks. Peripherals that are not modelled keep their hardware address and
+ * fault when touched, which is what we want to notice.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_EM_DEVICE_H
+#define HOSTSIM_EM_DEVICE_H
+
+#include_next <em_device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CMU_TypeDef      simCMU;
+extern EMU_TypeDef      simEMU;
+extern MSC_TypeDef      simMSC;
+extern GPIO_TypeDef     simGPIO;
+extern TIMER_TypeDef    simTIMER[TIMER_COUNT];
+extern RTC_TypeDef      simRTC;
+extern DMA_TypeDef      simDMA;
+extern PRS_TypeDef      simPRS;
+extern PCNT_TypeDef     simPCNT0;
+extern USART_TypeDef    simUSART0;
+extern USART_TypeDef    simUSART1;
+extern ACMP_TypeDef     simACMP0;
+extern DEVINFO_TypeDef  simDEVINFO;
+extern ROMTABLE_TypeDef simROMTABLE;
+
+#undef CMU
+#define CMU       (&simCMU)
+#undef EMU
+#define EMU       (&simEMU)
+#undef MSC
+#define MSC       (&simMSC)
+#undef GPIO
+#define GPIO      (&simGPIO)
+#undef TIMER0
+#define TIMER0    (&simTIMER[0])
+#undef TIMER1
+#define TIMER1    (&simTIMER[1])
+#if TIMER_COUNT > 2
+#undef TIMER2
+#define TIMER2    (&simTIMER[2])
+#endif
+#undef RTC
+#define RTC       (&simRTC)
+#undef DMA
+#define DMA       (&simDMA)
+#undef PRS
+#define PRS       (&simPRS)
+#undef PCNT0
+#define PCNT0     (&simPCNT0)
+#undef USART0
+#define USART0    (&simUSART0)
+#undef USART1
+#define USART1    (&simUSART1)
+#undef ACMP0
+#define ACMP0     (&simACMP0)
+#undef DEVINFO
+#define DEVINFO   (&simDEVINFO)
+#undef ROMTABLE
+#define ROMTABLE  (&simROMTABLE)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_EM_DEVICE_H */
@@ -0,0 +1,40 @@
+/**************************************************************************//**
+ * @file glib.h
+ * @brief Host simulation stand-in for GLIB, strings are printed to stdout.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_GLIB_H
+#define HOSTSIM_GLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dmd.h"
+
+#define GLIB_OK   (0)
+
+#define White     0xFFFFFFUL
+#define Black     0x000000UL
+
+typedef struct {
+  const char  *name;
+  uint16_t    fontWidth;
+  uint16_t    fontHeight;
+} GLIB_Font_t;
+
+typedef struct {
+  uint32_t            foregroundColor;
+  uint32_t            backgroundColor;
+  const GLIB_Font_t   *font;
+} GLIB_Context_t;
+
+extern const GLIB_Font_t GLIB_FontNormal8x8;
+extern const GLIB_Font_t GLIB_FontNarrow6x8;
+extern const GLIB_Font_t GLIB_FontNumber16x20;
+
+EMSTATUS GLIB_contextInit(GLIB_Context_t *pContext);
+EMSTATUS GLIB_setFont(GLIB_Context_t *pContext, GLIB_Font_t *pFont);
+EMSTATUS GLIB_clear(GLIB_Context_t *pContext);
+EMSTATUS GLIB_drawString(GLIB_Context_t *pContext, const char *pString,
+                         uint32_t sLength, int32_t x0, int32_t y0, bool opaque);
+
+#endif /* HOSTSIM_GLIB_H */
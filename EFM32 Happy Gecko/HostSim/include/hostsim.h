@@ -0,0 +1,72 @@
+/**************************************************************************//**
+ * @file hostsim.h
+ * @brief Host simulation of the EFM32 Happy Gecko peripherals used by the
+ *        SimplicityStudio examples.
+ *
+ * The examples are built natively against the real emlib and device headers.
+ * em_device.h and core_cm0plus.h in this directory shadow the SDK ones so the
+ * peripheral pointers (CMU, GPIO, TIMER0, ...) point at memory blocks owned by
+ * the simulator. A simulator thread runs the peripherals in virtual time and
+ * raises their interrupts on the application thread, where the normal
+ * *_IRQHandler functions are called.
+ *
+ * Virtual time is counted in HFCLK cycles. While the core sleeps (__WFI) time
+ * jumps straight to the next peripheral event, while it runs time follows the
+ * host clock (HOSTSIM_EM0_SCALE can stretch that). HOSTSIM is defined for
+ * the example sources, for the few places that measure with the model.
+ *
+ * Environment:
+ *   HOSTSIM_TIME      virtual seconds to run, default 10
+ *   HOSTSIM_STIMULUS  file with "<ms> <port><pin> <0|1>" lines driving inputs
+ *   HOSTSIM_EM0_SCALE virtual cycles per host cycle while running, default 1
+ *   HOSTSIM_QUIET     no report at exit when set
+ *****************************************************************************/
+
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Called for every change of a pin level or timer output, see simTraceSet() */
+typedef void (*simTraceFn)(uint64_t cycle, const char *signal, int level);
+
+uint64_t simCyclesGet(void);
+uint32_t simHfClockGet(void);
+double simSecondsGet(void);
+
+/* Inputs */
+void simGpioDrive(unsigned port, unsigned pin, int level);
+void simGpioRelease(unsigned port, unsigned pin);
+void simGpioSchedule(double seconds, unsigned port, unsigned pin, int level);
+void simPrsPulseSource(unsigned ch, uint32_t hz);
+
+/* Outputs */
+int simGpioLevel(unsigned port, unsigned pin);
+int simTimerOutput(unsigned timer, unsigned cc);
+uint32_t simPinToggles(unsigned port, unsigned pin);
+uint64_t simDmaBusCycles(unsigned ch);
+void simTraceSet(simTraceFn fn);
+
+/* Run control */
+void simSync(void);
+void simStop(int status);
+void simReport(FILE *out);
+
+/** Hook a scenario can define to schedule stimuli before main() starts */
+void simScenario(void);
+
+/** Hook a scenario can define to judge the run at the end, after the report;
+ *  a nonzero return becomes the exit status */
+int simScenarioCheck(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOSTSIM_H */
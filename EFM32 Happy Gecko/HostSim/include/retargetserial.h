@@ -0,0 +1,12 @@
+/**************************************************************************//**
+ * @file retargetserial.h
+ * @brief Host simulation stand-in, printf already goes to stdout.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_RETARGETSERIAL_H
+#define HOSTSIM_RETARGETSERIAL_H
+
+void RETARGET_SerialInit(void);
+void RETARGET_SerialCrLf(int on);
+
+#endif /* HOSTSIM_RETARGETSERIAL_H */
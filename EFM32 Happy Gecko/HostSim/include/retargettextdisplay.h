@@ -0,0 +1,13 @@
+/**************************************************************************//**
+ * @file retargettextdisplay.h
+ * @brief Host simulation stand-in, printf already goes to stdout.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_RETARGETTEXTDISPLAY_H
+#define HOSTSIM_RETARGETTEXTDISPLAY_H
+
+#include "textdisplay.h"
+
+EMSTATUS RETARGET_TextDisplayInit(void);
+
+#endif /* HOSTSIM_RETARGETTEXTDISPLAY_H */
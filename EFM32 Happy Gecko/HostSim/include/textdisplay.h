@@ -0,0 +1,13 @@
+/**************************************************************************//**
+ * @file textdisplay.h
+ * @brief Host simulation stand-in for the kit text display driver.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_TEXTDISPLAY_H
+#define HOSTSIM_TEXTDISPLAY_H
+
+#include "display.h"
+
+#define TEXTDISPLAY_EMSTATUS_OK   (0)
+
+#endif /* HOSTSIM_TEXTDISPLAY_H */
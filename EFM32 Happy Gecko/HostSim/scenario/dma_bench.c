@@ -0,0 +1,113 @@
+/**************************************************************************//**
+ * @file dma_bench.c
+ * @brief Cycle check of the DmaBench example against its reference CSV
+ *
+ *   make SDK=... EX=DmaBench SCENARIO=scenario/dma_bench.c
+ *   ./build/DmaBench/DmaBench
+ *
+ * Reads the cycles column of the reference (DMABENCH_REFERENCE, default
+ * ../SimplicityStudio/DmaBench/dmabench_hostsim.csv) and fails the run when
+ *   - a run in the reference has other cycles in dmaBenchCycles,
+ *   - the reference does not cover every run of the matrix.
+ * The cycles are the DMA model's bus cycle estimate, so a difference means
+ * em_dma programs the controller differently. After an intended change the
+ * reference is recorded again with
+ *
+ *   HOSTSIM_QUIET=1 ./build/DmaBench/DmaBench | grep -v '^dma bench:' \
+ *     > ../SimplicityStudio/DmaBench/dmabench_hostsim.csv
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostsim.h"
+
+#define REFERENCE     "../SimplicityStudio/DmaBench/dmabench_hostsim.csv"
+
+/* Matrix of dma_bench.c, [flash][mode][size][arbitration] */
+#define SOURCES       2
+#define MODES         4
+#define DATA_SIZES    3
+#define ARB_RATES     11
+#define RUNS          (SOURCES * MODES * DATA_SIZES * ARB_RATES)
+
+extern uint32_t dmaBenchCycles[SOURCES][MODES][DATA_SIZES][ARB_RATES];
+
+static const char *const modeName[MODES] = { "auto", "basic", "pingpong", "sg" };
+
+/* Exponent of a power of two, -1 for anything else */
+static int log2Exact(unsigned value, int max)
+{
+  int n;
+
+  for (n = 0; n <= max; n++) {
+    if (value == 1U << n) {
+      return n;
+    }
+  }
+  return -1;
+}
+
+static int modeIndex(const char *name)
+{
+  int mode;
+
+  for (mode = 0; mode < MODES; mode++) {
+    if (strcmp(name, modeName[mode]) == 0) {
+      return mode;
+    }
+  }
+  return -1;
+}
+
+int simScenarioCheck(void)
+{
+  const char *path = getenv("DMABENCH_REFERENCE");
+  char line[160], mode[16], src[8];
+  unsigned size, arb;
+  unsigned long cycles, runs = 0, mismatches = 0;
+  int m, s, a, f;
+  uint32_t got;
+  FILE *ref;
+  bool ok;
+
+  if (path == NULL) {
+    path = REFERENCE;
+  }
+  ref = fopen(path, "r");
+  if (ref == NULL) {
+    printf("dma bench: no reference %s\n", path);
+    printf("dma bench: FAIL\n");
+    return 1;
+  }
+
+  while (fgets(line, sizeof(line), ref) != NULL) {
+    if (sscanf(line, "%15[^,],%u,%u,%7[^,],%*u,%*u,%lu", mode, &size, &arb, src, &cycles) != 5) {
+      continue;                 /* Comment or header */
+    }
+    m = modeIndex(mode);
+    s = log2Exact(size, DATA_SIZES - 1);
+    a = log2Exact(arb, ARB_RATES - 1);
+    f = strcmp(src, "flash") == 0 ? 1 : (strcmp(src, "ram") == 0 ? 0 : -1);
+    if (m < 0 || s < 0 || a < 0 || f < 0) {
+      fprintf(stderr, "dma bench: unknown run in reference: %s", line);
+      mismatches++;
+      continue;
+    }
+    runs++;
+    got = dmaBenchCycles[f][m][s][a];
+    if (got != cycles) {
+      if (mismatches++ < 8) {
+        fprintf(stderr, "dma bench: %s size %u arb %u %s %lu cycles, reference %lu\n",
+                mode, size, arb, src, (unsigned long)got, cycles);
+      }
+    }
+  }
+  fclose(ref);
+
+  ok = mismatches == 0 && runs == RUNS;
+  printf("dma bench: %lu/%u runs in %s, %lu differ\n", runs, RUNS, path, mismatches);
+  printf("dma bench: %s\n", ok ? "PASS" : "FAIL");
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/**************************************************************************//**
+ * @file half_bridge.c
+ * @brief Waveform check of the HalfBridge example
+ *
+ *   make SDK=... EX=HalfBridge SCENARIO=scenario/half_bridge.c
+ *   HOSTSIM_TIME=1 ./build/HalfBridge/HalfBridge
+ *
+ * Follows the TIMER0 output pairs 0 and 1 in the trace and fails the run
+ * when
+ *   - the high and low side of a pair are on at the same time,
+ *   - one side turns on less than the dead time after the other turned off,
+ *   - a pulse differs from its compare value: center aligned, the high side
+ *     is on for 2 * CCV counts less the rise time and the low side for
+ *     2 * (TOP - CCV) counts less the fall time (pulses that span a CCV
+ *     update are skipped),
+ *   - a gate turns on while the fault input PC0 is high,
+ *   - the bridge does not run again once the fault is gone.
+ * The outputs are taken as active high.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "em_device.h"
+#include "hostsim.h"
+
+#define PAIRS         2
+#define HIGH          0
+#define LOW           1
+
+#define FAULT_PORT    2         /* PC0 */
+#define FAULT_PIN     0
+#define FAULT_START   0.25
+#define FAULT_END     0.26
+
+struct side {
+  int           on;
+  uint64_t      onAt, offAt;
+  uint32_t      ccvAtOn;
+  bool          skipWidth;      /* pulse started by enable or fault recovery */
+  unsigned long pulses, widthErrors;
+};
+
+struct pair {
+  struct side   side[2];
+  unsigned long overlaps, shortDead;
+  uint64_t      minDead;
+};
+
+static struct pair pairs[PAIRS];
+static bool fault;
+static uint64_t faultAt;
+static unsigned long faultLeaks, pulsesAfterFault;
+
+static uint64_t tickCycles(void)
+{
+  return (uint64_t)1 << (((TIMER0->CTRL & _TIMER_CTRL_PRESC_MASK) >> _TIMER_CTRL_PRESC_SHIFT)
+                         + ((CMU->HFPERCLKDIV & _CMU_HFPERCLKDIV_HFPERCLKDIV_MASK)
+                            >> _CMU_HFPERCLKDIV_HFPERCLKDIV_SHIFT));
+}
+
+/* Dead time before the high side (rise) or the low side (fall) turns on */
+static uint64_t deadCycles(unsigned s)
+{
+  uint32_t dttime = TIMER0->DTTIME;
+  uint32_t n = s == HIGH
+               ? (dttime & _TIMER_DTTIME_DTRISET_MASK) >> _TIMER_DTTIME_DTRISET_SHIFT
+               : (dttime & _TIMER_DTTIME_DTFALLT_MASK) >> _TIMER_DTTIME_DTFALLT_SHIFT;
+
+  return (uint64_t)(n + 1) << (((dttime & _TIMER_DTTIME_DTPRESC_MASK) >> _TIMER_DTTIME_DTPRESC_SHIFT)
+                               + ((CMU->HFPERCLKDIV & _CMU_HFPERCLKDIV_HFPERCLKDIV_MASK)
+                                  >> _CMU_HFPERCLKDIV_HFPERCLKDIV_SHIFT));
+}
+
+static uint64_t expectedWidth(unsigned s, uint32_t ccv)
+{
+  uint32_t counts = s == HIGH ? ccv : (TIMER0->TOP & 0xFFFFU) - ccv;
+
+  return 2 * counts * tickCycles() - deadCycles(s);
+}
+
+static void sideChanged(unsigned cc, unsigned s, uint64_t cycle, int level)
+{
+  struct pair *p = &pairs[cc];
+  struct side *d = &p->side[s];
+  struct side *other = &p->side[!s];
+  uint32_t ccv = TIMER0->CC[cc].CCV & 0xFFFFU;
+  uint64_t gap;
+
+  if (level < 0 || level == d->on) {
+    return;
+  }
+  d->on = level;
+
+  if (level) {
+    d->onAt = cycle;
+    d->ccvAtOn = ccv;
+    if (other->on) {
+      p->overlaps++;
+    }
+    if (other->offAt) {
+      gap = cycle - other->offAt;
+      if (gap < p->minDead || p->minDead == 0) {
+        p->minDead = gap;
+      }
+      if (gap < deadCycles(s)) {
+        p->shortDead++;
+      }
+    }
+    if (fault && cycle > faultAt) {
+      faultLeaks++;
+    }
+    return;
+  }
+
+  d->offAt = cycle;
+  d->pulses++;
+  if (faultAt && !fault) {
+    pulsesAfterFault++;
+  }
+  if (!d->skipWidth && ccv == d->ccvAtOn
+      && cycle - d->onAt != expectedWidth(s, ccv)) {
+    if (d->widthErrors++ == 0) {
+      fprintf(stderr, "half bridge: pair %u %s side on %llu cycles, expected %llu\n",
+              cc, s == HIGH ? "high" : "low", (unsigned long long)(cycle - d->onAt),
+              (unsigned long long)expectedWidth(s, ccv));
+    }
+  }
+  d->skipWidth = false;
+}
+
+static void trace(uint64_t cycle, const char *signal, int level)
+{
+  unsigned cc, s;
+
+  if (strcmp(signal, "PC0") == 0) {
+    fault = level > 0;
+    if (fault) {
+      faultAt = cycle;
+      for (cc = 0; cc < PAIRS; cc++) {
+        for (s = 0; s < 2; s++) {
+          pairs[cc].side[s].skipWidth = true;
+        }
+      }
+    }
+    return;
+  }
+  if (sscanf(signal, "TIMER0.CDTI%u", &cc) == 1) {
+    s = LOW;
+  } else if (sscanf(signal, "TIMER0.CC%u", &cc) == 1) {
+    s = HIGH;
+  } else {
+    return;
+  }
+  if (cc < PAIRS) {
+    sideChanged(cc, s, cycle, level);
+  }
+}
+
+void simScenario(void)
+{
+  unsigned cc;
+
+  for (cc = 0; cc < PAIRS; cc++) {
+    pairs[cc].side[HIGH].skipWidth = true;
+    pairs[cc].side[LOW].skipWidth = true;
+  }
+  simTraceSet(trace);
+  simGpioSchedule(FAULT_START, FAULT_PORT, FAULT_PIN, 1);
+  simGpioSchedule(FAULT_END, FAULT_PORT, FAULT_PIN, -1);
+}
+
+int simScenarioCheck(void)
+{
+  const struct pair *p;
+  bool ok = faultLeaks == 0 && pulsesAfterFault > 0;
+  unsigned cc;
+
+  for (cc = 0; cc < PAIRS; cc++) {
+    p = &pairs[cc];
+    printf("half bridge: pair %u %lu high %lu low pulses, min dead time %llu/%llu cycles, "
+           "%lu overlaps, %lu short dead times, %lu/%lu width errors\n",
+           cc, p->side[HIGH].pulses, p->side[LOW].pulses,
+           (unsigned long long)p->minDead, (unsigned long long)deadCycles(HIGH),
+           p->overlaps, p->shortDead,
+           p->side[HIGH].widthErrors, p->side[LOW].widthErrors);
+    ok = ok && p->side[HIGH].pulses && p->side[LOW].pulses && !p->overlaps && !p->shortDead
+         && !p->side[HIGH].widthErrors && !p->side[LOW].widthErrors;
+  }
+  printf("half bridge: %lu gate pulses during the fault, %lu after it\n",
+         faultLeaks, pulsesAfterFault);
+  printf("half bridge: %s\n", ok ? "PASS" : "FAIL");
+
+  return ok ? 0 : 1;
+}
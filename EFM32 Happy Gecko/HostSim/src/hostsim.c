@@ -0,0 +1,771 @@
+/**************************************************************************//**
+ * @file hostsim.c
+ * @brief Simulator core: virtual time, NVIC and interrupt dispatch.
+ *
+ * Two host threads are involved. The application thread runs main() of the
+ * example (renamed to simAppMain by the build) and the interrupt handlers.
+ * The simulator thread owns virtual time and runs the peripheral models.
+ *
+ * When an enabled interrupt becomes pending while the application runs, the
+ * simulator thread sends it SIGUSR1 and the handler is called from the signal
+ * handler, so it preempts main() like on the chip. A higher priority
+ * interrupt preempts a running handler the same way. While the application
+ * waits in __WFI the simulator skips directly from event to event.
+ *****************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "hostsim_internal.h"
+
+/* Register blocks without a model: plain memory */
+EMU_TypeDef      simEMU;
+MSC_TypeDef      simMSC;
+ACMP_TypeDef     simACMP0;
+DEVINFO_TypeDef  simDEVINFO;
+ROMTABLE_TypeDef simROMTABLE;
+
+NVIC_Type    simNVIC;
+SCB_Type     simSCB;
+SysTick_Type simSysTick;
+
+/* Names the build gives to the example's main() */
+extern int simAppMain(void);
+void simScenario(void) __attribute__((weak));
+int simScenarioCheck(void) __attribute__((weak));
+
+/*******************************************************************************
+ ***************************   VECTOR TABLE   **********************************
+ ******************************************************************************/
+
+#define SIM_HANDLER(name)  extern void name(void) __attribute__((weak));
+SIM_HANDLER(PendSV_Handler)
+SIM_HANDLER(SysTick_Handler)
+SIM_HANDLER(DMA_IRQHandler)
+SIM_HANDLER(GPIO_EVEN_IRQHandler)
+SIM_HANDLER(TIMER0_IRQHandler)
+SIM_HANDLER(ACMP0_IRQHandler)
+SIM_HANDLER(ADC0_IRQHandler)
+SIM_HANDLER(I2C0_IRQHandler)
+SIM_HANDLER(GPIO_ODD_IRQHandler)
+SIM_HANDLER(TIMER1_IRQHandler)
+SIM_HANDLER(USART1_RX_IRQHandler)
+SIM_HANDLER(USART1_TX_IRQHandler)
+SIM_HANDLER(LEUART0_IRQHandler)
+SIM_HANDLER(PCNT0_IRQHandler)
+SIM_HANDLER(RTC_IRQHandler)
+SIM_HANDLER(CMU_IRQHandler)
+SIM_HANDLER(VCMP_IRQHandler)
+SIM_HANDLER(MSC_IRQHandler)
+SIM_HANDLER(AES_IRQHandler)
+SIM_HANDLER(USART0_RX_IRQHandler)
+SIM_HANDLER(USART0_TX_IRQHandler)
+SIM_HANDLER(USB_IRQHandler)
+SIM_HANDLER(TIMER2_IRQHandler)
+
+struct simVector {
+  int           irq;
+  void          (*handler)(void);
+  const char    *name;
+  unsigned long calls;
+  uint64_t      cycles;
+  uint64_t      latency;
+  uint64_t      pendedAt;
+};
+
+#define SIM_VECTOR(n)  { n##_IRQn, n##_IRQHandler, #n, 0, 0, 0, 0 }
+
+static struct simVector vectors[] = {
+  { PendSV_IRQn, PendSV_Handler, "PendSV", 0, 0, 0, 0 },
+  { SysTick_IRQn, SysTick_Handler, "SysTick", 0, 0, 0, 0 },
+  SIM_VECTOR(DMA),
+  SIM_VECTOR(GPIO_EVEN),
+  SIM_VECTOR(TIMER0),
+  SIM_VECTOR(ACMP0),
+  SIM_VECTOR(ADC0),
+  SIM_VECTOR(I2C0),
+  SIM_VECTOR(GPIO_ODD),
+  SIM_VECTOR(TIMER1),
+  SIM_VECTOR(USART1_RX),
+  SIM_VECTOR(USART1_TX),
+  SIM_VECTOR(LEUART0),
+  SIM_VECTOR(PCNT0),
+  SIM_VECTOR(RTC),
+  SIM_VECTOR(CMU),
+  SIM_VECTOR(VCMP),
+  SIM_VECTOR(MSC),
+  SIM_VECTOR(AES),
+  SIM_VECTOR(USART0_RX),
+  SIM_VECTOR(USART0_TX),
+  SIM_VECTOR(USB),
+  SIM_VECTOR(TIMER2),
+};
+
+#define VECTOR_COUNT  (sizeof(vectors) / sizeof(vectors[0]))
+
+/* Level interrupt lines of the modelled peripherals, pending while IF & IEN */
+struct simLine {
+  int               irq;
+  volatile uint32_t *flags;
+  volatile uint32_t *enable;
+  uint32_t          mask;
+};
+
+static const struct simLine lines[] = {
+  { DMA_IRQn,       &simDMA.IF,      &simDMA.IEN,      0xFFFFFFFFUL },
+  { GPIO_EVEN_IRQn, &simGPIO.IF,     &simGPIO.IEN,     0x00005555UL },
+  { GPIO_ODD_IRQn,  &simGPIO.IF,     &simGPIO.IEN,     0x0000AAAAUL },
+  { TIMER0_IRQn,    &simTIMER[0].IF, &simTIMER[0].IEN, 0xFFFFFFFFUL },
+  { TIMER1_IRQn,    &simTIMER[1].IF, &simTIMER[1].IEN, 0xFFFFFFFFUL },
+#if TIMER_COUNT > 2
+  { TIMER2_IRQn,    &simTIMER[2].IF, &simTIMER[2].IEN, 0xFFFFFFFFUL },
+#endif
+  { RTC_IRQn,       &simRTC.IF,      &simRTC.IEN,      0xFFFFFFFFUL },
+  { PCNT0_IRQn,     &simPCNT0.IF,    &simPCNT0.IEN,    0xFFFFFFFFUL },
+  { CMU_IRQn,       &simCMU.IF,      &simCMU.IEN,      0xFFFFFFFFUL },
+  { USART0_TX_IRQn, &simUSART0.IF,   &simUSART0.IEN,   USART_IF_TXC | USART_IF_TXBL | USART_IF_TXOF },
+  { USART1_TX_IRQn, &simUSART1.IF,   &simUSART1.IEN,   USART_IF_TXC | USART_IF_TXBL | USART_IF_TXOF },
+};
+
+static const struct simModel *const models[] = {
+  &simCmuModel,
+  &simGpioModel,
+  &simPrsModel,
+  &simRtcModel,
+  &simTimerModel,
+  &simPcntModel,
+  &simDmaModel,
+  &simUsartModel,
+};
+
+#define MODEL_COUNT  (sizeof(models) / sizeof(models[0]))
+
+/*******************************************************************************
+ ***************************   STATE   *****************************************
+ ******************************************************************************/
+
+enum simCpu { CPU_EM0, CPU_EM1, CPU_EM2 };
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  wake = PTHREAD_COND_INITIALIZER;
+static pthread_t       appThread;
+static pthread_t       simThread;
+
+uint64_t simNow;
+double simSeconds;
+
+static uint64_t endCycles = SIM_NEVER;
+static double endSeconds = 10.0;
+static double em0Scale = 1.0;
+static int exitStatus;
+static bool quiet;
+static struct timespec hostStart;
+
+static enum simCpu cpu = CPU_EM0;
+static uint64_t emCycles[3];
+static unsigned long wakeups;
+
+static uint32_t nvicEnabled;
+static uint32_t nvicPending;
+static uint32_t softPending;
+static bool pendSV;
+static bool pendST;
+static uint8_t priority[34];          /* index irq + 2, PendSV is -2 */
+static uint32_t primask;
+static uint32_t execPriority = 256;   /* thread mode */
+static volatile sig_atomic_t signalled;
+
+static simTraceFn traceFn;
+
+/*******************************************************************************
+ ***************************   LOCKING   ***************************************
+ ******************************************************************************/
+
+/* The application thread blocks SIGUSR1 while it holds the lock, an
+ * interrupt must not try to take it again from the signal handler. */
+static void simEnter(sigset_t *old)
+{
+  sigset_t set;
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &set, old);
+  pthread_mutex_lock(&lock);
+}
+
+static void simLeave(const sigset_t *old)
+{
+  pthread_mutex_unlock(&lock);
+  pthread_sigmask(SIG_SETMASK, old, NULL);
+}
+
+static __thread sigset_t apiMask;
+
+void simApiLock(void)
+{
+  simEnter(&apiMask);
+}
+
+void simApiUnlock(void)
+{
+  simLeave(&apiMask);
+}
+
+/*******************************************************************************
+ ***************************   NVIC   ******************************************
+ ******************************************************************************/
+
+static uint32_t vectorPriority(const struct simVector *v)
+{
+  return priority[v->irq + 2];
+}
+
+static bool vectorPending(const struct simVector *v)
+{
+  if (v->irq == PendSV_IRQn) {
+    return pendSV;
+  }
+  if (v->irq == SysTick_IRQn) {
+    return pendST;
+  }
+  return (nvicPending & nvicEnabled & (1UL << v->irq)) != 0;
+}
+
+static void vectorClear(const struct simVector *v)
+{
+  if (v->irq == PendSV_IRQn) {
+    pendSV = false;
+  } else if (v->irq == SysTick_IRQn) {
+    pendST = false;
+  } else {
+    nvicPending &= ~(1UL << v->irq);
+    softPending &= ~(1UL << v->irq);
+    __atomic_and_fetch(&simNVIC.ISPR[0], ~(1UL << v->irq), __ATOMIC_SEQ_CST);
+  }
+}
+
+static void vectorPended(int irq)
+{
+  size_t i;
+
+  for (i = 0; i < VECTOR_COUNT; i++) {
+    if (vectors[i].irq == irq) {
+      vectors[i].pendedAt = simNow;
+    }
+  }
+}
+
+static void simNvicSyncLocked(void)
+{
+  uint32_t seen, clear, icsr, aircr;
+  int irq;
+
+  /* ISER/ISPR always read back the state, the application only adds bits */
+  nvicEnabled |= simNVIC.ISER[0];
+  clear = simTake(&simNVIC.ICER[0]);
+  nvicEnabled &= ~clear;
+  __atomic_and_fetch(&simNVIC.ISER[0], ~clear, __ATOMIC_SEQ_CST);
+
+  seen = simNVIC.ISPR[0];
+  for (irq = 0; irq < 32; irq++) {
+    if ((seen & ~nvicPending) & (1UL << irq)) {
+      vectorPended(irq);
+      softPending |= 1UL << irq;
+    }
+  }
+  nvicPending |= seen;
+  clear = simTake(&simNVIC.ICPR[0]);
+  nvicPending &= ~clear;
+  softPending &= ~clear;
+  __atomic_and_fetch(&simNVIC.ISPR[0], ~clear, __ATOMIC_SEQ_CST);
+
+  icsr = simTake(&simSCB.ICSR);
+  if ((icsr & SCB_ICSR_PENDSVSET_Msk) && !pendSV) {
+    vectorPended(PendSV_IRQn);
+    pendSV = true;
+  }
+  if (icsr & SCB_ICSR_PENDSVCLR_Msk) {
+    pendSV = false;
+  }
+  if ((icsr & SCB_ICSR_PENDSTSET_Msk) && !pendST) {
+    vectorPended(SysTick_IRQn);
+    pendST = true;
+  }
+  if (icsr & SCB_ICSR_PENDSTCLR_Msk) {
+    pendST = false;
+  }
+
+  aircr = simTake(&simSCB.AIRCR);
+  if ((aircr & SCB_AIRCR_SYSRESETREQ_Msk)
+      && ((aircr & SCB_AIRCR_VECTKEY_Msk) == (0x05FAUL << SCB_AIRCR_VECTKEY_Pos))) {
+    endCycles = simNow;
+  }
+}
+
+/* A modelled peripheral's line pends its vector while it is asserted. Unlike
+ * the NVIC we also drop the pending state when the flag is cleared before
+ * the handler ran, the IFC write may only be seen after the handler
+ * returned. Pending set by software (ISPR) stays. */
+static void simLinesLocked(void)
+{
+  uint32_t asserted = 0, lineMask = 0, drop;
+  size_t i;
+
+  for (i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+    lineMask |= 1UL << lines[i].irq;
+    if (*lines[i].flags & *lines[i].enable & lines[i].mask) {
+      asserted |= 1UL << lines[i].irq;
+      if (!(nvicPending & (1UL << lines[i].irq))) {
+        vectorPended(lines[i].irq);
+      }
+    }
+  }
+
+  drop = lineMask & ~asserted & ~softPending;
+  nvicPending = (nvicPending & ~drop) | asserted;
+  __atomic_and_fetch(&simNVIC.ISPR[0], ~drop, __ATOMIC_SEQ_CST);
+  __atomic_or_fetch(&simNVIC.ISPR[0], asserted, __ATOMIC_SEQ_CST);
+}
+
+static void simSyncLocked(void)
+{
+  size_t i;
+
+  for (i = 0; i < MODEL_COUNT; i++) {
+    models[i]->sync();
+  }
+  simNvicSyncLocked();
+  simLinesLocked();
+}
+
+/* Highest priority pending vector that would preempt level 'below' */
+static struct simVector *simNextVectorLocked(uint32_t below)
+{
+  struct simVector *best = NULL;
+  uint32_t bestPriority = below;
+  size_t i;
+
+  for (i = 0; i < VECTOR_COUNT; i++) {
+    if (vectorPending(&vectors[i]) && vectorPriority(&vectors[i]) < bestPriority) {
+      best = &vectors[i];
+      bestPriority = vectorPriority(&vectors[i]);
+    }
+  }
+  return best;
+}
+
+/* Any enabled interrupt pending, regardless of PRIMASK, ends a WFI */
+static bool simWakeLocked(void)
+{
+  return simNextVectorLocked(execPriority) != NULL;
+}
+
+/*******************************************************************************
+ ***************************   DISPATCH   **************************************
+ ******************************************************************************/
+
+static void simDispatch(void)
+{
+  sigset_t old, set;
+  struct simVector *v;
+  uint32_t saved;
+  uint64_t start;
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+
+  for (;;) {
+    simEnter(&old);
+    simSyncLocked();
+    v = primask ? NULL : simNextVectorLocked(execPriority);
+    if (v == NULL || v->handler == NULL) {
+      if (v != NULL) {
+        /* Default_Handler on the chip hangs, here we just complain */
+        fprintf(stderr, "hostsim: %s interrupt without handler\n", v->name);
+        nvicEnabled &= ~(1UL << v->irq);
+        __atomic_and_fetch(&simNVIC.ISER[0], ~(1UL << v->irq), __ATOMIC_SEQ_CST);
+        simLeave(&old);
+        continue;
+      }
+      simLeave(&old);
+      return;
+    }
+    vectorClear(v);
+    saved = execPriority;
+    execPriority = vectorPriority(v);
+    start = simNow;
+    v->calls++;
+    v->latency += start - v->pendedAt;
+    simLeave(&old);
+
+    /* Let higher priority interrupts in while the handler runs */
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+    v->handler();
+
+    simEnter(&old);
+    execPriority = saved;
+    v->cycles += simNow - start;
+    simLeave(&old);
+  }
+}
+
+static void simSignal(int sig)
+{
+  int savedErrno = errno;
+
+  (void)sig;
+  signalled = 0;
+  simDispatch();
+  errno = savedErrno;
+}
+
+void simWfi(void)
+{
+  sigset_t old;
+
+  simEnter(&old);
+  simSyncLocked();
+  if (!simWakeLocked()) {
+    cpu = (simSCB.SCR & SCB_SCR_SLEEPDEEP_Msk) ? CPU_EM2 : CPU_EM1;
+    wakeups++;
+    while (cpu != CPU_EM0) {
+      pthread_cond_wait(&wake, &lock);
+    }
+  }
+  simLeave(&old);
+
+  if (!primask) {
+    simDispatch();
+  }
+}
+
+void simPrimaskSet(uint32_t value)
+{
+  sigset_t old;
+  uint32_t was;
+
+  simEnter(&old);
+  was = primask;
+  primask = value;
+  simLeave(&old);
+
+  if (was && !value) {
+    simDispatch();
+  }
+}
+
+uint32_t simPrimaskGet(void)
+{
+  return primask;
+}
+
+void simNvicUpdate(void)
+{
+  sigset_t old;
+
+  simEnter(&old);
+  simNvicSyncLocked();
+  simLinesLocked();
+  simLeave(&old);
+
+  if (!primask) {
+    simDispatch();
+  }
+}
+
+void simNvicPrioritySet(int irq, uint32_t value)
+{
+  if (irq >= -2 && irq < 32) {
+    priority[irq + 2] = (uint8_t)value;
+  }
+}
+
+uint32_t simNvicPriorityGet(int irq)
+{
+  return (irq >= -2 && irq < 32) ? priority[irq + 2] : 0;
+}
+
+void simSystemReset(void)
+{
+  simStop(0);
+}
+
+/*******************************************************************************
+ ***************************   TIME   ******************************************
+ ******************************************************************************/
+
+bool simHfDomainRunning(void)
+{
+  return cpu != CPU_EM2;
+}
+
+uint64_t simCyclesAt(double seconds)
+{
+  double delta = (seconds - simSeconds) * simCmuHfClock();
+
+  if (delta <= 0.0) {
+    return simNow;
+  }
+  return simNow + (uint64_t)(delta + 0.999999);
+}
+
+/* Run the models up to 'target', event by event. While the core sleeps we
+ * stop at the first event that wakes it. */
+static void simAdvanceLocked(uint64_t target)
+{
+  uint64_t next, from;
+  size_t i;
+
+  while (simNow < target && simNow < endCycles) {
+    next = target < endCycles ? target : endCycles;
+    for (i = 0; i < MODEL_COUNT; i++) {
+      uint64_t n = models[i]->next();
+      if (n > simNow && n < next) {
+        next = n;
+      }
+    }
+
+    from = simNow;
+    simNow = next;
+    simSeconds += (double)(next - from) / simCmuHfClock();
+    emCycles[cpu] += next - from;
+
+    for (i = 0; i < MODEL_COUNT; i++) {
+      models[i]->advance();
+    }
+    simLinesLocked();
+
+    if (cpu != CPU_EM0 && simWakeLocked()) {
+      break;
+    }
+  }
+}
+
+static double hostElapsed(struct timespec *since)
+{
+  struct timespec now;
+  double elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsed = (now.tv_sec - since->tv_sec) + (now.tv_nsec - since->tv_nsec) * 1e-9;
+  *since = now;
+  return elapsed;
+}
+
+static void simFinish(void)
+{
+  int status;
+
+  if (!quiet) {
+    simReport(stdout);
+  }
+  if (simScenarioCheck && (status = simScenarioCheck()) != 0) {
+    exitStatus = status;
+  }
+  fflush(stdout);
+  fflush(stderr);
+  _exit(exitStatus);
+}
+
+static void *simThreadMain(void *arg)
+{
+  struct timespec last;
+  struct timespec tick = { 0, 20000 };
+  double host;
+
+  (void)arg;
+  clock_gettime(CLOCK_MONOTONIC, &last);
+
+  pthread_mutex_lock(&lock);
+  for (;;) {
+    simSyncLocked();
+    host = hostElapsed(&last);
+
+    if (endCycles == SIM_NEVER && simSeconds >= endSeconds) {
+      endCycles = simNow;
+    }
+    if (cpu == CPU_EM0) {
+      simAdvanceLocked(simNow + 1 + (uint64_t)(host * em0Scale * simCmuHfClock()));
+    } else {
+      simAdvanceLocked(simCyclesAt(endSeconds));
+    }
+    if (simNow >= endCycles || simSeconds >= endSeconds) {
+      pthread_mutex_unlock(&lock);
+      simFinish();
+    }
+
+    if (cpu != CPU_EM0) {
+      if (simWakeLocked()) {
+        cpu = CPU_EM0;
+        pthread_cond_broadcast(&wake);
+      }
+    } else if (!primask && !signalled && simNextVectorLocked(execPriority) != NULL) {
+      signalled = 1;
+      pthread_kill(appThread, SIGUSR1);
+    }
+
+    if (cpu == CPU_EM0) {
+      pthread_mutex_unlock(&lock);
+      nanosleep(&tick, NULL);
+      pthread_mutex_lock(&lock);
+    }
+  }
+  return NULL;
+}
+
+/*******************************************************************************
+ ***************************   API   *******************************************
+ ******************************************************************************/
+
+uint64_t simCyclesGet(void)
+{
+  sigset_t old;
+  uint64_t now;
+
+  simEnter(&old);
+  now = simNow;
+  simLeave(&old);
+  return now;
+}
+
+double simSecondsGet(void)
+{
+  sigset_t old;
+  double now;
+
+  simEnter(&old);
+  now = simSeconds;
+  simLeave(&old);
+  return now;
+}
+
+uint32_t simHfClockGet(void)
+{
+  return simCmuHfClock();
+}
+
+void simSync(void)
+{
+  sigset_t old;
+
+  simEnter(&old);
+  simSyncLocked();
+  simLeave(&old);
+}
+
+void simStop(int status)
+{
+  sigset_t old;
+
+  simEnter(&old);
+  exitStatus = status;
+  endCycles = simNow;
+  cpu = CPU_EM0;
+  simLeave(&old);
+
+  if (pthread_equal(pthread_self(), appThread)) {
+    for (;;) {
+      pause();
+    }
+  }
+}
+
+void simTraceSet(simTraceFn fn)
+{
+  traceFn = fn;
+}
+
+void simTrace(const char *signal, int level)
+{
+  if (traceFn != NULL) {
+    traceFn(simNow, signal, level);
+  }
+}
+
+void simReport(FILE *out)
+{
+  struct timespec now = hostStart;
+  double host = hostElapsed(&now);
+  uint64_t total = emCycles[CPU_EM0] + emCycles[CPU_EM1] + emCycles[CPU_EM2];
+  size_t i;
+
+  fprintf(out, "\nhostsim: %.6f s virtual in %.3f s host (%.0fx real time)\n",
+          simSeconds, host, host > 0.0 ? simSeconds / host : 0.0);
+  fprintf(out, "core: %llu cycles, EM0 %llu (%.2f%%), EM1 %llu, EM2 %llu, %lu sleeps\n",
+          (unsigned long long)total,
+          (unsigned long long)emCycles[CPU_EM0],
+          total ? 100.0 * emCycles[CPU_EM0] / total : 0.0,
+          (unsigned long long)emCycles[CPU_EM1],
+          (unsigned long long)emCycles[CPU_EM2], wakeups);
+  for (i = 0; i < VECTOR_COUNT; i++) {
+    if (vectors[i].calls) {
+      fprintf(out, "irq %-9s %8lu calls, %llu cycles in handler, %.1f cycles latency\n",
+              vectors[i].name, vectors[i].calls,
+              (unsigned long long)vectors[i].cycles,
+              (double)vectors[i].latency / vectors[i].calls);
+    }
+  }
+  for (i = 0; i < MODEL_COUNT; i++) {
+    models[i]->report(out);
+  }
+}
+
+/*******************************************************************************
+ ***************************   MAIN   ******************************************
+ ******************************************************************************/
+
+int main(void)
+{
+  struct sigaction sa;
+  sigset_t set, old;
+  const char *env;
+  size_t i;
+
+  if ((env = getenv("HOSTSIM_TIME")) != NULL) {
+    endSeconds = atof(env);
+  }
+  if ((env = getenv("HOSTSIM_EM0_SCALE")) != NULL) {
+    em0Scale = atof(env);
+  }
+  quiet = getenv("HOSTSIM_QUIET") != NULL;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  clock_gettime(CLOCK_MONOTONIC, &hostStart);
+
+  for (i = 0; i < MODEL_COUNT; i++) {
+    models[i]->reset();
+  }
+  if ((env = getenv("HOSTSIM_STIMULUS")) != NULL) {
+    simGpioLoadStimulus(env);
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = simSignal;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGUSR1, &sa, NULL);
+
+  appThread = pthread_self();
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &set, &old);
+  if (pthread_create(&simThread, NULL, simThreadMain, NULL) != 0) {
+    perror("hostsim");
+    return 1;
+  }
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (simScenario) {
+    simScenario();
+  }
+  SystemInit();
+  exitStatus = simAppMain();
+
+  /* main() returning is where the chip would run into the weeds */
+  simStop(exitStatus);
+  return exitStatus;
+}
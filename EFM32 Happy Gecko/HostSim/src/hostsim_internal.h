@@ -0,0 +1,89 @@
+/**************************************************************************//**
+ * @file hostsim_internal.h
+ * @brief Interface between the simulator core and the peripheral models.
+ *
+ * Every model keeps its state in the memory register block the application
+ * sees plus whatever hidden state the hardware has. The core calls the
+ * models with the simulator lock held:
+ *   sync()     process what the application wrote (CMD, IFS/IFC, SET/CLR)
+ *   next()     absolute cycle of the next event, SIM_NEVER if none
+ *   advance()  move to simNow, handling an event that falls exactly on it
+ * Models cause effects in other models (PRS, DMA requests) by calling them
+ * directly, the receiving model first catches up to simNow.
+ *****************************************************************************/
+
+#ifndef HOSTSIM_INTERNAL_H
+#define HOSTSIM_INTERNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "em_device.h"
+#include "hostsim.h"
+
+#define SIM_NEVER   UINT64_MAX
+
+struct simModel {
+  const char *name;
+  void (*reset)(void);
+  void (*sync)(void);
+  uint64_t (*next)(void);
+  void (*advance)(void);
+  void (*report)(FILE *out);
+};
+
+extern const struct simModel simCmuModel;
+extern const struct simModel simGpioModel;
+extern const struct simModel simPrsModel;
+extern const struct simModel simRtcModel;
+extern const struct simModel simTimerModel;
+extern const struct simModel simPcntModel;
+extern const struct simModel simDmaModel;
+extern const struct simModel simUsartModel;
+
+/* Lock for the API functions called from the application or a scenario */
+void simApiLock(void);
+void simApiUnlock(void);
+
+/* Core state, only valid with the lock held */
+extern uint64_t simNow;
+extern double simSeconds;
+bool simHfDomainRunning(void);
+uint64_t simCyclesAt(double seconds);
+
+/* Register helpers: take a write-only/self-clearing register, and write back
+ * the state of a set/clear register pair unless the application just wrote */
+static inline uint32_t simTake(volatile uint32_t *reg)
+{
+  return __atomic_exchange_n(reg, 0U, __ATOMIC_SEQ_CST);
+}
+
+static inline void simMirror(volatile uint32_t *reg, uint32_t seen, uint32_t state)
+{
+  __sync_bool_compare_and_swap(reg, seen, state);
+}
+
+void simTrace(const char *signal, int level);
+
+/* CMU */
+uint32_t simCmuHfClock(void);
+uint32_t simCmuHfperDivShift(void);
+bool simCmuHfperEnabled(uint32_t clockBit);
+bool simCmuHfcoreEnabled(uint32_t clockBit);
+bool simCmuLfaEnabled(uint32_t clockBit);
+uint32_t simCmuRtcDivShift(void);
+
+/* Cross peripheral signals */
+void simPrsSignal(uint32_t source, uint32_t signal, int level);
+void simPrsPulse(uint32_t source, uint32_t signal);
+void simTimerPrsInput(unsigned ch, int level);
+void simPcntPrsInput(unsigned ch, int level);
+bool simDmaRequest(uint32_t dmareq);
+void simPeripheralWrite(volatile void *addr);
+void simDmaRebase(void);
+void simRtcCounterReset(void);
+void simPcntLoad(uint32_t counter, uint32_t top);
+
+void simGpioLoadStimulus(const char *path);
+
+#endif /* HOSTSIM_INTERNAL_H */
@@ -0,0 +1,166 @@
+/**************************************************************************//**
+ * @file sim_cmu.c
+ * @brief CMU model: oscillators, HFCLK selection and the clock gates.
+ *
+ * Oscillators are ready as soon as they are enabled. The HFCLK frequency
+ * follows the HFRCO band or the selected oscillator (24 MHz HFXO on the
+ * SLSTK3400A); the low frequency clocks are 32768 Hz.
+ *****************************************************************************/
+
+#include "hostsim_internal.h"
+
+CMU_TypeDef simCMU;
+
+/* Enable/disable command bits and the STATUS bits they control */
+static const struct {
+  uint32_t enable;
+  uint32_t disable;
+  uint32_t status;
+} oscillators[] = {
+  { CMU_OSCENCMD_HFRCOEN,    CMU_OSCENCMD_HFRCODIS,    CMU_STATUS_HFRCOENS | CMU_STATUS_HFRCORDY },
+  { CMU_OSCENCMD_HFXOEN,     CMU_OSCENCMD_HFXODIS,     CMU_STATUS_HFXOENS | CMU_STATUS_HFXORDY },
+  { CMU_OSCENCMD_AUXHFRCOEN, CMU_OSCENCMD_AUXHFRCODIS, CMU_STATUS_AUXHFRCOENS | CMU_STATUS_AUXHFRCORDY },
+  { CMU_OSCENCMD_LFRCOEN,    CMU_OSCENCMD_LFRCODIS,    CMU_STATUS_LFRCOENS | CMU_STATUS_LFRCORDY },
+  { CMU_OSCENCMD_LFXOEN,     CMU_OSCENCMD_LFXODIS,     CMU_STATUS_LFXOENS | CMU_STATUS_LFXORDY },
+};
+
+#define SELECT_MASK  (CMU_STATUS_HFRCOSEL | CMU_STATUS_HFXOSEL \
+                      | CMU_STATUS_LFRCOSEL | CMU_STATUS_LFXOSEL)
+
+static uint32_t hfClock = 14000000UL;
+static unsigned long bandChanges;
+
+static uint32_t bandFrequency(uint32_t band)
+{
+  switch (band) {
+    case _CMU_HFRCOCTRL_BAND_1MHZ:  return 1200000UL;
+    case _CMU_HFRCOCTRL_BAND_7MHZ:  return 6600000UL;
+    case _CMU_HFRCOCTRL_BAND_11MHZ: return 11000000UL;
+    case _CMU_HFRCOCTRL_BAND_14MHZ: return 14000000UL;
+    case _CMU_HFRCOCTRL_BAND_21MHZ: return 21000000UL;
+    default:                        return 14000000UL;
+  }
+}
+
+static void cmuReset(void)
+{
+  simCMU.CTRL = _CMU_CTRL_RESETVALUE;
+  simCMU.HFCORECLKDIV = _CMU_HFCORECLKDIV_RESETVALUE;
+  simCMU.HFPERCLKDIV = _CMU_HFPERCLKDIV_RESETVALUE;
+  simCMU.HFRCOCTRL = _CMU_HFRCOCTRL_RESETVALUE;
+  simCMU.LFRCOCTRL = _CMU_LFRCOCTRL_RESETVALUE;
+  simCMU.AUXHFRCOCTRL = _CMU_AUXHFRCOCTRL_RESETVALUE;
+  simCMU.STATUS = _CMU_STATUS_RESETVALUE;
+  hfClock = bandFrequency((simCMU.HFRCOCTRL & _CMU_HFRCOCTRL_BAND_MASK) >> _CMU_HFRCOCTRL_BAND_SHIFT);
+}
+
+static uint32_t selectedClock(void)
+{
+  uint32_t status = simCMU.STATUS;
+
+  if (status & CMU_STATUS_HFXOSEL) {
+    return 24000000UL;
+  }
+  if (status & (CMU_STATUS_LFRCOSEL | CMU_STATUS_LFXOSEL)) {
+    return 32768UL;
+  }
+  return bandFrequency((simCMU.HFRCOCTRL & _CMU_HFRCOCTRL_BAND_MASK) >> _CMU_HFRCOCTRL_BAND_SHIFT);
+}
+
+static void cmuSync(void)
+{
+  uint32_t cmd, status, select;
+  uint32_t clock;
+  size_t i;
+
+  cmd = simTake(&simCMU.OSCENCMD);
+  status = simCMU.STATUS;
+  for (i = 0; i < sizeof(oscillators) / sizeof(oscillators[0]); i++) {
+    if (cmd & oscillators[i].enable) {
+      status |= oscillators[i].status;
+    }
+    if (cmd & oscillators[i].disable) {
+      status &= ~oscillators[i].status;
+    }
+  }
+
+  cmd = simTake(&simCMU.CMD);
+  select = (cmd & _CMU_CMD_HFCLKSEL_MASK) >> _CMU_CMD_HFCLKSEL_SHIFT;
+  if (select != 0) {
+    status &= ~SELECT_MASK;
+    switch (select) {
+      case _CMU_CMD_HFCLKSEL_HFXO:  status |= CMU_STATUS_HFXOSEL;  break;
+      case _CMU_CMD_HFCLKSEL_LFRCO: status |= CMU_STATUS_LFRCOSEL; break;
+      case _CMU_CMD_HFCLKSEL_LFXO:  status |= CMU_STATUS_LFXOSEL;  break;
+      default:                      status |= CMU_STATUS_HFRCOSEL; break;
+    }
+  }
+  simCMU.STATUS = status;
+  simCMU.SYNCBUSY = 0;
+
+  simCMU.IF |= simTake(&simCMU.IFS);
+  simCMU.IF &= ~simTake(&simCMU.IFC);
+
+  clock = selectedClock();
+  if (clock != hfClock) {
+    hfClock = clock;
+    bandChanges++;
+  }
+}
+
+static uint64_t cmuNext(void)
+{
+  return SIM_NEVER;
+}
+
+static void cmuAdvance(void)
+{
+}
+
+static void cmuReport(FILE *out)
+{
+  fprintf(out, "cmu: HFCLK %lu Hz, HFPERCLK /%lu, %lu clock changes\n",
+          (unsigned long)hfClock, 1UL << simCmuHfperDivShift(), bandChanges);
+}
+
+const struct simModel simCmuModel = {
+  "cmu", cmuReset, cmuSync, cmuNext, cmuAdvance, cmuReport
+};
+
+/*******************************************************************************
+ ***************************   CLOCK TREE   ************************************
+ ******************************************************************************/
+
+uint32_t simCmuHfClock(void)
+{
+  return hfClock;
+}
+
+uint32_t simCmuHfperDivShift(void)
+{
+  return (simCMU.HFPERCLKDIV & _CMU_HFPERCLKDIV_HFPERCLKDIV_MASK)
+         >> _CMU_HFPERCLKDIV_HFPERCLKDIV_SHIFT;
+}
+
+bool simCmuHfperEnabled(uint32_t clockBit)
+{
+  return (simCMU.HFPERCLKDIV & CMU_HFPERCLKDIV_HFPERCLKEN)
+         && (simCMU.HFPERCLKEN0 & clockBit);
+}
+
+bool simCmuHfcoreEnabled(uint32_t clockBit)
+{
+  return (simCMU.HFCORECLKEN0 & clockBit) != 0;
+}
+
+bool simCmuLfaEnabled(uint32_t clockBit)
+{
+  return ((simCMU.LFCLKSEL & _CMU_LFCLKSEL_LFA_MASK) != _CMU_LFCLKSEL_LFA_DISABLED
+          || (simCMU.LFCLKSEL & _CMU_LFCLKSEL_LFAE_MASK))
+         && (simCMU.LFACLKEN0 & clockBit);
+}
+
+uint32_t simCmuRtcDivShift(void)
+{
+  return (simCMU.LFAPRESC0 & _CMU_LFAPRESC0_RTC_MASK) >> _CMU_LFAPRESC0_RTC_SHIFT;
+}
@@ -0,0 +1,301 @@
+/**************************************************************************//**
+ * @file sim_dma.c
+ * @brief DMA model: the PL230 channel descriptors, cycle types and requests.
+ *
+ * A request (software CHSWREQ or a peripheral DMAREQ_xxx) makes the channel
+ * move up to 2^R_POWER elements straight away, auto and memory scatter-gather
+ * cycles run to the end of the cycle. Transfers take no virtual time; the
+ * report gives the bus cycles they would need on the chip, estimated as
+ * 4 cycles per arbitration (descriptor read and write back) plus 2 per
+ * element.
+ *****************************************************************************/
+
+#include <string.h>
+#include "hostsim_internal.h"
+#include "em_dma.h"
+
+DMA_TypeDef simDMA;
+
+/* PL230 cycle_ctrl values */
+#define CYCLE_STOP          0
+#define CYCLE_BASIC         1
+#define CYCLE_AUTO          2
+#define CYCLE_PINGPONG      3
+#define CYCLE_MEM_SG        4
+#define CYCLE_MEM_SG_ALT    5
+#define CYCLE_PER_SG        6
+#define CYCLE_PER_SG_ALT    7
+
+#define CYCLES_ARBITRATION  4
+#define CYCLES_ELEMENT      2
+
+#define INC_NONE            3
+
+struct simChannel {
+  unsigned long requests;
+  unsigned long arbitrations;
+  unsigned long elements;
+  unsigned long bytes;
+  unsigned long done;
+  uint64_t      busCycles;
+};
+
+static uint32_t enabled, alternate, reqMask, useBurst, priority;
+static struct simChannel channels[DMA_CHAN_COUNT];
+
+static bool dmaRunning(void)
+{
+  return (simDMA.CONFIG & DMA_CONFIG_EN) && simCmuHfcoreEnabled(CMU_HFCORECLKEN0_DMA);
+}
+
+static DMA_DESCRIPTOR_TypeDef *descriptor(unsigned ch, bool alt)
+{
+  uint32_t base = alt ? simDMA.ALTCTRLBASE : simDMA.CTRLBASE;
+
+  return &((DMA_DESCRIPTOR_TypeDef *)(uintptr_t)base)[ch];
+}
+
+static void copyElement(volatile void *dst, volatile void *src, uint32_t size)
+{
+  switch (size) {
+    case 0:  *(volatile uint8_t *)dst = *(volatile uint8_t *)src;   break;
+    case 1:  *(volatile uint16_t *)dst = *(volatile uint16_t *)src; break;
+    default: *(volatile uint32_t *)dst = *(volatile uint32_t *)src; break;
+  }
+}
+
+/* Move up to 'count' elements of a descriptor, true when its cycle is done */
+static bool transfer(unsigned ch, DMA_DESCRIPTOR_TypeDef *d, uint32_t count)
+{
+  struct simChannel *c = &channels[ch];
+  uint32_t ctrl = d->CTRL;
+  uint32_t nm1 = (ctrl & _DMA_CTRL_N_MINUS_1_MASK) >> _DMA_CTRL_N_MINUS_1_SHIFT;
+  uint32_t size = (ctrl & _DMA_CTRL_SRC_SIZE_MASK) >> _DMA_CTRL_SRC_SIZE_SHIFT;
+  uint32_t srcInc = (ctrl & _DMA_CTRL_SRC_INC_MASK) >> _DMA_CTRL_SRC_INC_SHIFT;
+  uint32_t dstInc = (ctrl & _DMA_CTRL_DST_INC_MASK) >> _DMA_CTRL_DST_INC_SHIFT;
+  uintptr_t src, dst;
+
+  c->arbitrations++;
+  c->busCycles += CYCLES_ARBITRATION;
+  for (;;) {
+    src = (uintptr_t)d->SRCEND - (srcInc == INC_NONE ? 0 : (uintptr_t)nm1 << srcInc);
+    dst = (uintptr_t)d->DSTEND - (dstInc == INC_NONE ? 0 : (uintptr_t)nm1 << dstInc);
+    copyElement((volatile void *)dst, (volatile void *)src, size);
+    simPeripheralWrite((volatile void *)dst);
+    c->elements++;
+    c->bytes += 1U << size;
+    c->busCycles += CYCLES_ELEMENT;
+
+    if (nm1 == 0) {
+      d->CTRL = ctrl & ~(_DMA_CTRL_N_MINUS_1_MASK | _DMA_CTRL_CYCLE_CTRL_MASK);
+      return true;
+    }
+    nm1--;
+    if (--count == 0) {
+      d->CTRL = (ctrl & ~_DMA_CTRL_N_MINUS_1_MASK) | (nm1 << _DMA_CTRL_N_MINUS_1_SHIFT);
+      return false;
+    }
+  }
+}
+
+static void channelDone(unsigned ch, bool disable)
+{
+  simDMA.IF |= DMA_IF_CH0DONE << ch;
+  channels[ch].done++;
+  if (disable) {
+    enabled &= ~(1UL << ch);
+    __atomic_and_fetch(&simDMA.CHENS, ~(1UL << ch), __ATOMIC_SEQ_CST);
+  }
+}
+
+static void selectAlternate(unsigned ch, bool alt)
+{
+  if (alt) {
+    alternate |= 1UL << ch;
+    __atomic_or_fetch(&simDMA.CHALTS, 1UL << ch, __ATOMIC_SEQ_CST);
+  } else {
+    alternate &= ~(1UL << ch);
+    __atomic_and_fetch(&simDMA.CHALTS, ~(1UL << ch), __ATOMIC_SEQ_CST);
+  }
+}
+
+/* One request on a channel */
+static void serve(unsigned ch)
+{
+  DMA_DESCRIPTOR_TypeDef *d;
+  uint32_t cycle, arbitrate;
+  bool alt;
+
+  channels[ch].requests++;
+  for (;;) {
+    if (!(enabled & (1UL << ch))) {
+      return;
+    }
+    alt = (alternate >> ch) & 1U;
+    d = descriptor(ch, alt);
+    cycle = (d->CTRL & _DMA_CTRL_CYCLE_CTRL_MASK) >> _DMA_CTRL_CYCLE_CTRL_SHIFT;
+    arbitrate = 1UL << ((d->CTRL & _DMA_CTRL_R_POWER_MASK) >> _DMA_CTRL_R_POWER_SHIFT);
+
+    switch (cycle) {
+      case CYCLE_BASIC:
+        if (transfer(ch, d, arbitrate)) {
+          channelDone(ch, true);
+        }
+        return;
+
+      case CYCLE_AUTO:
+        while (!transfer(ch, d, arbitrate)) {
+        }
+        channelDone(ch, true);
+        return;
+
+      case CYCLE_PINGPONG:
+        if (transfer(ch, d, arbitrate)) {
+          selectAlternate(ch, !alt);
+          d = descriptor(ch, !alt);
+          channelDone(ch, (d->CTRL & _DMA_CTRL_CYCLE_CTRL_MASK) == CYCLE_STOP);
+        }
+        return;
+
+      case CYCLE_MEM_SG:
+      case CYCLE_PER_SG:
+        /* Primary copies the next task into the alternate descriptor */
+        transfer(ch, d, 4);
+        selectAlternate(ch, true);
+        if (cycle == CYCLE_PER_SG) {
+          return;
+        }
+        break;
+
+      case CYCLE_MEM_SG_ALT:
+        while (!transfer(ch, d, arbitrate)) {
+        }
+        selectAlternate(ch, false);
+        break;
+
+      case CYCLE_PER_SG_ALT:
+        if (transfer(ch, d, arbitrate)) {
+          /* The next task is fetched without waiting for a request */
+          selectAlternate(ch, false);
+          d = descriptor(ch, false);
+          if ((d->CTRL & _DMA_CTRL_CYCLE_CTRL_MASK) == CYCLE_STOP) {
+            channelDone(ch, true);
+          } else {
+            transfer(ch, d, 4);
+            selectAlternate(ch, true);
+          }
+        }
+        return;
+
+      default:
+        /* Invalid descriptor: the controller stops the channel */
+        enabled &= ~(1UL << ch);
+        __atomic_and_fetch(&simDMA.CHENS, ~(1UL << ch), __ATOMIC_SEQ_CST);
+        return;
+    }
+  }
+}
+
+bool simDmaRequest(uint32_t dmareq)
+{
+  unsigned ch;
+  uint32_t mask = _DMA_CH_CTRL_SOURCESEL_MASK | _DMA_CH_CTRL_SIGSEL_MASK;
+  bool served = false;
+
+  if (!dmaRunning()) {
+    return false;
+  }
+  for (ch = 0; ch < DMA_CHAN_COUNT; ch++) {
+    if ((enabled & ~reqMask & (1UL << ch))
+        && (simDMA.CH[ch].CTRL & mask) == (dmareq & mask)
+        && (simDMA.CH[ch].CTRL & _DMA_CH_CTRL_SOURCESEL_MASK) != 0) {
+      serve(ch);
+      served = true;
+    }
+  }
+  return served;
+}
+
+void simDmaRebase(void)
+{
+  /* The alternate block follows the primary one, which holds a power of two
+   * number of channels */
+  uint32_t offset = DMA_CHAN_COUNT <= 4 ? 0x40 : (DMA_CHAN_COUNT <= 8 ? 0x80 : 0x100);
+
+  simDMA.ALTCTRLBASE = simDMA.CTRLBASE ? simDMA.CTRLBASE + offset : 0;
+}
+
+/* Set/clear register pair, the set register reads back the state */
+static uint32_t setClear(volatile uint32_t *set, volatile uint32_t *clear, uint32_t state)
+{
+  uint32_t seen = *set;
+
+  state |= seen;
+  state &= ~simTake(clear);
+  simMirror(set, seen, state);
+  return state;
+}
+
+static void dmaReset(void)
+{
+  enabled = alternate = reqMask = useBurst = priority = 0;
+  memset(channels, 0, sizeof(channels));
+}
+
+static void dmaSync(void)
+{
+  uint32_t swreq;
+  unsigned ch;
+
+  simDmaRebase();
+  reqMask = setClear(&simDMA.CHREQMASKS, &simDMA.CHREQMASKC, reqMask);
+  useBurst = setClear(&simDMA.CHUSEBURSTS, &simDMA.CHUSEBURSTC, useBurst);
+  priority = setClear(&simDMA.CHPRIS, &simDMA.CHPRIC, priority);
+  alternate = setClear(&simDMA.CHALTS, &simDMA.CHALTC, alternate);
+  enabled = setClear(&simDMA.CHENS, &simDMA.CHENC, enabled);
+  simDMA.IF |= simTake(&simDMA.IFS);
+  simDMA.IF &= ~simTake(&simDMA.IFC);
+  simTake(&simDMA.ERRORC);
+
+  swreq = simTake(&simDMA.CHSWREQ);
+  if (swreq && dmaRunning()) {
+    for (ch = 0; ch < DMA_CHAN_COUNT; ch++) {
+      if (swreq & (1UL << ch)) {
+        serve(ch);
+      }
+    }
+  }
+}
+
+uint64_t simDmaBusCycles(unsigned ch)
+{
+  return ch < DMA_CHAN_COUNT ? channels[ch].busCycles : 0;
+}
+
+static uint64_t dmaNext(void)
+{
+  return SIM_NEVER;
+}
+
+static void dmaAdvance(void)
+{
+}
+
+static void dmaReport(FILE *out)
+{
+  unsigned ch;
+  struct simChannel *c;
+
+  for (ch = 0; ch < DMA_CHAN_COUNT; ch++) {
+    c = &channels[ch];
+    if (c->requests) {
+      fprintf(out, "dma: ch%u %lu requests, %lu arbitrations, %lu elements, %lu bytes, "
+              "%lu done, ~%llu bus cycles\n", ch, c->requests, c->arbitrations,
+              c->elements, c->bytes, c->done, (unsigned long long)c->busCycles);
+    }
+  }
+}
+
+const struct simModel simDmaModel = {
+  "dma", dmaReset, dmaSync, dmaNext, dmaAdvance, dmaReport
+};
@@ -0,0 +1,263 @@
+/**************************************************************************//**
+ * @file sim_gpio.c
+ * @brief GPIO model: pin levels, external interrupts, PRS inputs, stimulus.
+ *
+ * A pin in an output mode shows DOUT. An input shows what the stimulus
+ * drives, or DOUT when nothing drives it (DOUT selects the pull direction
+ * in the pull modes, so an idle push button reads 1). DIN always reflects
+ * the computed levels.
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "hostsim_internal.h"
+
+GPIO_TypeDef simGPIO;
+
+#define PORT_COUNT  (sizeof(simGPIO.P) / sizeof(simGPIO.P[0]))
+#define STIMULUS_MAX  1024
+
+struct stimulus {
+  double    seconds;
+  unsigned  port;
+  unsigned  pin;
+  int       level;      /* -1 releases the pin */
+};
+
+static uint16_t drivenMask[PORT_COUNT];
+static uint16_t drivenLevel[PORT_COUNT];
+static uint16_t levels[PORT_COUNT];
+static uint32_t toggles[PORT_COUNT][16];
+static unsigned long extInterrupts;
+
+static struct stimulus stimuli[STIMULUS_MAX];
+static unsigned stimulusCount;
+static unsigned stimulusNext;
+
+static uint16_t outputPins(unsigned port)
+{
+  uint16_t mask = 0;
+  uint32_t mode;
+  unsigned pin;
+
+  for (pin = 0; pin < 16; pin++) {
+    if (pin < 8) {
+      mode = (simGPIO.P[port].MODEL >> (4 * pin)) & 0xFU;
+    } else {
+      mode = (simGPIO.P[port].MODEH >> (4 * (pin - 8))) & 0xFU;
+    }
+    if (mode >= _GPIO_P_MODEL_MODE0_PUSHPULL) {
+      mask |= 1U << pin;
+    }
+  }
+  return mask;
+}
+
+/* Port whose pin 'pin' feeds the external interrupt and PRS signal 'pin' */
+static unsigned extiPort(unsigned pin)
+{
+  if (pin < 8) {
+    return (simGPIO.EXTIPSELL >> (4 * pin)) & 0x7U;
+  }
+  return (simGPIO.EXTIPSELH >> (4 * (pin - 8))) & 0x7U;
+}
+
+static void pinChanged(unsigned port, unsigned pin, int level)
+{
+  char name[8];
+
+  toggles[port][pin]++;
+  name[0] = 'P';
+  name[1] = (char)('A' + port);
+  snprintf(&name[2], sizeof(name) - 2, "%u", pin);
+  simTrace(name, level);
+
+  if (extiPort(pin) != port) {
+    return;
+  }
+  if ((level && (simGPIO.EXTIRISE & (1U << pin)))
+      || (!level && (simGPIO.EXTIFALL & (1U << pin)))) {
+    simGPIO.IF |= 1U << pin;
+    extInterrupts++;
+  }
+  if (simGPIO.INSENSE & GPIO_INSENSE_PRS) {
+    simPrsSignal(pin < 8 ? PRS_CH_CTRL_SOURCESEL_GPIOL : PRS_CH_CTRL_SOURCESEL_GPIOH,
+                 (pin & 7U) << _PRS_CH_CTRL_SIGSEL_SHIFT, level);
+  }
+}
+
+static void gpioUpdate(void)
+{
+  uint16_t out, dout, level, changed;
+  unsigned port, pin;
+
+  for (port = 0; port < PORT_COUNT; port++) {
+    out = outputPins(port);
+    dout = (uint16_t)simGPIO.P[port].DOUT;
+    level = (out & dout)
+            | (~out & drivenMask[port] & drivenLevel[port])
+            | (~out & ~drivenMask[port] & dout);
+    simGPIO.P[port].DIN = level;
+
+    changed = level ^ levels[port];
+    levels[port] = level;
+    for (pin = 0; changed; pin++, changed >>= 1) {
+      if (changed & 1U) {
+        pinChanged(port, pin, (level >> pin) & 1U);
+      }
+    }
+  }
+}
+
+static void gpioReset(void)
+{
+  memset(levels, 0, sizeof(levels));
+  memset(drivenMask, 0, sizeof(drivenMask));
+  simGPIO.INSENSE = _GPIO_INSENSE_RESETVALUE;
+}
+
+static void applyStimuli(void)
+{
+  struct stimulus *s;
+
+  while (stimulusNext < stimulusCount
+         && simCyclesAt(stimuli[stimulusNext].seconds) <= simNow) {
+    s = &stimuli[stimulusNext++];
+    if (s->level < 0) {
+      drivenMask[s->port] &= ~(1U << s->pin);
+    } else {
+      drivenMask[s->port] |= 1U << s->pin;
+      drivenLevel[s->port] = (drivenLevel[s->port] & ~(1U << s->pin))
+                             | ((s->level ? 1U : 0U) << s->pin);
+    }
+  }
+  gpioUpdate();
+}
+
+static void gpioSync(void)
+{
+  unsigned port;
+  uint32_t set, clr, tgl;
+
+  for (port = 0; port < PORT_COUNT; port++) {
+    set = simTake(&simGPIO.P[port].DOUTSET);
+    clr = simTake(&simGPIO.P[port].DOUTCLR);
+    tgl = simTake(&simGPIO.P[port].DOUTTGL);
+    if (set | clr | tgl) {
+      simGPIO.P[port].DOUT = ((simGPIO.P[port].DOUT | set) & ~clr) ^ tgl;
+    }
+  }
+  simGPIO.IF |= simTake(&simGPIO.IFS);
+  simGPIO.IF &= ~simTake(&simGPIO.IFC);
+
+  applyStimuli();
+}
+
+static uint64_t gpioNext(void)
+{
+  if (stimulusNext >= stimulusCount) {
+    return SIM_NEVER;
+  }
+  return simCyclesAt(stimuli[stimulusNext].seconds);
+}
+
+static void gpioAdvance(void)
+{
+  applyStimuli();
+}
+
+static void gpioReport(FILE *out)
+{
+  unsigned port, pin;
+
+  fprintf(out, "gpio: %lu external interrupt edges\n", extInterrupts);
+  for (port = 0; port < PORT_COUNT; port++) {
+    for (pin = 0; pin < 16; pin++) {
+      if (toggles[port][pin]) {
+        fprintf(out, "gpio: P%c%u %lu edges, now %d\n", 'A' + port, pin,
+                (unsigned long)toggles[port][pin], (levels[port] >> pin) & 1);
+      }
+    }
+  }
+}
+
+const struct simModel simGpioModel = {
+  "gpio", gpioReset, gpioSync, gpioNext, gpioAdvance, gpioReport
+};
+
+/*******************************************************************************
+ ***************************   STIMULUS   **************************************
+ ******************************************************************************/
+
+static void schedule(double seconds, unsigned port, unsigned pin, int level)
+{
+  unsigned i;
+
+  if (stimulusCount >= STIMULUS_MAX || port >= PORT_COUNT || pin > 15) {
+    fprintf(stderr, "hostsim: stimulus P%c%u dropped\n", 'A' + port, pin);
+    return;
+  }
+  /* Keep the list sorted, equal times stay in the order given */
+  for (i = stimulusCount; i > stimulusNext && stimuli[i - 1].seconds > seconds; i--) {
+    stimuli[i] = stimuli[i - 1];
+  }
+  stimuli[i].seconds = seconds;
+  stimuli[i].port = port;
+  stimuli[i].pin = pin;
+  stimuli[i].level = level;
+  stimulusCount++;
+}
+
+/* Lines "<ms> <port><pin> <0|1|z>", e.g. "1500 C9 0" presses PB0 at 1.5 s */
+void simGpioLoadStimulus(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[128], pinName[8], levelName[8];
+  double ms;
+  unsigned pin;
+
+  if (f == NULL) {
+    perror(path);
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (line[0] == '#' || sscanf(line, "%lf %7s %7s", &ms, pinName, levelName) != 3) {
+      continue;
+    }
+    pin = (unsigned)atoi(&pinName[1]);
+    schedule(ms / 1000.0, (unsigned)(toupper((unsigned char)pinName[0]) - 'A'), pin,
+             (levelName[0] == 'z' || levelName[0] == 'Z') ? -1 : atoi(levelName));
+  }
+  fclose(f);
+}
+
+void simGpioSchedule(double seconds, unsigned port, unsigned pin, int level)
+{
+  simApiLock();
+  schedule(seconds, port, pin, level);
+  simApiUnlock();
+}
+
+void simGpioDrive(unsigned port, unsigned pin, int level)
+{
+  simApiLock();
+  schedule(simSeconds, port, pin, level);
+  applyStimuli();
+  simApiUnlock();
+}
+
+void simGpioRelease(unsigned port, unsigned pin)
+{
+  simGpioDrive(port, pin, -1);
+}
+
+int simGpioLevel(unsigned port, unsigned pin)
+{
+  return port < PORT_COUNT ? (levels[port] >> (pin & 15U)) & 1 : 0;
+}
+
+uint32_t simPinToggles(unsigned port, unsigned pin)
+{
+  return port < PORT_COUNT ? toggles[port][pin & 15U] : 0;
+}
@@ -0,0 +1,214 @@
+/**************************************************************************//**
+ * @file sim_kit.c
+ * @brief Stand-ins for the SLSTK3400A kit drivers and GLIB.
+ *
+ * printf already reaches stdout, so the text display and the serial port
+ * need nothing. GLIB strings are printed with their position. The display
+ * init sets USART0 up for SPI like the kit driver does, so code sending to
+ * the LCD itself gets its bytes timed by the USART model. It also takes the
+ * RTC over for the EXTCOMIN toggle as the kit PAL does, so code sharing the
+ * RTC with the display breaks here as it would on the chip.
+ *****************************************************************************/
+
+#include <string.h>
+#include "hostsim_internal.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "bsp.h"
+#include "display.h"
+#include "displayconfig.h"
+#include "displaypal.h"
+#include "retargetserial.h"
+#include "retargettextdisplay.h"
+#include "glib.h"
+
+const GLIB_Font_t GLIB_FontNormal8x8 = { "normal8x8", 8, 8 };
+const GLIB_Font_t GLIB_FontNarrow6x8 = { "narrow6x8", 6, 8 };
+const GLIB_Font_t GLIB_FontNumber16x20 = { "number16x20", 16, 20 };
+
+static bool displayReady;
+
+#ifdef POLARITY_INVERSION_EXTCOMIN_PAL_AUTO_TOGGLE
+/* RTC on the LFXO with COMP0 as TOP, every match pulses EXTCOMIN through
+ * PRS. Whatever ran on the RTC before now wraps at COMP0. */
+static void palRtcTakeOver(void)
+{
+  CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
+  CMU_ClockEnable(cmuClock_CORELE, true);
+  CMU_ClockEnable(cmuClock_RTC, true);
+
+  RTC->CTRL = 0;
+  RTC->COMP0 = 32768 / LS013B7DH03_POLARITY_INVERSION_FREQUENCY - 1;
+  PRS->CH[LCD_AUTO_TOGGLE_PRS_CH].CTRL = PRS_CH_CTRL_SOURCESEL_RTC
+                                         | PRS_CH_CTRL_SIGSEL_RTCCOMP0;
+  RTC->CTRL = RTC_CTRL_EN | RTC_CTRL_COMP0TOP;
+}
+#else
+static void displayPolarityInverse(void *argument)
+{
+  (void)argument;
+  GPIO_PinOutToggle(LCD_PORT_EXTCOMIN, LCD_PIN_EXTCOMIN);
+}
+#endif
+
+EMSTATUS DISPLAY_Init(void)
+{
+  if (!displayReady) {
+    displayReady = true;
+    GPIO_PinModeSet(LCD_PORT_EXTCOMIN, LCD_PIN_EXTCOMIN, gpioModePushPull, 0);
+#ifdef POLARITY_INVERSION_EXTCOMIN_PAL_AUTO_TOGGLE
+    palRtcTakeOver();
+#else
+    /* The project toggles EXTCOMIN, the RTC is left alone */
+    PAL_TIMER_REPEAT_FUNCTION(displayPolarityInverse, NULL,
+                              LS013B7DH03_POLARITY_INVERSION_FREQUENCY);
+#endif
+
+    /* SPI master, transmit only, chip select as GPIO */
+    CMU_ClockEnable(PAL_SPI_USART_CLOCK, true);
+    PAL_SPI_USART_UNIT->CTRL = USART_CTRL_SYNC;
+    PAL_SPI_USART_UNIT->CLKDIV = 256 * (CMU_ClockFreqGet(cmuClock_HFPER) / (2 * PAL_SPI_BAUDRATE) - 1);
+    PAL_SPI_USART_UNIT->CMD = USART_CMD_MASTEREN | USART_CMD_TXEN;
+    GPIO_PinModeSet(LCD_PORT_SCS, LCD_PIN_SCS, gpioModePushPull, 0);
+  }
+  return DISPLAY_EMSTATUS_OK;
+}
+
+EMSTATUS PAL_TimerMicroSecondsDelay(unsigned int usecs)
+{
+  (void)usecs;
+  return DISPLAY_EMSTATUS_OK;
+}
+
+EMSTATUS DISPLAY_DeviceGet(int displayDeviceNo, DISPLAY_Device_t *device)
+{
+  if (displayDeviceNo != 0 || device == NULL) {
+    return DISPLAY_EMSTATUS_INVALID_PARAM;
+  }
+  device->name = "hostsim";
+  device->geometry.width = DISPLAY_GEOMETRY_WIDTH;
+  device->geometry.height = DISPLAY_GEOMETRY_HEIGHT;
+  return DISPLAY_EMSTATUS_OK;
+}
+
+EMSTATUS RETARGET_TextDisplayInit(void)
+{
+  return DISPLAY_Init();
+}
+
+void RETARGET_SerialInit(void)
+{
+}
+
+void RETARGET_SerialCrLf(int on)
+{
+  (void)on;
+}
+
+EMSTATUS DMD_init(void *initData)
+{
+  (void)initData;
+  return DISPLAY_Init();
+}
+
+EMSTATUS DMD_updateDisplay(void)
+{
+  fflush(stdout);
+  return DMD_OK;
+}
+
+EMSTATUS GLIB_contextInit(GLIB_Context_t *pContext)
+{
+  memset(pContext, 0, sizeof(*pContext));
+  pContext->foregroundColor = White;
+  pContext->backgroundColor = Black;
+  pContext->font = &GLIB_FontNormal8x8;
+  return GLIB_OK;
+}
+
+EMSTATUS GLIB_setFont(GLIB_Context_t *pContext, GLIB_Font_t *pFont)
+{
+  pContext->font = pFont;
+  return GLIB_OK;
+}
+
+EMSTATUS GLIB_clear(GLIB_Context_t *pContext)
+{
+  (void)pContext;
+  printf("[lcd clear]\n");
+  return GLIB_OK;
+}
+
+EMSTATUS GLIB_drawString(GLIB_Context_t *pContext, const char *pString,
+                         uint32_t sLength, int32_t x0, int32_t y0, bool opaque)
+{
+  (void)pContext;
+  (void)opaque;
+  printf("[lcd %ld,%ld] %.*s\n", (long)x0, (long)y0, (int)sLength, pString);
+  return GLIB_OK;
+}
+
+/* LEDs are plain GPIO outputs */
+static const struct {
+  GPIO_Port_TypeDef port;
+  unsigned int pin;
+} ledPins[BSP_NO_OF_LEDS] = {
+  { BSP_GPIO_LED0_PORT, BSP_GPIO_LED0_PIN },
+  { BSP_GPIO_LED1_PORT, BSP_GPIO_LED1_PIN },
+};
+
+int BSP_LedsInit(void)
+{
+  int i;
+
+  for (i = 0; i < BSP_NO_OF_LEDS; i++) {
+    GPIO_PinModeSet(ledPins[i].port, ledPins[i].pin, gpioModePushPull, 0);
+  }
+  return BSP_STATUS_OK;
+}
+
+int BSP_LedClear(int ledNo)
+{
+  GPIO_PinOutClear(ledPins[ledNo].port, ledPins[ledNo].pin);
+  return BSP_STATUS_OK;
+}
+
+int BSP_LedSet(int ledNo)
+{
+  GPIO_PinOutSet(ledPins[ledNo].port, ledPins[ledNo].pin);
+  return BSP_STATUS_OK;
+}
+
+int BSP_LedToggle(int ledNo)
+{
+  GPIO_PinOutToggle(ledPins[ledNo].port, ledPins[ledNo].pin);
+  return BSP_STATUS_OK;
+}
+
+uint32_t BSP_LedsGet(void)
+{
+  uint32_t mask = 0;
+  int i;
+
+  for (i = 0; i < BSP_NO_OF_LEDS; i++) {
+    if (GPIO_PinOutGet(ledPins[i].port, ledPins[i].pin)) {
+      mask |= 1UL << i;
+    }
+  }
+  return mask;
+}
+
+int BSP_LedsSet(uint32_t ledMask)
+{
+  int i;
+
+  for (i = 0; i < BSP_NO_OF_LEDS; i++) {
+    if (ledMask & (1UL << i)) {
+      BSP_LedSet(i);
+    } else {
+      BSP_LedClear(i);
+    }
+  }
+  return BSP_STATUS_OK;
+}
@@ -0,0 +1,110 @@
+/**************************************************************************//**
+ * @file sim_pcnt.c
+ * @brief PCNT model: single input oversampling/external clock counting of a
+ *        PRS channel, with TOP reload and over/underflow flags.
+ *
+ * Pin inputs and quadrature decoding are not modelled.
+ *****************************************************************************/
+
+#include "hostsim_internal.h"
+
+PCNT_TypeDef simPCNT0;
+
+static unsigned long counted, overflows, underflows;
+
+static bool pcntCounting(void)
+{
+  uint32_t mode = (simPCNT0.CTRL & _PCNT_CTRL_MODE_MASK) >> _PCNT_CTRL_MODE_SHIFT;
+
+  return mode == _PCNT_CTRL_MODE_OVSSINGLE || mode == _PCNT_CTRL_MODE_EXTCLKSINGLE;
+}
+
+static void pcntCount(void)
+{
+  uint32_t cnt = simPCNT0.CNT;
+  uint32_t top = simPCNT0.TOP;
+
+  counted++;
+  if (simPCNT0.CTRL & PCNT_CTRL_CNTDIR) {
+    if (cnt == 0) {
+      cnt = top;
+      simPCNT0.IF |= PCNT_IF_UF;
+      underflows++;
+    } else {
+      cnt--;
+    }
+  } else {
+    if (cnt >= top) {
+      cnt = 0;
+      simPCNT0.IF |= PCNT_IF_OF;
+      overflows++;
+    } else {
+      cnt++;
+    }
+  }
+  simPCNT0.CNT = cnt;
+}
+
+void simPcntPrsInput(unsigned ch, int level)
+{
+  uint32_t input = simPCNT0.INPUT;
+  bool falling = (simPCNT0.CTRL & PCNT_CTRL_EDGE) != 0;
+
+  if (!pcntCounting() || !(input & PCNT_INPUT_S0PRSEN)
+      || ((input & _PCNT_INPUT_S0PRSSEL_MASK) >> _PCNT_INPUT_S0PRSSEL_SHIFT) != ch) {
+    return;
+  }
+  if ((level != 0) != falling) {
+    pcntCount();
+  }
+}
+
+void simPcntLoad(uint32_t counter, uint32_t top)
+{
+  simApiLock();
+  simPCNT0.CNT = counter;
+  simPCNT0.TOP = top;
+  simPCNT0.TOPB = top;
+  simApiUnlock();
+}
+
+static void pcntReset(void)
+{
+  simPCNT0.TOP = _PCNT_TOP_RESETVALUE;
+  simPCNT0.TOPB = _PCNT_TOPB_RESETVALUE;
+}
+
+static void pcntSync(void)
+{
+  uint32_t cmd = simTake(&simPCNT0.CMD);
+
+  if (cmd & PCNT_CMD_LCNTIM) {
+    simPCNT0.CNT = simPCNT0.TOPB;
+  }
+  if (cmd & PCNT_CMD_LTOPBIM) {
+    simPCNT0.TOP = simPCNT0.TOPB;
+  }
+  simPCNT0.SYNCBUSY = 0;
+  simPCNT0.IF |= simTake(&simPCNT0.IFS);
+  simPCNT0.IF &= ~simTake(&simPCNT0.IFC);
+}
+
+static uint64_t pcntNext(void)
+{
+  return SIM_NEVER;
+}
+
+static void pcntAdvance(void)
+{
+}
+
+static void pcntReport(FILE *out)
+{
+  if (counted) {
+    fprintf(out, "pcnt0: %lu counts, %lu OF, %lu UF\n", counted, overflows, underflows);
+  }
+}
+
+const struct simModel simPcntModel = {
+  "pcnt", pcntReset, pcntSync, pcntNext, pcntAdvance, pcntReport
+};
@@ -0,0 +1,145 @@
+/**************************************************************************//**
+ * @file sim_prs.c
+ * @brief PRS model: routes producer signals to the consumer peripherals.
+ *
+ * Producers report level changes (GPIO pins) or pulses (timer overflow, RTC
+ * compare) of their signals. A channel selecting that source and signal
+ * passes it on, through the edge detector when EDSEL asks for one, to the
+ * TIMER capture inputs and the PCNT. Pulse sources stand in for channels
+ * driven by hardware outside the model.
+ *****************************************************************************/
+
+#include <string.h>
+#include "hostsim_internal.h"
+
+PRS_TypeDef simPRS;
+
+static int channelLevel[PRS_CHAN_COUNT];
+static unsigned long channelEdges[PRS_CHAN_COUNT];
+
+static uint32_t generatorHz[PRS_CHAN_COUNT];
+static uint64_t generatorNext[PRS_CHAN_COUNT];
+
+static void channelSet(unsigned ch, int level)
+{
+  if (channelLevel[ch] == level) {
+    return;
+  }
+  channelLevel[ch] = level;
+  channelEdges[ch]++;
+  simTimerPrsInput(ch, level);
+  simPcntPrsInput(ch, level);
+}
+
+static void channelPulse(unsigned ch)
+{
+  channelSet(ch, 1);
+  channelSet(ch, 0);
+}
+
+void simPrsSignal(uint32_t source, uint32_t signal, int level)
+{
+  uint32_t ctrl, edsel;
+  unsigned ch;
+
+  for (ch = 0; ch < PRS_CHAN_COUNT; ch++) {
+    ctrl = simPRS.CH[ch].CTRL;
+    if ((ctrl & _PRS_CH_CTRL_SOURCESEL_MASK) != source
+        || (ctrl & _PRS_CH_CTRL_SIGSEL_MASK) != signal) {
+      continue;
+    }
+    edsel = (ctrl & _PRS_CH_CTRL_EDSEL_MASK) >> _PRS_CH_CTRL_EDSEL_SHIFT;
+    switch (edsel) {
+      case _PRS_CH_CTRL_EDSEL_OFF:
+        channelSet(ch, level);
+        break;
+      case _PRS_CH_CTRL_EDSEL_POSEDGE:
+        if (level) {
+          channelPulse(ch);
+        }
+        break;
+      case _PRS_CH_CTRL_EDSEL_NEGEDGE:
+        if (!level) {
+          channelPulse(ch);
+        }
+        break;
+      default:
+        channelPulse(ch);
+        break;
+    }
+  }
+}
+
+void simPrsPulse(uint32_t source, uint32_t signal)
+{
+  simPrsSignal(source, signal, 1);
+  simPrsSignal(source, signal, 0);
+}
+
+static void prsReset(void)
+{
+  memset(channelLevel, 0, sizeof(channelLevel));
+}
+
+static void prsSync(void)
+{
+  uint32_t pulses = simTake(&simPRS.SWPULSE);
+  unsigned ch;
+
+  for (ch = 0; pulses; ch++, pulses >>= 1) {
+    if (pulses & 1U) {
+      channelPulse(ch);
+    }
+  }
+}
+
+static uint64_t prsNext(void)
+{
+  uint64_t next = SIM_NEVER;
+  unsigned ch;
+
+  for (ch = 0; ch < PRS_CHAN_COUNT; ch++) {
+    if (generatorHz[ch] && generatorNext[ch] < next) {
+      next = generatorNext[ch];
+    }
+  }
+  return next;
+}
+
+static void prsAdvance(void)
+{
+  unsigned ch;
+
+  for (ch = 0; ch < PRS_CHAN_COUNT; ch++) {
+    if (generatorHz[ch] && generatorNext[ch] <= simNow) {
+      channelPulse(ch);
+      generatorNext[ch] = simNow + simCmuHfClock() / generatorHz[ch];
+    }
+  }
+}
+
+static void prsReport(FILE *out)
+{
+  unsigned ch;
+
+  for (ch = 0; ch < PRS_CHAN_COUNT; ch++) {
+    if (channelEdges[ch]) {
+      fprintf(out, "prs: ch%u %lu edges\n", ch, channelEdges[ch]);
+    }
+  }
+}
+
+const struct simModel simPrsModel = {
+  "prs", prsReset, prsSync, prsNext, prsAdvance, prsReport
+};
+
+void simPrsPulseSource(unsigned ch, uint32_t hz)
+{
+  if (ch >= PRS_CHAN_COUNT) {
+    return;
+  }
+  simApiLock();
+  generatorHz[ch] = hz;
+  generatorNext[ch] = hz ? simNow + simCmuHfClock() / hz : SIM_NEVER;
+  simApiUnlock();
+}
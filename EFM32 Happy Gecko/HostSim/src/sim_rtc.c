@@ -0,0 +1,199 @@
+/**************************************************************************//**
+ * @file sim_rtc.c
+ * @brief RTC model: 24 bit counter on LFACLK with two compare registers.
+ *
+ * The LFACLK phase is kept in units of 1/32768 HFCLK cycle, so a tick of the
+ * prescaled RTC clock is exactly HFCLK * 2^div units long and no drift
+ * builds up against HFCLK, whatever the HFRCO band.
+ *****************************************************************************/
+
+#include "hostsim_internal.h"
+
+RTC_TypeDef simRTC;
+
+#define LFA_HZ        32768ULL
+#define RTC_MAX       0xFFFFFFUL
+#define LOOKAHEAD     0x100000UL      /* ticks, keeps the 64 bit math safe */
+
+static uint64_t last;               /* cycle the phase refers to */
+static uint64_t phase;              /* units since the last tick */
+static uint32_t tickClock;          /* HFCLK the phase was measured with */
+static uint64_t ticks;
+static uint64_t clockedCycles;
+static unsigned long compare0, compare1, overflows;
+
+static bool rtcRunning(void)
+{
+  return (simRTC.CTRL & RTC_CTRL_EN) && simCmuLfaEnabled(CMU_LFACLKEN0_RTC);
+}
+
+static uint64_t tickUnits(void)
+{
+  return (uint64_t)simCmuHfClock() << simCmuRtcDivShift();
+}
+
+/* Length of the counter cycle the next ticks run in */
+static uint32_t modulus(void)
+{
+  if ((simRTC.CTRL & RTC_CTRL_COMP0TOP) && simRTC.CNT <= simRTC.COMP0) {
+    return simRTC.COMP0 + 1;
+  }
+  return RTC_MAX + 1;
+}
+
+static uint32_t distance(uint32_t target)
+{
+  uint32_t m = modulus();
+  uint32_t d;
+
+  if (target >= m) {
+    return m;
+  }
+  d = (target + m - simRTC.CNT) % m;
+  return d ? d : m;
+}
+
+static uint32_t ticksToEvent(void)
+{
+  uint32_t d = distance(simRTC.COMP0);
+  uint32_t d1 = distance(simRTC.COMP1);
+
+  if (d1 < d) {
+    d = d1;
+  }
+  if (modulus() == RTC_MAX + 1 && RTC_MAX + 1 - simRTC.CNT < d) {
+    d = RTC_MAX + 1 - simRTC.CNT;
+  }
+  return d;
+}
+
+static void rtcTick(void)
+{
+  uint32_t cnt = simRTC.CNT;
+
+  if ((simRTC.CTRL & RTC_CTRL_COMP0TOP) && cnt == simRTC.COMP0) {
+    cnt = 0;
+  } else if (cnt == RTC_MAX) {
+    cnt = 0;
+    simRTC.IF |= RTC_IF_OF;
+    overflows++;
+    simPrsPulse(PRS_CH_CTRL_SOURCESEL_RTC, PRS_CH_CTRL_SIGSEL_RTCOF);
+  } else {
+    cnt++;
+  }
+  simRTC.CNT = cnt;
+
+  if (cnt == simRTC.COMP0) {
+    simRTC.IF |= RTC_IF_COMP0;
+    compare0++;
+    simPrsPulse(PRS_CH_CTRL_SOURCESEL_RTC, PRS_CH_CTRL_SIGSEL_RTCCOMP0);
+  }
+  if (cnt == simRTC.COMP1) {
+    simRTC.IF |= RTC_IF_COMP1;
+    compare1++;
+    simPrsPulse(PRS_CH_CTRL_SOURCESEL_RTC, PRS_CH_CTRL_SIGSEL_RTCCOMP1);
+  }
+}
+
+/* Bring the counter up to simNow */
+static void rtcCatchUp(void)
+{
+  uint64_t units, n;
+  uint32_t d, m;
+
+  if (!rtcRunning()) {
+    last = simNow;
+    phase = 0;
+    return;
+  }
+  if (tickClock != simCmuHfClock()) {
+    /* HFCLK changed, the phase keeps its fraction of a tick */
+    if (tickClock) {
+      phase = phase * simCmuHfClock() / tickClock;
+    }
+    tickClock = simCmuHfClock();
+  }
+
+  clockedCycles += simNow - last;
+  phase += (simNow - last) * LFA_HZ;
+  last = simNow;
+  units = tickUnits();
+  n = phase / units;
+  phase %= units;
+  ticks += n;
+
+  while (n) {
+    d = ticksToEvent();
+    if (n >= d) {
+      m = modulus();
+      simRTC.CNT = (simRTC.CNT + d - 1) % m;
+      rtcTick();
+      n -= d;
+    } else {
+      simRTC.CNT = (uint32_t)((simRTC.CNT + n) % modulus());
+      n = 0;
+    }
+  }
+}
+
+static void rtcReset(void)
+{
+  last = 0;
+  phase = 0;
+  tickClock = simCmuHfClock();
+}
+
+static void rtcSync(void)
+{
+  simRTC.IF |= simTake(&simRTC.IFS);
+  simRTC.IF &= ~simTake(&simRTC.IFC);
+  simRTC.SYNCBUSY = 0;
+  if (!rtcRunning()) {
+    last = simNow;
+    phase = 0;
+  }
+}
+
+static uint64_t rtcNext(void)
+{
+  uint64_t units, need;
+  uint32_t n;
+
+  if (!rtcRunning()) {
+    return SIM_NEVER;
+  }
+  n = ticksToEvent();
+  if (n > LOOKAHEAD) {
+    n = LOOKAHEAD;
+  }
+  units = tickUnits();
+  need = n * units - phase;
+  return last + (need + LFA_HZ - 1) / LFA_HZ;
+}
+
+static void rtcAdvance(void)
+{
+  rtcCatchUp();
+}
+
+static void rtcReport(FILE *out)
+{
+  if (ticks || clockedCycles) {
+    fprintf(out, "rtc: %llu ticks, clock on %llu cycles, %lu COMP0, %lu COMP1, %lu OF\n",
+            (unsigned long long)ticks, (unsigned long long)clockedCycles,
+            compare0, compare1, overflows);
+  }
+}
+
+const struct simModel simRtcModel = {
+  "rtc", rtcReset, rtcSync, rtcNext, rtcAdvance, rtcReport
+};
+
+void simRtcCounterReset(void)
+{
+  simApiLock();
+  rtcCatchUp();
+  simRTC.CNT = 0;
+  phase = 0;
+  simApiUnlock();
+}
@@ -0,0 +1,778 @@
+/**************************************************************************//**
+ * @file sim_timer.c
+ * @brief TIMER model: up, down and up/down counting, compare/PWM outputs,
+ *        input capture from PRS, input actions, quadrature decoding of PRS
+ *        inputs, counting CC1 input edges, cascading and the TIMER0
+ *        dead-time insertion unit.
+ *
+ * Counting is done in bulk between events; an event is any tick where the
+ * counter wraps, turns or hits an active compare value. Outputs are not
+ * routed to pins, they are visible through simTimerOutput() and the trace.
+ * With DTI enabled the trace shows the output pairs after dead-time
+ * insertion, TIMER0.CCn and TIMER0.CDTIn, instead of the compare outputs;
+ * PRS fault sources force them to the fault action until DTFAULTC.
+ *****************************************************************************/
+
+#include <string.h>
+#include "hostsim_internal.h"
+
+#define CC_COUNT  3
+
+TIMER_TypeDef simTIMER[TIMER_COUNT];
+
+struct timerInfo {
+  uint32_t clockBit;
+  uint32_t dmaUfof;
+  uint32_t dmaCc[CC_COUNT];
+  uint32_t prsSource;
+  uint32_t prsUf;
+  uint32_t prsOf;
+  uint32_t prsCc[CC_COUNT];
+};
+
+static const struct timerInfo info[] = {
+  { CMU_HFPERCLKEN0_TIMER0,
+    DMAREQ_TIMER0_UFOF, { DMAREQ_TIMER0_CC0, DMAREQ_TIMER0_CC1, DMAREQ_TIMER0_CC2 },
+    PRS_CH_CTRL_SOURCESEL_TIMER0, PRS_CH_CTRL_SIGSEL_TIMER0UF, PRS_CH_CTRL_SIGSEL_TIMER0OF,
+    { PRS_CH_CTRL_SIGSEL_TIMER0CC0, PRS_CH_CTRL_SIGSEL_TIMER0CC1, PRS_CH_CTRL_SIGSEL_TIMER0CC2 } },
+  { CMU_HFPERCLKEN0_TIMER1,
+    DMAREQ_TIMER1_UFOF, { DMAREQ_TIMER1_CC0, DMAREQ_TIMER1_CC1, DMAREQ_TIMER1_CC2 },
+    PRS_CH_CTRL_SOURCESEL_TIMER1, PRS_CH_CTRL_SIGSEL_TIMER1UF, PRS_CH_CTRL_SIGSEL_TIMER1OF,
+    { PRS_CH_CTRL_SIGSEL_TIMER1CC0, PRS_CH_CTRL_SIGSEL_TIMER1CC1, PRS_CH_CTRL_SIGSEL_TIMER1CC2 } },
+#if TIMER_COUNT > 2
+  { CMU_HFPERCLKEN0_TIMER2,
+    DMAREQ_TIMER2_UFOF, { DMAREQ_TIMER2_CC0, DMAREQ_TIMER2_CC1, DMAREQ_TIMER2_CC2 },
+    PRS_CH_CTRL_SOURCESEL_TIMER2, PRS_CH_CTRL_SIGSEL_TIMER2UF, PRS_CH_CTRL_SIGSEL_TIMER2OF,
+    { PRS_CH_CTRL_SIGSEL_TIMER2CC0, PRS_CH_CTRL_SIGSEL_TIMER2CC1, PRS_CH_CTRL_SIGSEL_TIMER2CC2 } },
+#endif
+};
+
+struct simTimer {
+  TIMER_TypeDef *regs;
+  bool          running;
+  bool          down;         /* up/down mode counting down */
+  uint64_t      last;         /* cycle of the last tick */
+  uint32_t      ctrl;         /* CTRL the tick period was derived from */
+  uint32_t      topb;         /* TOPB/CCVB as last seen, a change sets the valid bit */
+  uint32_t      ccvb[CC_COUNT];
+  bool          topbValid;
+  bool          ccvbValid[CC_COUNT];
+  int           out[CC_COUNT];
+  unsigned      secondEdge[CC_COUNT];
+  int           qdecIn[2];    /* quadrature decoder channels A (CC0) and B (CC1) */
+  bool          dtiOn;        /* DTEN as last seen */
+  unsigned      dtiActive[CC_COUNT];  /* 0 none, 1 the CC output, 2 the CDTI output */
+  uint64_t      dtiAt[CC_COUNT];      /* the other output turns on, SIM_NEVER if not */
+  int           dtiPin[CC_COUNT][2];
+
+  uint64_t      ticks;
+  uint64_t      runningCycles;
+  unsigned long overflows, underflows, ccEvents[CC_COUNT], captures;
+  unsigned long outputEdges[CC_COUNT];
+  unsigned long dtiFaults;
+};
+
+static struct simTimer timers[TIMER_COUNT];
+
+static uint32_t field(uint32_t reg, uint32_t mask, uint32_t shift)
+{
+  return (reg & mask) >> shift;
+}
+
+static bool timerClocked(const struct simTimer *t)
+{
+  return simCmuHfperEnabled(info[t - timers].clockBit) && simHfDomainRunning();
+}
+
+static bool timerCascaded(const struct simTimer *t)
+{
+  return field(t->regs->CTRL, _TIMER_CTRL_CLKSEL_MASK, _TIMER_CTRL_CLKSEL_SHIFT)
+         == _TIMER_CTRL_CLKSEL_TIMEROUF;
+}
+
+static uint64_t timerPeriod(const struct simTimer *t)
+{
+  return (uint64_t)1 << (field(t->regs->CTRL, _TIMER_CTRL_PRESC_MASK, _TIMER_CTRL_PRESC_SHIFT)
+                         + simCmuHfperDivShift());
+}
+
+static uint32_t timerMode(const struct simTimer *t)
+{
+  return field(t->regs->CTRL, _TIMER_CTRL_MODE_MASK, _TIMER_CTRL_MODE_SHIFT);
+}
+
+static uint32_t ccMode(const struct simTimer *t, unsigned cc)
+{
+  return field(t->regs->CC[cc].CTRL, _TIMER_CC_CTRL_MODE_MASK, _TIMER_CC_CTRL_MODE_SHIFT);
+}
+
+static bool timerCc1Clocked(const struct simTimer *t)
+{
+  return field(t->regs->CTRL, _TIMER_CTRL_CLKSEL_MASK, _TIMER_CTRL_CLKSEL_SHIFT)
+         == _TIMER_CTRL_CLKSEL_CC1;
+}
+
+/* Counted by the timer below, the CC1 input or the decoder inputs, not by
+ * a clock */
+static bool timerUnclocked(const struct simTimer *t)
+{
+  return timerCascaded(t) || timerCc1Clocked(t) || timerMode(t) == _TIMER_CTRL_MODE_QDEC;
+}
+
+/*******************************************************************************
+ ***************************   DEAD-TIME INSERTION   ***************************
+ ******************************************************************************/
+
+static bool dtiEnabled(const struct simTimer *t)
+{
+  return t == &timers[0] && (t->regs->DTCTRL & TIMER_DTCTRL_DTEN);
+}
+
+static uint64_t dtiDelay(const struct simTimer *t, bool rise)
+{
+  uint32_t dttime = t->regs->DTTIME;
+  uint32_t n = rise ? field(dttime, _TIMER_DTTIME_DTRISET_MASK, _TIMER_DTTIME_DTRISET_SHIFT)
+                    : field(dttime, _TIMER_DTTIME_DTFALLT_MASK, _TIMER_DTTIME_DTFALLT_SHIFT);
+
+  return (uint64_t)(n + 1) << (field(dttime, _TIMER_DTTIME_DTPRESC_MASK, _TIMER_DTTIME_DTPRESC_SHIFT)
+                               + simCmuHfperDivShift());
+}
+
+/* Pin levels of an output pair from its state, polarity and fault action;
+ * a tristated pin is traced as -1 */
+static void dtiDrive(struct simTimer *t, unsigned cc)
+{
+  static const char *const pinName[2] = { "CC", "CDTI" };
+  const TIMER_TypeDef *r = t->regs;
+  uint32_t enable[2] = { TIMER_DTOGEN_DTOGCC0EN << cc, TIMER_DTOGEN_DTOGCDTI0EN << cc };
+  uint32_t action = r->DTFAULT ? field(r->DTFC, _TIMER_DTFC_DTFA_MASK, _TIMER_DTFC_DTFA_SHIFT)
+                               : _TIMER_DTFC_DTFA_NONE;
+  char name[16];
+  int level;
+  unsigned k;
+
+  for (k = 0; k < 2; k++) {
+    level = t->dtiActive[cc] == k + 1 && action != _TIMER_DTFC_DTFA_INACTIVE;
+    level ^= (r->DTCTRL & TIMER_DTCTRL_DTIPOL) ? 1 : 0;
+    if (k == 1) {
+      level ^= (r->DTCTRL & TIMER_DTCTRL_DTCINV) ? 1 : 0;
+    }
+    if (action == _TIMER_DTFC_DTFA_CLEAR) {
+      level = 0;
+    } else if (action == _TIMER_DTFC_DTFA_TRISTATE) {
+      level = -1;
+    }
+
+    if (!(r->DTOGEN & enable[k]) || t->dtiPin[cc][k] == level) {
+      continue;
+    }
+    t->dtiPin[cc][k] = level;
+    snprintf(name, sizeof(name), "TIMER%u.%s%u", (unsigned)(t - timers), pinName[k], cc);
+    simTrace(name, level);
+  }
+}
+
+/* The compare output changed: the active output turns off at once, the
+ * other one turns on after the dead time. A pulse shorter than the dead
+ * time never reaches a pin. */
+static void dtiInput(struct simTimer *t, unsigned cc)
+{
+  t->dtiActive[cc] = 0;
+  t->dtiAt[cc] = simNow + dtiDelay(t, t->out[cc] != 0);
+  dtiDrive(t, cc);
+}
+
+static void dtiAdvance(struct simTimer *t)
+{
+  unsigned cc;
+
+  for (cc = 0; cc < CC_COUNT; cc++) {
+    if (t->dtiAt[cc] <= simNow) {
+      t->dtiAt[cc] = SIM_NEVER;
+      t->dtiActive[cc] = t->out[cc] ? 1 : 2;
+      dtiDrive(t, cc);
+    }
+  }
+}
+
+static void dtiFault(struct simTimer *t, uint32_t flag)
+{
+  unsigned cc;
+
+  if (t->regs->DTFAULT & flag) {
+    return;
+  }
+  t->regs->DTFAULT |= flag;
+  t->dtiFaults++;
+  for (cc = 0; cc < CC_COUNT; cc++) {
+    dtiDrive(t, cc);
+  }
+}
+
+/* Enable, disable and fault clear as written by the application */
+static void dtiSync(struct simTimer *t)
+{
+  TIMER_TypeDef *r = t->regs;
+  uint32_t clear = simTake(&r->DTFAULTC);
+  bool on = dtiEnabled(t);
+  bool restart = false;
+  unsigned cc;
+
+  if (r->DTFAULT & clear) {
+    r->DTFAULT &= ~clear;
+    restart = r->DTFAULT == 0;
+  }
+  if (on != t->dtiOn) {
+    t->dtiOn = on;
+    restart = on;
+  }
+  for (cc = 0; cc < CC_COUNT; cc++) {
+    if (!on) {
+      t->dtiAt[cc] = SIM_NEVER;
+    } else if (restart) {
+      dtiInput(t, cc);
+    }
+  }
+}
+
+/*******************************************************************************
+ ***************************   COUNTING   **************************************
+ ******************************************************************************/
+
+static void setOutput(struct simTimer *t, unsigned cc, int level)
+{
+  char name[16];
+
+  if (t->regs->CC[cc].CTRL & TIMER_CC_CTRL_OUTINV) {
+    level = !level;
+  }
+  if (t->out[cc] == level) {
+    return;
+  }
+  t->out[cc] = level;
+  t->outputEdges[cc]++;
+  if (dtiEnabled(t)) {
+    dtiInput(t, cc);
+    return;
+  }
+  snprintf(name, sizeof(name), "TIMER%u.CC%u", (unsigned)(t - timers), cc);
+  simTrace(name, level);
+}
+
+/* Output action: none, toggle, clear, set */
+static void outputAction(struct simTimer *t, unsigned cc, uint32_t action)
+{
+  int current = t->out[cc];
+
+  if (t->regs->CC[cc].CTRL & TIMER_CC_CTRL_OUTINV) {
+    current = !current;
+  }
+  switch (action) {
+    case _TIMER_CC_CTRL_CMOA_TOGGLE: setOutput(t, cc, !current); break;
+    case _TIMER_CC_CTRL_CMOA_CLEAR:  setOutput(t, cc, 0);        break;
+    case _TIMER_CC_CTRL_CMOA_SET:    setOutput(t, cc, 1);        break;
+    default:                                                     break;
+  }
+}
+
+static void timerTick(struct simTimer *t);
+
+static void updateEvent(struct simTimer *t, bool overflow)
+{
+  TIMER_TypeDef *r = t->regs;
+  unsigned i = (unsigned)(t - timers);
+  unsigned cc;
+  uint32_t ctrl;
+
+  if (overflow) {
+    r->IF |= TIMER_IF_OF;
+    t->overflows++;
+    simPrsPulse(info[i].prsSource, info[i].prsOf);
+  } else {
+    r->IF |= TIMER_IF_UF;
+    t->underflows++;
+    simPrsPulse(info[i].prsSource, info[i].prsUf);
+  }
+  simDmaRequest(info[i].dmaUfof);
+
+  /* Buffered values take effect on the update event */
+  if (t->topbValid) {
+    r->TOP = r->TOPB;
+    t->topbValid = false;
+  }
+  for (cc = 0; cc < CC_COUNT; cc++) {
+    if (t->ccvbValid[cc]) {
+      r->CC[cc].CCV = r->CC[cc].CCVB;
+      t->ccvbValid[cc] = false;
+    }
+    ctrl = r->CC[cc].CTRL;
+    if (ccMode(t, cc) == _TIMER_CC_CTRL_MODE_PWM) {
+      if (timerMode(t) != _TIMER_CTRL_MODE_UPDOWN) {
+        setOutput(t, cc, 1);
+      }
+    } else if (ccMode(t, cc) == _TIMER_CC_CTRL_MODE_OUTPUTCOMPARE) {
+      outputAction(t, cc, overflow
+                   ? field(ctrl, _TIMER_CC_CTRL_COFOA_MASK, _TIMER_CC_CTRL_COFOA_SHIFT)
+                   : field(ctrl, _TIMER_CC_CTRL_CUFOA_MASK, _TIMER_CC_CTRL_CUFOA_SHIFT));
+    }
+  }
+
+  if (r->CTRL & TIMER_CTRL_OSMEN) {
+    t->running = false;
+  }
+  if (i + 1 < TIMER_COUNT && timers[i + 1].running && timerCascaded(&timers[i + 1])) {
+    timerTick(&timers[i + 1]);
+  }
+}
+
+static void compareEvents(struct simTimer *t, uint32_t cnt)
+{
+  TIMER_TypeDef *r = t->regs;
+  unsigned i = (unsigned)(t - timers);
+  unsigned cc;
+  uint32_t mode;
+
+  for (cc = 0; cc < CC_COUNT; cc++) {
+    mode = ccMode(t, cc);
+    if ((mode != _TIMER_CC_CTRL_MODE_OUTPUTCOMPARE && mode != _TIMER_CC_CTRL_MODE_PWM)
+        || (r->CC[cc].CCV & 0xFFFFU) != cnt) {
+      continue;
+    }
+    r->IF |= TIMER_IF_CC0 << cc;
+    t->ccEvents[cc]++;
+    simPrsPulse(info[i].prsSource, info[i].prsCc[cc]);
+    simDmaRequest(info[i].dmaCc[cc]);
+    if (mode == _TIMER_CC_CTRL_MODE_PWM) {
+      /* Up/down PWM is set when matching on the way down */
+      setOutput(t, cc, timerMode(t) == _TIMER_CTRL_MODE_UPDOWN && t->down);
+    } else {
+      outputAction(t, cc, field(r->CC[cc].CTRL, _TIMER_CC_CTRL_CMOA_MASK,
+                                _TIMER_CC_CTRL_CMOA_SHIFT));
+    }
+  }
+}
+
+/* One counter clock with all its side effects */
+static void timerTick(struct simTimer *t)
+{
+  TIMER_TypeDef *r = t->regs;
+  uint32_t cnt = r->CNT & 0xFFFFU;
+  uint32_t top = r->TOP & 0xFFFFU;
+  int update = 0;
+
+  t->ticks++;
+  switch (timerMode(t)) {
+    case _TIMER_CTRL_MODE_DOWN:
+      if (cnt == 0) {
+        cnt = top;
+        update = -1;
+      } else {
+        cnt--;
+      }
+      break;
+
+    case _TIMER_CTRL_MODE_UPDOWN:
+      if (t->down) {
+        cnt = cnt ? cnt - 1 : 0;
+        if (cnt == 0) {
+          t->down = false;
+          update = -1;
+        }
+      } else {
+        cnt = (cnt + 1) & 0xFFFFU;
+        if (cnt >= top) {
+          cnt = top;
+          t->down = true;
+          update = 1;
+        }
+      }
+      break;
+
+    default:
+      if (cnt == top) {
+        cnt = 0;
+        update = 1;
+      } else {
+        cnt = (cnt + 1) & 0xFFFFU;
+      }
+      break;
+  }
+  r->CNT = cnt;
+  r->STATUS = (r->STATUS & ~TIMER_STATUS_DIR) | (t->down || timerMode(t) == _TIMER_CTRL_MODE_DOWN
+                                                  ? TIMER_STATUS_DIR : 0);
+
+  if (update) {
+    updateEvent(t, update > 0);
+  }
+  compareEvents(t, cnt);
+}
+
+/* Ticks until the next tick that does more than count */
+static uint32_t ticksToEvent(const struct simTimer *t)
+{
+  const TIMER_TypeDef *r = t->regs;
+  uint32_t cnt = r->CNT & 0xFFFFU;
+  uint32_t top = r->TOP & 0xFFFFU;
+  uint32_t d, ccv, mode;
+  unsigned cc;
+
+  switch (timerMode(t)) {
+    case _TIMER_CTRL_MODE_DOWN:
+      d = cnt + 1;
+      break;
+    case _TIMER_CTRL_MODE_UPDOWN:
+      d = t->down ? (cnt ? cnt : 1) : (cnt < top ? top - cnt : 1);
+      break;
+    default:
+      d = cnt <= top ? top - cnt + 1 : 0x10000U - cnt;
+      break;
+  }
+
+  for (cc = 0; cc < CC_COUNT; cc++) {
+    mode = ccMode(t, cc);
+    if (mode != _TIMER_CC_CTRL_MODE_OUTPUTCOMPARE && mode != _TIMER_CC_CTRL_MODE_PWM) {
+      continue;
+    }
+    ccv = r->CC[cc].CCV & 0xFFFFU;
+    if ((timerMode(t) == _TIMER_CTRL_MODE_DOWN || t->down) ? ccv < cnt : ccv > cnt) {
+      uint32_t dcc = ccv > cnt ? ccv - cnt : cnt - ccv;
+      if (dcc < d) {
+        d = dcc;
+      }
+    }
+  }
+  return d ? d : 1;
+}
+
+static void countBulk(struct simTimer *t, uint32_t n)
+{
+  TIMER_TypeDef *r = t->regs;
+
+  t->ticks += n;
+  if (timerMode(t) == _TIMER_CTRL_MODE_DOWN || t->down) {
+    r->CNT = (r->CNT - n) & 0xFFFFU;
+  } else {
+    r->CNT = (r->CNT + n) & 0xFFFFU;
+  }
+}
+
+static void timerCatchUp(struct simTimer *t)
+{
+  uint64_t period, n;
+  uint32_t d;
+
+  if (!t->running || !timerClocked(t)) {
+    t->last = simNow;
+    return;
+  }
+  t->runningCycles += simNow - t->last;
+  if (timerUnclocked(t)) {
+    t->last = simNow;
+    return;
+  }
+  period = timerPeriod(t);
+  n = (simNow - t->last) / period;
+  t->last += n * period;
+
+  while (n && t->running) {
+    d = ticksToEvent(t);
+    if (n >= d) {
+      countBulk(t, d - 1);
+      timerTick(t);
+      n -= d;
+    } else {
+      countBulk(t, (uint32_t)n);
+      n = 0;
+    }
+  }
+}
+
+static void timerStart(struct simTimer *t)
+{
+  if (!t->running) {
+    t->running = true;
+    t->last = simNow;
+  }
+}
+
+/*******************************************************************************
+ ***************************   INPUTS   ****************************************
+ ******************************************************************************/
+
+static void inputAction(struct simTimer *t, uint32_t action)
+{
+  switch (action) {
+    case _TIMER_CTRL_RISEA_START:
+      timerStart(t);
+      break;
+    case _TIMER_CTRL_RISEA_STOP:
+      t->running = false;
+      break;
+    case _TIMER_CTRL_RISEA_RELOADSTART:
+      t->regs->CNT = timerMode(t) == _TIMER_CTRL_MODE_DOWN ? t->regs->TOP : 0;
+      t->down = false;
+      t->running = false;
+      timerStart(t);
+      break;
+    default:
+      break;
+  }
+}
+
+static void captureEdge(struct simTimer *t, unsigned cc, int rising)
+{
+  TIMER_TypeDef *r = t->regs;
+  uint32_t ctrl = r->CC[cc].CTRL;
+  uint32_t edge = field(ctrl, _TIMER_CC_CTRL_ICEDGE_MASK, _TIMER_CC_CTRL_ICEDGE_SHIFT);
+  uint32_t event = field(ctrl, _TIMER_CC_CTRL_ICEVCTRL_MASK, _TIMER_CC_CTRL_ICEVCTRL_SHIFT);
+  bool flag;
+
+  if (edge == _TIMER_CC_CTRL_ICEDGE_NONE
+      || (edge == _TIMER_CC_CTRL_ICEDGE_RISING && !rising)
+      || (edge == _TIMER_CC_CTRL_ICEDGE_FALLING && rising)) {
+    return;
+  }
+
+  if (r->STATUS & (TIMER_STATUS_ICV0 << cc)) {
+    r->IF |= TIMER_IF_ICBOF0 << cc;
+  }
+  r->CC[cc].CCVP = r->CC[cc].CCV;
+  r->CC[cc].CCV = r->CNT;
+  r->STATUS |= TIMER_STATUS_ICV0 << cc;
+  t->captures++;
+
+  switch (event) {
+    case _TIMER_CC_CTRL_ICEVCTRL_EVERYSECONDEDGE:
+      flag = (++t->secondEdge[cc] & 1U) == 0;
+      break;
+    case _TIMER_CC_CTRL_ICEVCTRL_RISING:
+      flag = rising;
+      break;
+    case _TIMER_CC_CTRL_ICEVCTRL_FALLING:
+      flag = !rising;
+      break;
+    default:
+      flag = true;
+      break;
+  }
+  if (flag) {
+    r->IF |= TIMER_IF_CC0 << cc;
+    t->ccEvents[cc]++;
+    simDmaRequest(info[t - timers].dmaCc[cc]);
+  }
+}
+
+/* Quadrature decoder: X2 counts the edges of A, X4 those of A and B.
+ * A leading B counts up. */
+static void qdecEdge(struct simTimer *t, unsigned cc, int level)
+{
+  TIMER_TypeDef *r = t->regs;
+  uint32_t cnt = r->CNT & 0xFFFFU;
+  uint32_t top = r->TOP & 0xFFFFU;
+  int update = 0;
+  bool up;
+
+  t->qdecIn[cc] = level;
+  if (!t->running || (cc == 1 && !(r->CTRL & TIMER_CTRL_QDM_X4))) {
+    return;
+  }
+  up = cc == 0 ? t->qdecIn[0] != t->qdecIn[1] : t->qdecIn[0] == t->qdecIn[1];
+
+  t->ticks++;
+  if (up) {
+    if (cnt >= top) {
+      cnt = 0;
+      update = 1;
+    } else {
+      cnt++;
+    }
+  } else if (cnt == 0) {
+    cnt = top;
+    update = -1;
+  } else {
+    cnt--;
+  }
+  t->down = !up;
+  r->CNT = cnt;
+  r->STATUS = (r->STATUS & ~TIMER_STATUS_DIR) | (up ? 0 : TIMER_STATUS_DIR);
+
+  if (update) {
+    updateEvent(t, update > 0);
+  }
+  compareEvents(t, cnt);
+}
+
+void simTimerPrsInput(unsigned ch, int level)
+{
+  struct simTimer *t;
+  uint32_t ctrl, dtfc;
+  unsigned cc;
+
+  for (t = timers; t < &timers[TIMER_COUNT]; t++) {
+    if (!simCmuHfperEnabled(info[t - timers].clockBit)) {
+      continue;
+    }
+    dtfc = t->regs->DTFC;
+    if (level && dtiEnabled(t)) {
+      if ((dtfc & TIMER_DTFC_DTPRS0FEN)
+          && field(dtfc, _TIMER_DTFC_DTPRS0FSEL_MASK, _TIMER_DTFC_DTPRS0FSEL_SHIFT) == ch) {
+        dtiFault(t, TIMER_DTFAULT_DTPRS0F);
+      }
+      if ((dtfc & TIMER_DTFC_DTPRS1FEN)
+          && field(dtfc, _TIMER_DTFC_DTPRS1FSEL_MASK, _TIMER_DTFC_DTPRS1FSEL_SHIFT) == ch) {
+        dtiFault(t, TIMER_DTFAULT_DTPRS1F);
+      }
+    }
+    for (cc = 0; cc < CC_COUNT; cc++) {
+      ctrl = t->regs->CC[cc].CTRL;
+      if (!(ctrl & TIMER_CC_CTRL_INSEL)
+          || field(ctrl, _TIMER_CC_CTRL_PRSSEL_MASK, _TIMER_CC_CTRL_PRSSEL_SHIFT) != ch) {
+        continue;
+      }
+      timerCatchUp(t);
+      if (ccMode(t, cc) == _TIMER_CC_CTRL_MODE_INPUTCAPTURE) {
+        captureEdge(t, cc, level);
+      }
+      if (cc < 2 && timerMode(t) == _TIMER_CTRL_MODE_QDEC) {
+        qdecEdge(t, cc, level);
+      } else if (cc == 1 && level && t->running && timerCc1Clocked(t)) {
+        timerTick(t);
+      }
+      if (cc == 0) {
+        inputAction(t, level
+                    ? field(t->regs->CTRL, _TIMER_CTRL_RISEA_MASK, _TIMER_CTRL_RISEA_SHIFT)
+                    : field(t->regs->CTRL, _TIMER_CTRL_FALLA_MASK, _TIMER_CTRL_FALLA_SHIFT));
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+ ***************************   MODEL   *****************************************
+ ******************************************************************************/
+
+static void timerReset(void)
+{
+  unsigned i, cc;
+
+  memset(timers, 0, sizeof(timers));
+  for (i = 0; i < TIMER_COUNT; i++) {
+    timers[i].regs = &simTIMER[i];
+    simTIMER[i].TOP = _TIMER_TOP_RESETVALUE;
+    for (cc = 0; cc < CC_COUNT; cc++) {
+      timers[i].dtiAt[cc] = SIM_NEVER;
+    }
+  }
+}
+
+static void timerSync(void)
+{
+  struct simTimer *t;
+  TIMER_TypeDef *r;
+  uint32_t cmd;
+  unsigned cc;
+
+  for (t = timers; t < &timers[TIMER_COUNT]; t++) {
+    r = t->regs;
+    timerCatchUp(t);
+
+    cmd = simTake(&r->CMD);
+    if (cmd & TIMER_CMD_STOP) {
+      t->running = false;
+    }
+    if (cmd & TIMER_CMD_START) {
+      timerStart(t);
+    }
+    if (r->CTRL != t->ctrl) {
+      /* A new prescaler starts counting from here */
+      t->ctrl = r->CTRL;
+      t->last = simNow;
+    }
+
+    if (r->TOPB != t->topb) {
+      t->topb = r->TOPB;
+      t->topbValid = true;
+    }
+    for (cc = 0; cc < CC_COUNT; cc++) {
+      if (r->CC[cc].CCVB != t->ccvb[cc]) {
+        t->ccvb[cc] = r->CC[cc].CCVB;
+        t->ccvbValid[cc] = true;
+      }
+    }
+
+    dtiSync(t);
+
+    r->STATUS = (r->STATUS & ~(TIMER_STATUS_RUNNING | TIMER_STATUS_TOPBV))
+                | (t->running ? TIMER_STATUS_RUNNING : 0)
+                | (t->topbValid ? TIMER_STATUS_TOPBV : 0);
+    r->IF |= simTake(&r->IFS);
+    r->IF &= ~simTake(&r->IFC);
+  }
+}
+
+static uint64_t timerNext(void)
+{
+  struct simTimer *t;
+  uint64_t next = SIM_NEVER, n;
+  unsigned cc;
+
+  for (t = timers; t < &timers[TIMER_COUNT]; t++) {
+    for (cc = 0; cc < CC_COUNT; cc++) {
+      if (t->dtiAt[cc] < next) {
+        next = t->dtiAt[cc];
+      }
+    }
+    if (!t->running || !timerClocked(t) || timerUnclocked(t)) {
+      continue;
+    }
+    n = t->last + ticksToEvent(t) * timerPeriod(t);
+    if (n < next) {
+      next = n;
+    }
+  }
+  return next;
+}
+
+static void timerAdvance(void)
+{
+  struct simTimer *t;
+
+  for (t = timers; t < &timers[TIMER_COUNT]; t++) {
+    dtiAdvance(t);
+    timerCatchUp(t);
+  }
+}
+
+static void timerReport(FILE *out)
+{
+  struct simTimer *t;
+  unsigned cc;
+
+  for (t = timers; t < &timers[TIMER_COUNT]; t++) {
+    if (!t->ticks && !t->captures) {
+      continue;
+    }
+    fprintf(out, "timer%u: %llu ticks, running %llu cycles, %lu OF, %lu UF, %lu captures",
+            (unsigned)(t - timers), (unsigned long long)t->ticks,
+            (unsigned long long)t->runningCycles, t->overflows, t->underflows, t->captures);
+    for (cc = 0; cc < CC_COUNT; cc++) {
+      if (t->ccEvents[cc] || t->outputEdges[cc]) {
+        fprintf(out, ", CC%u %lu events %lu output edges", cc, t->ccEvents[cc],
+                t->outputEdges[cc]);
+      }
+    }
+    if (t->dtiFaults) {
+      fprintf(out, ", %lu DTI faults", t->dtiFaults);
+    }
+    fprintf(out, "\n");
+  }
+}
+
+const struct simModel simTimerModel = {
+  "timer", timerReset, timerSync, timerNext, timerAdvance, timerReport
+};
+
+int simTimerOutput(unsigned timer, unsigned cc)
+{
+  return (timer < TIMER_COUNT && cc < CC_COUNT) ? timers[timer].out[cc] : 0;
+}
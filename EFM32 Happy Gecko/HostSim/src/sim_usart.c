@@ -0,0 +1,227 @@
+/**************************************************************************//**
+ * @file sim_usart.c
+ * @brief USART model: the transmitter, byte timing from CLKDIV, the TX
+ *        buffer level DMA request and the TXBL/TXC flags.
+ *
+ * The TX buffer holds one byte besides the shift register. CPU writes to
+ * TXDATA are seen on sync, a bit the chip does not have marks the register
+ * as read; DMA writes are passed on by the DMA model. Frames are 8 data
+ * bits, synchronous mode bits take 2 and asynchronous ones 16 (x16
+ * oversampling) prescaled clocks, with start and stop bit. The receiver and
+ * the pins are not modelled.
+ *****************************************************************************/
+
+#include <string.h>
+#include "hostsim_internal.h"
+
+USART_TypeDef simUSART0;
+USART_TypeDef simUSART1;
+
+#define TXDATA_IDLE     0x80000000UL
+
+/* Requests served in one go, enough to refill buffer and shift register
+ * with scatter-gather descriptor fetches in between */
+#define REQUEST_BURST   8
+
+struct usartInfo {
+  USART_TypeDef *regs;
+  uint32_t      clockBit;
+  uint32_t      dmaTxbl;
+};
+
+static const struct usartInfo info[] = {
+  { &simUSART0, CMU_HFPERCLKEN0_USART0, DMAREQ_USART0_TXBL },
+  { &simUSART1, CMU_HFPERCLKEN0_USART1, DMAREQ_USART1_TXBL },
+};
+
+#define USART_MODELS  (sizeof(info) / sizeof(info[0]))
+
+struct simUsart {
+  bool          txEnabled;
+  bool          buffered;     /* byte waiting in the TX buffer */
+  bool          shifting;
+  uint64_t      shiftEnd;
+  unsigned long bytes, overflows;
+  uint64_t      busyCycles;
+};
+
+static struct simUsart usarts[USART_MODELS];
+
+static bool usartClocked(unsigned i)
+{
+  return simCmuHfperEnabled(info[i].clockBit) && simHfDomainRunning();
+}
+
+static uint64_t byteCycles(unsigned i)
+{
+  USART_TypeDef *regs = info[i].regs;
+  uint64_t div = 256 + (regs->CLKDIV & _USART_CLKDIV_DIV_MASK);   /* 1/256 steps */
+  uint64_t clocks = (regs->CTRL & USART_CTRL_SYNC) ? 8 * 2 : 10 * 16;
+
+  return ((clocks * div) >> 8) << simCmuHfperDivShift();
+}
+
+static void updateStatus(unsigned i)
+{
+  struct simUsart *u = &usarts[i];
+  uint32_t status = 0;
+
+  if (u->txEnabled) {
+    status |= USART_STATUS_TXENS;
+  }
+  if (!u->buffered) {
+    status |= USART_STATUS_TXBL;
+  }
+  if (!u->buffered && !u->shifting) {
+    status |= USART_STATUS_TXC;
+  }
+  info[i].regs->STATUS = status;
+}
+
+static void startShift(unsigned i, uint64_t from)
+{
+  usarts[i].shifting = true;
+  usarts[i].shiftEnd = from + byteCycles(i);
+}
+
+static void txWrite(unsigned i)
+{
+  struct simUsart *u = &usarts[i];
+
+  if (!u->txEnabled) {
+    return;
+  }
+  if (!u->shifting) {
+    startShift(i, simNow);
+  } else if (!u->buffered) {
+    u->buffered = true;
+  } else {
+    info[i].regs->IF |= USART_IF_TXOF;
+    u->overflows++;
+  }
+  updateStatus(i);
+}
+
+/* TXBL is a level request: keep asking while there is room */
+static void txRequest(unsigned i)
+{
+  unsigned n;
+
+  for (n = 0; n < REQUEST_BURST; n++) {
+    if (!usarts[i].txEnabled || usarts[i].buffered || !usartClocked(i)
+        || !simDmaRequest(info[i].dmaTxbl)) {
+      return;
+    }
+  }
+}
+
+void simPeripheralWrite(volatile void *addr)
+{
+  unsigned i;
+
+  for (i = 0; i < USART_MODELS; i++) {
+    if (addr == (volatile void *)&info[i].regs->TXDATA) {
+      txWrite(i);
+    }
+  }
+}
+
+static void usartReset(void)
+{
+  unsigned i;
+
+  memset(usarts, 0, sizeof(usarts));
+  for (i = 0; i < USART_MODELS; i++) {
+    info[i].regs->TXDATA = TXDATA_IDLE;
+    updateStatus(i);
+  }
+}
+
+static void usartSync(void)
+{
+  USART_TypeDef *regs;
+  struct simUsart *u;
+  uint32_t cmd;
+  unsigned i;
+
+  for (i = 0; i < USART_MODELS; i++) {
+    regs = info[i].regs;
+    u = &usarts[i];
+
+    cmd = simTake(&regs->CMD);
+    if (cmd & USART_CMD_TXEN) {
+      u->txEnabled = true;
+    }
+    if (cmd & USART_CMD_TXDIS) {
+      u->txEnabled = false;
+    }
+    if (cmd & USART_CMD_CLEARTX) {
+      u->buffered = false;
+    }
+    regs->IF |= simTake(&regs->IFS);
+    regs->IF &= ~simTake(&regs->IFC);
+
+    if (!(__atomic_exchange_n(&regs->TXDATA, TXDATA_IDLE, __ATOMIC_SEQ_CST) & TXDATA_IDLE)) {
+      txWrite(i);
+    }
+    updateStatus(i);
+    txRequest(i);
+  }
+}
+
+static uint64_t usartNext(void)
+{
+  uint64_t next = SIM_NEVER;
+  unsigned i;
+
+  for (i = 0; i < USART_MODELS; i++) {
+    if (usarts[i].shifting && usarts[i].shiftEnd < next) {
+      next = usarts[i].shiftEnd;
+    }
+  }
+  return next;
+}
+
+static void usartAdvance(void)
+{
+  struct simUsart *u;
+  uint64_t start;
+  unsigned i;
+
+  for (i = 0; i < USART_MODELS; i++) {
+    u = &usarts[i];
+    if (!u->shifting || u->shiftEnd > simNow) {
+      continue;
+    }
+    start = u->shiftEnd;
+    u->bytes++;
+    u->busyCycles += byteCycles(i);
+    if (u->buffered) {
+      u->buffered = false;
+      startShift(i, start);
+      info[i].regs->IF |= USART_IF_TXBL;
+    } else {
+      u->shifting = false;
+      info[i].regs->IF |= USART_IF_TXBL | USART_IF_TXC;
+    }
+    updateStatus(i);
+    txRequest(i);
+  }
+}
+
+static void usartReport(FILE *out)
+{
+  unsigned i;
+
+  for (i = 0; i < USART_MODELS; i++) {
+    if (usarts[i].bytes) {
+      fprintf(out, "usart%u: %lu bytes sent, %llu cycles sending, %lu TX overflows\n",
+              i, usarts[i].bytes, (unsigned long long)usarts[i].busyCycles,
+              usarts[i].overflows);
+    }
+  }
+}
+
+const struct simModel simUsartModel = {
+  "usart", usartReset, usartSync, usartNext, usartAdvance, usartReport
+};
@@ -0,0 +1,43 @@
+/**************************************************************************//**
+ * @file sim_wrap.c
+ * @brief emlib calls the simulator has to see as a whole.
+ *
+ * The simulator only looks at the registers now and then, so a sequence of
+ * writes that the hardware handles one by one can be seen as just the last
+ * write. The build links the few emlib functions where that matters with
+ * -Wl,--wrap, the wrappers call the real function and then fix up the model.
+ *****************************************************************************/
+
+#include "hostsim_internal.h"
+#include "em_dma.h"
+#include "em_rtc.h"
+#include "em_pcnt.h"
+
+/* Weak so examples without these emlib modules still link */
+extern void __real_DMA_Init(DMA_Init_TypeDef *init) __attribute__((weak));
+extern void __real_RTC_CounterReset(void) __attribute__((weak));
+extern void __real_PCNT_Init(PCNT_TypeDef *pcnt, const PCNT_Init_TypeDef *init)
+__attribute__((weak));
+
+/* DMA_Cfg* read ALTCTRLBASE right after DMA_Init wrote CTRLBASE */
+void __wrap_DMA_Init(DMA_Init_TypeDef *init)
+{
+  __real_DMA_Init(init);
+  simApiLock();
+  simDmaRebase();
+  simApiUnlock();
+}
+
+/* Clears and sets CTRL.EN, which resets the counter */
+void __wrap_RTC_CounterReset(void)
+{
+  __real_RTC_CounterReset();
+  simRtcCounterReset();
+}
+
+/* Loads CNT and TOP through TOPB with two commands */
+void __wrap_PCNT_Init(PCNT_TypeDef *pcnt, const PCNT_Init_TypeDef *init)
+{
+  __real_PCNT_Init(pcnt, init);
+  simPcntLoad(init->counter, init->top);
+}
@@ -0,0 +1,270 @@
+/**************************************************************************//**
+ * @file dma_bench.c
+ * @brief DMA throughput benchmark
+ *
+ * Copies BENCH_BYTES memory to memory with every element size, arbitration
+ * rate and em_dma cycle type (auto, basic, ping-pong, scatter-gather), from
+ * flash and from RAM, and prints one CSV line per run to the kit's virtual
+ * COM port, the board controller's USB serial port:
+ *
+ *   mode,size,arb,src,bytes,elements,cycles,cycles_per_elem_x100,bytes_per_sec,ok
+ *
+ * Cycles are core clock cycles from activation to the channel being done,
+ * timed with the cycle counter. Basic and ping-pong cycles move 2^R
+ * elements per request, the CPU keeps issuing software requests. Under
+ * HostSim (HOSTSIM defined) the cycles are the DMA model's bus cycle
+ * estimate instead, which counts arbitrations and elements but no flash
+ * wait states; a change in those numbers after an emlib update means em_dma
+ * programs the controller differently. The HostSim scenario
+ * scenario/dma_bench.c fails when they differ from dmabench_hostsim.csv.
+ *
+ * The table is also kept in dmaBenchCycles for reading with the debugger.
+ *****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_dma.h"
+
+#include "retargetserial.h"
+#include "cycle_counter.h"
+
+#if defined(HOSTSIM)
+#include "hostsim.h"
+#endif
+
+#define BENCH_CHANNEL     0
+#define BENCH_BYTES       1024
+#define SG_ENTRIES        4
+#define ARB_RATES         (dmaArbitrate1024 + 1)
+#define DATA_SIZES        3
+
+typedef enum
+{
+  benchAuto,
+  benchBasic,
+  benchPingPong,
+  benchScatterGather,
+  benchModes
+} benchMode_TypeDef;
+
+static const char *const modeName[benchModes] = { "auto", "basic", "pingpong", "sg" };
+
+/* DMA control block, must be aligned to 256. */
+#if defined (__ICCARM__)
+#pragma data_alignment=256
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2];
+#elif defined (__CC_ARM)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#elif defined (__GNUC__)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#else
+#error Undefined toolkit, need to define alignment
+#endif
+
+/* The const array will be stored in flash */
+const uint32_t flashData[BENCH_BYTES / 4] = { 0x01234567, 0x89ABCDEF, 0xFEDCBA98, 0x76543210 };
+
+static uint32_t ramData[BENCH_BYTES / 4];
+static uint32_t dstBuffer[BENCH_BYTES / 4];
+static DMA_DESCRIPTOR_TypeDef sgChain[SG_ENTRIES];
+
+/* Cycles of every run, [flash][mode][size][arbitration] */
+uint32_t dmaBenchCycles[2][benchModes][DATA_SIZES][ARB_RATES];
+
+/**************************************************************************//**
+ * @brief Cycle count, counting up and wrapping at 24 bits
+ *****************************************************************************/
+static uint32_t benchTick(void)
+{
+#if defined(HOSTSIM)
+  return (uint32_t)simDmaBusCycles(BENCH_CHANNEL) & CYCLE_COUNTER_MASK;
+#else
+  return cycleCounterGet();
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Scatter-gather chain of SG_ENTRIES equal memory copies
+ *****************************************************************************/
+static void buildChain(const void *src, DMA_DataSize_TypeDef size,
+                       DMA_ArbiterConfig_TypeDef arb)
+{
+  DMA_CfgDescrSGAlt_TypeDef cfg;
+  unsigned int i;
+
+  cfg.nMinus1    = ((BENCH_BYTES / SG_ENTRIES) >> size) - 1;
+  cfg.dstInc     = (DMA_DataInc_TypeDef)size;
+  cfg.srcInc     = (DMA_DataInc_TypeDef)size;
+  cfg.size       = size;
+  cfg.arbRate    = arb;
+  cfg.hprot      = 0;
+  cfg.peripheral = false;
+  for (i = 0; i < SG_ENTRIES; i++)
+  {
+    cfg.dst = (uint8_t *)dstBuffer + i * (BENCH_BYTES / SG_ENTRIES);
+    cfg.src = (uint8_t *)src + i * (BENCH_BYTES / SG_ENTRIES);
+    DMA_CfgDescrScatterGather(sgChain, i, &cfg);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Copy BENCH_BYTES from src to dstBuffer, returns the cycles taken
+ * Descriptors are set up before the clock starts, activation is timed.
+ *****************************************************************************/
+static uint32_t benchRun(benchMode_TypeDef mode, DMA_DataSize_TypeDef size,
+                         DMA_ArbiterConfig_TypeDef arb, const void *src)
+{
+  DMA_CfgDescr_TypeDef descrCfg;
+  unsigned int elements = BENCH_BYTES >> size;
+  unsigned int half = elements / 2;
+  bool request = (mode == benchBasic || mode == benchPingPong);
+  uint32_t t0;
+
+  /* The element sizes and increments share their encoding */
+  descrCfg.dstInc  = (DMA_DataInc_TypeDef)size;
+  descrCfg.srcInc  = (DMA_DataInc_TypeDef)size;
+  descrCfg.size    = size;
+  descrCfg.arbRate = arb;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(BENCH_CHANNEL, true, &descrCfg);
+  DMA_CfgDescr(BENCH_CHANNEL, false, &descrCfg);
+  if (mode == benchScatterGather)
+  {
+    buildChain(src, size, arb);
+  }
+  memset(dstBuffer, 0, sizeof(dstBuffer));
+
+  t0 = benchTick();
+  switch (mode)
+  {
+  case benchAuto:
+    DMA_ActivateAuto(BENCH_CHANNEL, true, dstBuffer, src, elements - 1);
+    break;
+
+  case benchBasic:
+    DMA_ActivateBasic(BENCH_CHANNEL, true, false, dstBuffer, src, elements - 1);
+    break;
+
+  case benchPingPong:
+    DMA_ActivatePingPong(BENCH_CHANNEL, false,
+                         dstBuffer, src, half - 1,
+                         (uint8_t *)dstBuffer + BENCH_BYTES / 2,
+                         (const uint8_t *)src + BENCH_BYTES / 2, half - 1);
+    break;
+
+  default:
+    DMA_ActivateScatterGather(BENCH_CHANNEL, false, sgChain, SG_ENTRIES);
+    break;
+  }
+
+  while (DMA_ChannelEnabled(BENCH_CHANNEL))
+  {
+    if (request)
+    {
+      DMA->CHSWREQ = 1 << BENCH_CHANNEL;
+    }
+  }
+
+  return (benchTick() - t0) & CYCLE_COUNTER_MASK;
+}
+
+/**************************************************************************//**
+ * @brief Run the whole matrix and print it
+ *****************************************************************************/
+static void benchAll(void)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+  uint32_t clock = CMU_ClockFreqGet(cmuClock_CORE);
+  unsigned int flash, mode, size, arb, elements;
+  uint32_t cycles;
+  const void *src;
+  bool ok;
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = false;
+  chnlCfg.select    = 0;
+  chnlCfg.cb        = NULL;
+  DMA_CfgChannel(BENCH_CHANNEL, &chnlCfg);
+
+#if defined(HOSTSIM)
+  printf("# dmabench clock=%lu timing=model\n", (unsigned long)clock);
+#else
+  printf("# dmabench clock=%lu timing=systick\n", (unsigned long)clock);
+#endif
+  printf("mode,size,arb,src,bytes,elements,cycles,cycles_per_elem_x100,bytes_per_sec,ok\n");
+
+  for (flash = 0; flash < 2; flash++)
+  {
+    src = flash ? (const void *)flashData : (const void *)ramData;
+    for (mode = 0; mode < benchModes; mode++)
+    {
+      for (size = 0; size < DATA_SIZES; size++)
+      {
+        for (arb = 0; arb < ARB_RATES; arb++)
+        {
+          cycles = benchRun((benchMode_TypeDef)mode, (DMA_DataSize_TypeDef)size,
+                            (DMA_ArbiterConfig_TypeDef)arb, src);
+          ok = memcmp(dstBuffer, src, BENCH_BYTES) == 0;
+          elements = BENCH_BYTES >> size;
+          dmaBenchCycles[flash][mode][size][arb] = cycles;
+
+          if (cycles == 0)
+          {
+            cycles = 1;
+          }
+          printf("%s,%u,%u,%s,%u,%u,%lu,%lu,%lu,%u\n",
+                 modeName[mode], 1U << size, 1U << arb, flash ? "flash" : "ram",
+                 BENCH_BYTES, elements, (unsigned long)cycles,
+                 (unsigned long)(cycles * 100 / elements),
+                 (unsigned long)((uint64_t)BENCH_BYTES * clock / cycles), ok);
+        }
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  unsigned int i;
+
+  /* Initialize chip */
+  CHIP_Init();
+
+  /* Retarget stdio to the virtual COM port, lines end in CR LF */
+  RETARGET_SerialInit();
+  RETARGET_SerialCrLf(1);
+
+  /* Enable the DMA clock */
+  CMU_ClockEnable(cmuClock_DMA, true);
+
+  /* Initialize DMA */
+  DMA_Init_TypeDef dmaInit;
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  cycleCounterStart();
+
+  for (i = 0; i < BENCH_BYTES / 4; i++)
+  {
+    ramData[i] = flashData[i % 4] ^ i;
+  }
+
+  benchAll();
+
+#if defined(HOSTSIM)
+  simStop(0);
+#endif
+
+  while (1)
+  {
+    EMU_EnterEM2(true);
+  }
+}
@@ -0,0 +1,216 @@
+/**************************************************************************//**
+ * @file encoder.c
+ * @brief Quadrature encoder on TIMER0 with sampled velocity
+ *
+ * TIMER0 counts over the full 16 bits, an overflow counting up and an
+ * underflow counting down move the upper half. A read of the position
+ * checks for a wrap that is pending but not yet handled.
+ *
+ * Captures are 16 bit, the difference of two is right as long as the
+ * encoder moves less than 32768 counts per sample. The last ENCODER_WINDOW
+ * differences are summed, at low speed the velocity resolution is
+ * sampleHz / ENCODER_WINDOW counts per second.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "encoder.h"
+
+#define SAMPLE_CC       2
+#define MAX_TOP         0xFFFF
+#define MAX_PRESCALE    timerPrescale1024
+
+static volatile int32_t wraps;
+static uint16_t lastCapture;
+static int16_t delta[ENCODER_WINDOW];
+static unsigned int deltaNext;
+static volatile int32_t deltaSum;
+static volatile uint32_t samples;
+static uint32_t sampleHz;
+
+/**************************************************************************//**
+ * @brief TIMER0 wraps and velocity samples
+ *****************************************************************************/
+void TIMER0_IRQHandler(void)
+{
+  uint32_t flags = TIMER_IntGetEnabled(TIMER0);
+  uint16_t capture;
+
+  TIMER_IntClear(TIMER0, flags);
+
+  if (flags & TIMER_IF_OF)
+  {
+    wraps++;
+  }
+  if (flags & TIMER_IF_UF)
+  {
+    wraps--;
+  }
+
+  if (flags & (TIMER_IF_CC0 << SAMPLE_CC))
+  {
+    capture = (uint16_t)TIMER_CaptureGet(TIMER0, SAMPLE_CC);
+    deltaSum -= delta[deltaNext];
+    delta[deltaNext] = (int16_t)(capture - lastCapture);
+    deltaSum += delta[deltaNext];
+    deltaNext = (deltaNext + 1) % ENCODER_WINDOW;
+    lastCapture = capture;
+    samples++;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Route a GPIO pin to a PRS channel as a level
+ *****************************************************************************/
+static void pinToPrs(GPIO_Port_TypeDef port, unsigned int pin, unsigned int ch)
+{
+  GPIO_PinModeSet(port, pin, gpioModeInputPull, 1);
+
+  /* Selects the port for the pin's PRS signal, the interrupt stays off */
+  GPIO_IntConfig(port, pin, false, false, false);
+  PRS_SourceSignalSet(ch, pin < 8 ? PRS_CH_CTRL_SOURCESEL_GPIOL : PRS_CH_CTRL_SOURCESEL_GPIOH,
+                      (pin & 7) << _PRS_CH_CTRL_SIGSEL_SHIFT, prsEdgeOff);
+}
+
+/**************************************************************************//**
+ * @brief Set up the decoder and the sampling, position starts at 0
+ * Takes over TIMER0, TIMER1 and the TIMER0 interrupt.
+ *****************************************************************************/
+void encoderInit(const encoderInit_TypeDef *init)
+{
+  uint32_t counts, prescale = 0;
+
+  /* One external interrupt, and so one PRS signal, per pin number */
+  EFM_ASSERT(init->pinA != init->pinB);
+  EFM_ASSERT(init->sampleHz > 0);
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  pinToPrs(init->portA, init->pinA, init->prsA);
+  pinToPrs(init->portB, init->pinB, init->prsB);
+
+  /* The decoder takes A and B from the CC0 and CC1 inputs */
+  TIMER_InitCC_TypeDef timerCCInit =
+  {
+    .eventCtrl = timerEventEveryEdge,
+    .edge      = timerEdgeBoth,
+    .prsSel    = (TIMER_PRSSEL_TypeDef)init->prsA,
+    .cufoa     = timerOutputActionNone,
+    .cofoa     = timerOutputActionNone,
+    .cmoa      = timerOutputActionNone,
+    .mode      = timerCCModeOff,
+    .filter    = true,
+    .prsInput  = true,
+    .coist     = false,
+    .outInvert = false,
+  };
+  TIMER_InitCC(TIMER0, 0, &timerCCInit);
+  timerCCInit.prsSel = (TIMER_PRSSEL_TypeDef)init->prsB;
+  TIMER_InitCC(TIMER0, 1, &timerCCInit);
+
+  /* CC2 captures the count on the sample trigger */
+  timerCCInit.prsSel = (TIMER_PRSSEL_TypeDef)init->prsSample;
+  timerCCInit.edge   = timerEdgeRising;
+  timerCCInit.mode   = timerCCModeCapture;
+  timerCCInit.filter = false;
+  TIMER_InitCC(TIMER0, SAMPLE_CC, &timerCCInit);
+
+  TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = true,
+    .debugRun   = false,
+    .prescale   = timerPrescale1,
+    .clkSel     = timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = timerModeQDec,
+    .dmaClrAct  = false,
+    .quadModeX4 = init->x4,
+    .oneShot    = false,
+    .sync       = false,
+  };
+  TIMER_TopSet(TIMER0, MAX_TOP);
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_Init(TIMER0, &timerInit);
+
+  wraps       = 0;
+  lastCapture = 0;
+  deltaSum    = 0;
+  deltaNext   = 0;
+  samples     = 0;
+  for (unsigned int i = 0; i < ENCODER_WINDOW; i++)
+  {
+    delta[i] = 0;
+  }
+
+  TIMER_IntClear(TIMER0, TIMER_IFC_OF | TIMER_IFC_UF | (TIMER_IFC_CC0 << SAMPLE_CC));
+  TIMER_IntEnable(TIMER0, TIMER_IEN_OF | TIMER_IEN_UF | (TIMER_IEN_CC0 << SAMPLE_CC));
+  NVIC_ClearPendingIRQ(TIMER0_IRQn);
+  NVIC_EnableIRQ(TIMER0_IRQn);
+
+  /* TIMER1 overflows sampleHz times a second, the smallest prescaler that
+   * fits gives the most exact rate */
+  sampleHz = init->sampleHz;
+  counts = CMU_ClockFreqGet(cmuClock_TIMER1) / sampleHz;
+  while ((counts >> prescale) > MAX_TOP + 1 && prescale < MAX_PRESCALE)
+  {
+    prescale++;
+  }
+  timerInit.prescale = (TIMER_Prescale_TypeDef)prescale;
+  timerInit.mode     = timerModeUp;
+  TIMER_TopSet(TIMER1, (counts >> prescale) - 1);
+  TIMER_Init(TIMER1, &timerInit);
+  PRS_SourceSignalSet(init->prsSample, PRS_CH_CTRL_SOURCESEL_TIMER1,
+                      PRS_CH_CTRL_SIGSEL_TIMER1OF, prsEdgePos);
+}
+
+/**************************************************************************//**
+ * @brief Position in counts, 32 bit
+ *****************************************************************************/
+int32_t encoderPosition(void)
+{
+  uint32_t cnt, pending;
+  int32_t high;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  cnt     = TIMER_CounterGet(TIMER0);
+  pending = TIMER0->IF;
+  high    = wraps;
+  CORE_EXIT_ATOMIC();
+
+  /* A wrap that came after the last interrupt but before the read */
+  if ((pending & TIMER_IF_OF) && cnt < 0x8000)
+  {
+    high++;
+  }
+  if ((pending & TIMER_IF_UF) && cnt >= 0x8000)
+  {
+    high--;
+  }
+
+  return (int32_t)(((uint32_t)high << 16) | cnt);
+}
+
+/**************************************************************************//**
+ * @brief Velocity in counts per second over the last ENCODER_WINDOW samples
+ *****************************************************************************/
+int32_t encoderVelocity(void)
+{
+  return (int32_t)(((int64_t)deltaSum * (int32_t)sampleHz) / ENCODER_WINDOW);
+}
+
+/**************************************************************************//**
+ * @brief Velocity samples taken since encoderInit()
+ *****************************************************************************/
+uint32_t encoderSamples(void)
+{
+  return samples;
+}
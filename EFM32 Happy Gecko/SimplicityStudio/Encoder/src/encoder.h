@@ -0,0 +1,41 @@
+/**************************************************************************//**
+ * @file encoder.h
+ * @brief Quadrature encoder on TIMER0 with sampled velocity
+ *
+ * The encoder channels reach the TIMER0 quadrature decoder through the PRS,
+ * so any two GPIO pins with different pin numbers can be used. TIMER0
+ * counts the edges in hardware, its overflow interrupt extends the count
+ * to 32 bits. TIMER1 triggers a capture of the count on TIMER0 CC2 through
+ * the PRS at a fixed rate; the velocity is the difference of the captures,
+ * without interrupt latency in the sample times. The timers need HFPERCLK,
+ * the CPU can sleep in EM1.
+ *****************************************************************************/
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_gpio.h"
+
+/* Velocity is averaged over this many samples */
+#define ENCODER_WINDOW      8
+
+typedef struct
+{
+  GPIO_Port_TypeDef portA;
+  unsigned int      pinA;
+  GPIO_Port_TypeDef portB;
+  unsigned int      pinB;
+  unsigned int      prsA;       /* PRS channels for A, B and the sample trigger */
+  unsigned int      prsB;
+  unsigned int      prsSample;
+  bool              x4;         /* Count the edges of both channels */
+  uint32_t          sampleHz;   /* Velocity samples per second */
+} encoderInit_TypeDef;
+
+void encoderInit(const encoderInit_TypeDef *init);
+int32_t encoderPosition(void);
+int32_t encoderVelocity(void);
+uint32_t encoderSamples(void);
+
+#endif /* ENCODER_H */
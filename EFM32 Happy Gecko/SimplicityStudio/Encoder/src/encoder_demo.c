@@ -0,0 +1,94 @@
+/**************************************************************************//**
+ * @file encoder_demo.c
+ * @brief Position and speed of a quadrature encoder on the LCD
+ *
+ * Channel A on PC9 and channel B on PC10, the push buttons of the kit, so
+ * pressing PB0 before PB1 and releasing in the same order steps the count
+ * up by four, the other way round down. An encoder with open collector
+ * outputs can be wired to the same pins. The count is refreshed twice a
+ * second, the CPU sleeps in EM1 in between.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+
+#include "display.h"
+#include "textdisplay.h"
+#include "retargettextdisplay.h"
+
+#include "encoder.h"
+
+/* Encoder channels, push buttons PB0 and PB1 */
+#define ENC_A_PORT          gpioPortC
+#define ENC_A_PIN           9
+#define ENC_B_PORT          gpioPortC
+#define ENC_B_PIN           10
+
+/* PRS channels for A, B and the velocity sample trigger */
+#define ENC_A_PRS_CH        0
+#define ENC_B_PRS_CH        1
+#define ENC_SAMPLE_PRS_CH   2
+
+#define SAMPLE_HZ           100
+#define REFRESH_HZ          2
+
+static DISPLAY_Device_t displayDevice;    /* Display device handle.*/
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t nextRefresh = SAMPLE_HZ / REFRESH_HZ;
+
+  /* Chip errata */
+  CHIP_Init();
+
+  /* Initialize the LCD */
+  DISPLAY_Init();
+
+  /* Retrieve the properties of the display. */
+  if ( DISPLAY_DeviceGet(0, &displayDevice) != DISPLAY_EMSTATUS_OK ) {
+	  /* Unable to get display handle. */
+	  while ( 1 ) ;
+  }
+
+  /* Retarget stdio to the display. */
+  if ( TEXTDISPLAY_EMSTATUS_OK != RETARGET_TextDisplayInit() ) {
+	  /* Text display initialization failed. */
+	  while ( 1 ) ;
+  }
+
+  const encoderInit_TypeDef encInit =
+  {
+    .portA     = ENC_A_PORT,
+    .pinA      = ENC_A_PIN,
+    .portB     = ENC_B_PORT,
+    .pinB      = ENC_B_PIN,
+    .prsA      = ENC_A_PRS_CH,
+    .prsB      = ENC_B_PRS_CH,
+    .prsSample = ENC_SAMPLE_PRS_CH,
+    .x4        = true,
+    .sampleHz  = SAMPLE_HZ,
+  };
+  encoderInit(&encInit);
+
+  printf("Quadrature encoder\nA PC9, B PC10\n");
+
+  while (1)
+  {
+    /* The timers need HFPERCLK, EM1 is as deep as it gets */
+    EMU_EnterEM1();
+    if ((int32_t)(encoderSamples() - nextRefresh) < 0)
+    {
+      continue;
+    }
+    nextRefresh += SAMPLE_HZ / REFRESH_HZ;
+
+    printf("\nPos %ld, %ld/s", (long)encoderPosition(), (long)encoderVelocity());
+  }
+}
@@ -39,6 +39,143 @@
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_gpio.h"
+#include "em_dma.h"
+#include "em_emu.h"
+#include "em_assert.h"
+#include "em_timer.h"
+#include "timer_config.h"
+#include "pattern_out.h"
+#include "led_pwm.h"
+
+// The LEDs blink from TIMER0 PWM, define LED_DMA_PATTERN to have the DMA
+// write patterns to them instead
+
+// LED blink rate and on time in 1/1000 of the period
+#define LED_PWM_HZ       1
+#define LED0_DUTY        500
+#define LED1_DUTY        100
+
+// LEDs are on port F
+#define LED_PORT     gpioPortF
+#define LED0_PIN     4
+#define LED1_PIN     5
+#define LED_DMA_CHANNEL  0
+
+// Passes of a pattern before the other one is swapped in
+#define SWAP_PASSES  4
+
+// Time between two pattern steps, and how far off it may be
+#define PATTERN_STEP_US   2000000
+#define PATTERN_STEP      TIMER_CONFIG_US(PATTERN_STEP_US)
+#define PATTERN_STEP_PPM  100
+
+TIMER_CONFIG_ASSERT(PATTERN_STEP, PATTERN_STEP_PPM);
+
+// The PWM frequency is set at run time, but this one is known to work
+TIMER_CONFIG_ASSERT(TIMER_CONFIG_HZ(LED_PWM_HZ), 1000);
+
+// DMA control block, must be aligned to 256
+#if defined (__ICCARM__)
+#pragma data_alignment=256
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2];
+#elif defined (__CC_ARM)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#elif defined (__GNUC__)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#else
+#error Undefined toolkit, need to define alignment
+#endif
+
+#if defined(LED_DMA_PATTERN)
+
+// Pins toggled at every timer overflow, one mask per pattern step. Only the
+// LED pins change, the rest of port F (LCD EXTCOMIN on PF3) is left alone.
+// Every pass ends with the LEDs off, so either table can follow the other.
+#define LED0_MASK    (1 << LED0_PIN)
+#define LED1_MASK    (1 << LED1_PIN)
+
+static const uint32_t blinkTable[] = {
+  LED0_MASK | LED1_MASK,
+  LED0_MASK | LED1_MASK,
+  LED0_MASK | LED1_MASK,
+  LED0_MASK | LED1_MASK,
+};
+static const uint32_t alternateTable[] = {
+  LED0_MASK,
+  LED0_MASK | LED1_MASK,
+  LED0_MASK | LED1_MASK,
+  LED0_MASK,
+};
+static const patternOut_TypeDef blinkPattern = { blinkTable, 4 };
+static const patternOut_TypeDef alternatePattern = { alternateTable, 4 };
+
+/******************************************************************************
+ * @brief  LEDs from a DMA pattern, TIMER0 overflow paces it
+ *****************************************************************************/
+static void ledPatternRun(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  GPIO_PinModeSet(LED_PORT, LED0_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(LED_PORT, LED1_PIN, gpioModePushPull, 0);
+
+  // Prescaler and TOP of the step are constants, the clock must match
+  EFM_ASSERT(CMU_ClockFreqGet(cmuClock_TIMER0) == TIMER_CONFIG_CLOCK_HZ);
+
+  // Overflow requests the DMA, served requests clear themselves
+  TIMER_Init_TypeDef timerInit = TIMER_CONFIG_INIT(PATTERN_STEP);
+  timerInit.dmaClrAct = true;
+  TIMER_TopSet(TIMER0, TIMER_CONFIG_TOP(PATTERN_STEP));
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_Init(TIMER0, &timerInit);
+
+  // The DMA writes the LEDs, the CPU only sleeps
+  CMU_ClockEnable(cmuClock_DMA, true);
+  DMA_Init_TypeDef dmaInit;
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  patternOutInit_TypeDef patternInit;
+  patternInit.channel = LED_DMA_CHANNEL;
+  patternInit.select  = DMAREQ_TIMER0_UFOF;
+  patternInit.dst     = &GPIO->P[LED_PORT].DOUTTGL;
+  patternInit.size    = dmaDataSize4;
+  patternOutStart(&patternInit, &blinkPattern);
+
+  const patternOut_TypeDef *pattern = &blinkPattern;
+  uint32_t swapAt = SWAP_PASSES;
+
+  while (1)
+  {
+	  EMU_EnterEM1();
+
+	  if (patternOutPasses() >= swapAt)
+	  {
+		  pattern = (pattern == &blinkPattern) ? &alternatePattern : &blinkPattern;
+		  patternOutSwap(pattern);
+		  swapAt += SWAP_PASSES;
+	  }
+  }
+}
+
+#else
+
+/******************************************************************************
+ * @brief  LEDs from TIMER0 PWM, nothing for the CPU to do
+ *****************************************************************************/
+static void ledPwmRun(void)
+{
+  ledPwmInit(LED_PWM_HZ);
+  ledPwmDutySet(0, LED0_DUTY);
+  ledPwmDutySet(1, LED1_DUTY);
+
+  while (1)
+  {
+    EMU_EnterEM1();
+  }
+}
+
+#endif
 
 /******************************************************************************
  * @brief  Main function
@@ -77,48 +214,9 @@ int main(void)
   A[2] = 2;
   uint32_t *A_ptr = &A;
 
-  CMU_ClockEnable(cmuClock_GPIO, true);
-  bool onOff = true;
-  TIMER0->TOP = 0xC350;
-  TIMER0->CTRL |=0x2;
-
-  TIMER0->CTRL &= 0xF0FFFFFF;
-  TIMER0->CTRL |= 0x09000000;
-
-
-  while (1)
-  {
-	  if((TIMER0->STATUS & 0x2) == 0x2)
-	  {
-		  LedController(0, true);
-		  LedController(1, true);
-	  }
-	  else if((TIMER0->STATUS & 0x2) == 0x0)
-	  {
-		  LedController(0, false);
-		  LedController(1, false);
-	  }
-  }
-}
-
-void LedController(int led, bool onOff)
-{
-	switch(led)
-	{
-		//LED0
-		case 0:
-			if(onOff)
-				GPIO_PinModeSet(gpioPortF, 4, gpioModePushPull, 1);
-			else
-				GPIO_PinModeSet(gpioPortF, 4, gpioModePushPull, 0);
-			break;
-		//LED1
-		case 1:
-			if(onOff)
-				GPIO_PinModeSet(gpioPortF, 5, gpioModePushPull, 1);
-			else
-				GPIO_PinModeSet(gpioPortF, 5, gpioModePushPull, 0);
-			break;
-	}
-
+#if defined(LED_DMA_PATTERN)
+  ledPatternRun();
+#else
+  ledPwmRun();
+#endif
 }
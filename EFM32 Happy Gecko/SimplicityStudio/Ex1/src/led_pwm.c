@@ -0,0 +1,155 @@
+/**************************************************************************//**
+ * @file led_pwm.c
+ * @brief LED0/LED1 driven by TIMER0 PWM outputs
+ *
+ * In up-count PWM mode an output is set on overflow and cleared on compare
+ * match, so the duty cycle is CCV / (TOP + 1). New TOP and compare values go
+ * through the buffer registers and take effect on the next overflow, only
+ * the prescaler of a new frequency applies straight away.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "em_timer.h"
+#include "led_pwm.h"
+
+#define LED_PORT        gpioPortF
+#define LED_PRS_CH0     1
+#define MAX_TOP         0xFFFF
+#define MAX_PRESCALE    timerPrescale1024
+
+static const uint32_t ledPin[LED_PWM_COUNT] = { 4, 5 };
+static const uint32_t ledSignal[LED_PWM_COUNT] =
+{
+  PRS_CH_CTRL_SIGSEL_TIMER0CC0, PRS_CH_CTRL_SIGSEL_TIMER0CC1
+};
+
+static uint32_t duty[LED_PWM_COUNT];
+
+/**************************************************************************//**
+ * @brief Compare value for a duty cycle at the current TOP
+ *****************************************************************************/
+static uint32_t compareValue(uint32_t top, uint32_t dutyPermille)
+{
+  /* Above TOP the output is never cleared, fully on */
+  if (dutyPermille >= LED_PWM_DUTY_MAX)
+  {
+    return top + 1;
+  }
+  return (uint32_t)(((uint64_t)(top + 1) * dutyPermille) / LED_PWM_DUTY_MAX);
+}
+
+/**************************************************************************//**
+ * @brief Set up TIMER0, the PRS and the LED pins, the LEDs start off
+ *****************************************************************************/
+void ledPwmInit(uint32_t frequencyHz)
+{
+  unsigned int led;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+
+  const TIMER_InitCC_TypeDef timerCCInit =
+  {
+    .eventCtrl = timerEventEveryEdge,
+    .edge      = timerEdgeNone,
+    .prsSel    = timerPRSSELCh0,
+    .cufoa     = timerOutputActionNone,
+    .cofoa     = timerOutputActionNone,
+    .cmoa      = timerOutputActionNone,
+    .mode      = timerCCModePWM,
+    .filter    = false,
+    .prsInput  = false,
+    .coist     = false,
+    .outInvert = false,
+  };
+
+  for (led = 0; led < LED_PWM_COUNT; led++)
+  {
+    duty[led] = 0;
+    TIMER_InitCC(TIMER0, led, &timerCCInit);
+    TIMER_CompareSet(TIMER0, led, 0);
+
+    GPIO_PinModeSet(LED_PORT, ledPin[led], gpioModePushPull, 0);
+    PRS_SourceSignalSet(LED_PRS_CH0 + led, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                        ledSignal[led], prsEdgeOff);
+  }
+
+  /* One location for all PRS pins, location 1 puts channels 1/2 on PF4/PF5 */
+  PRS->ROUTE = (PRS->ROUTE & ~_PRS_ROUTE_LOCATION_MASK) | PRS_ROUTE_LOCATION_LOC1
+               | PRS_ROUTE_CH1PEN | PRS_ROUTE_CH2PEN;
+
+  const TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = false,
+    .debugRun   = true,
+    .prescale   = timerPrescale1,
+    .clkSel     = timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = false,
+  };
+  TIMER_Init(TIMER0, &timerInit);
+
+  ledPwmFrequencySet(frequencyHz);
+  TIMER0->CNT = 0;
+  TIMER0->TOP = TIMER0->TOPB;
+  TIMER_Enable(TIMER0, true);
+}
+
+/**************************************************************************//**
+ * @brief Set the PWM frequency, returns the one actually used
+ * Picks the smallest prescaler that fits the period in 16 bits, for the
+ * finest duty cycle steps. The duty cycles are kept.
+ *****************************************************************************/
+uint32_t ledPwmFrequencySet(uint32_t frequencyHz)
+{
+  uint32_t clock = CMU_ClockFreqGet(cmuClock_TIMER0);
+  uint32_t prescale = 0;
+  uint32_t counts, top;
+  unsigned int led;
+
+  EFM_ASSERT(frequencyHz > 0);
+
+  /* TOP stays below 0xFFFF, a fully on compare value is TOP + 1 */
+  counts = clock / frequencyHz;
+  while ((counts >> prescale) > MAX_TOP && prescale < MAX_PRESCALE)
+  {
+    prescale++;
+  }
+  top = counts >> prescale;
+  if (top > MAX_TOP)
+  {
+    top = MAX_TOP;
+  }
+  top = top > 2 ? top - 1 : 1;
+
+  TIMER0->CTRL = (TIMER0->CTRL & ~_TIMER_CTRL_PRESC_MASK)
+                 | (prescale << _TIMER_CTRL_PRESC_SHIFT);
+  TIMER_TopBufSet(TIMER0, top);
+  for (led = 0; led < LED_PWM_COUNT; led++)
+  {
+    TIMER_CompareBufSet(TIMER0, led, compareValue(top, duty[led]));
+  }
+
+  return (clock >> prescale) / (top + 1);
+}
+
+/**************************************************************************//**
+ * @brief Set the duty cycle of one LED, 0 to LED_PWM_DUTY_MAX
+ * 0 still lights the LED for one timer count per period.
+ *****************************************************************************/
+void ledPwmDutySet(unsigned int led, uint32_t dutyPermille)
+{
+  EFM_ASSERT(led < LED_PWM_COUNT);
+
+  duty[led] = dutyPermille;
+  TIMER_CompareBufSet(TIMER0, led, compareValue(TIMER0->TOPB, dutyPermille));
+}
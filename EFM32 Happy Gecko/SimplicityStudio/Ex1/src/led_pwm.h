@@ -0,0 +1,25 @@
+/**************************************************************************//**
+ * @file led_pwm.h
+ * @brief LED0/LED1 driven by TIMER0 PWM outputs
+ *
+ * TIMER0 CC0 and CC1 run in PWM mode and their outputs reach the kit LEDs
+ * without the CPU: the LED pins PF4/PF5 have no TIMER0 location, so the
+ * outputs go through PRS channels 1 and 2, whose location 1 is PF4 and PF5.
+ * Both LEDs share the period, each has its own duty cycle. The timer needs
+ * HFPERCLK, the CPU can sleep in EM1.
+ *****************************************************************************/
+#ifndef LED_PWM_H
+#define LED_PWM_H
+
+#include <stdint.h>
+
+#define LED_PWM_COUNT         2
+
+/* Duty cycles are given in 1/1000 */
+#define LED_PWM_DUTY_MAX      1000
+
+void ledPwmInit(uint32_t frequencyHz);
+uint32_t ledPwmFrequencySet(uint32_t frequencyHz);
+void ledPwmDutySet(unsigned int led, uint32_t dutyPermille);
+
+#endif /* LED_PWM_H */
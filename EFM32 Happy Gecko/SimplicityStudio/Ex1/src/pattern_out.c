@@ -0,0 +1,114 @@
+/**************************************************************************//**
+ * @file pattern_out.c
+ * @brief Periodic pattern output by the DMA, paced by a timer
+ *
+ * The pacing request must be cleared by the DMA access itself, e.g. TIMER
+ * overflow with DMACLRACT set. Only one pattern output runs at a time.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_assert.h"
+#include "pattern_out.h"
+
+static patternOutInit_TypeDef out;
+static const patternOut_TypeDef *volatile next;
+static DMA_CB_TypeDef cb;
+static volatile uint32_t passes;
+
+/**************************************************************************//**
+ * @brief DMA callback, a pass of the table is done
+ * In loop mode the controller has already restarted the same descriptor, a
+ * new table only needs its source end pointer. In ping-pong mode the other
+ * descriptor is running and the one that finished is queued again.
+ *****************************************************************************/
+static void passDone(unsigned int channel, bool primary, void *user)
+{
+  const patternOut_TypeDef *pattern = next;
+
+  (void)user;
+
+#if defined(_DMA_LOOP0_MASK)
+  DMA_DESCRIPTOR_TypeDef *descr = (DMA_DESCRIPTOR_TypeDef *)DMA->CTRLBASE + channel;
+
+  (void)primary;
+  descr->SRCEND = (uint8_t *)pattern->data + ((pattern->count - 1) << out.size);
+#else
+  DMA_RefreshPingPong(channel, primary, false, NULL, pattern->data,
+                      pattern->count - 1, false);
+#endif
+
+  passes++;
+}
+
+/**************************************************************************//**
+ * @brief Start sending a pattern, it repeats until the DMA is reset
+ * DMA_Init must have been called, the request source is started afterwards.
+ *****************************************************************************/
+void patternOutStart(const patternOutInit_TypeDef *init, const patternOut_TypeDef *pattern)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+  DMA_CfgDescr_TypeDef   descrCfg;
+
+  EFM_ASSERT(pattern->count > 0 && pattern->count <= PATTERN_OUT_MAX_COUNT);
+
+  out    = *init;
+  next   = pattern;
+  passes = 0;
+
+  cb.cbFunc  = passDone;
+  cb.userPtr = NULL;
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = init->select;
+  chnlCfg.cb        = &cb;
+  DMA_CfgChannel(init->channel, &chnlCfg);
+
+  /* The element sizes and increments share their encoding */
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = (DMA_DataInc_TypeDef)init->size;
+  descrCfg.size    = init->size;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(init->channel, true, &descrCfg);
+
+#if defined(_DMA_LOOP0_MASK)
+  DMA_CfgLoop_TypeDef loopCfg;
+
+  EFM_ASSERT(init->channel <= 1);
+
+  loopCfg.enable  = true;
+  loopCfg.nMinus1 = pattern->count - 1;
+  DMA_CfgLoop(init->channel, &loopCfg);
+  DMA_ActivateBasic(init->channel, true, false, (void *)init->dst, pattern->data,
+                    pattern->count - 1);
+#else
+  DMA_CfgDescr(init->channel, false, &descrCfg);
+  DMA_ActivatePingPong(init->channel, false,
+                       (void *)init->dst, pattern->data, pattern->count - 1,
+                       (void *)init->dst, pattern->data, pattern->count - 1);
+#endif
+}
+
+/**************************************************************************//**
+ * @brief Replace the table, it takes over at a pass boundary
+ * In ping-pong mode the queued pass of the old table is sent first, so the
+ * old table must stay valid for up to two more passes. In loop mode the
+ * pass length is fixed, the new table must have as many elements.
+ *****************************************************************************/
+void patternOutSwap(const patternOut_TypeDef *pattern)
+{
+  EFM_ASSERT(pattern->count > 0 && pattern->count <= PATTERN_OUT_MAX_COUNT);
+#if defined(_DMA_LOOP0_MASK)
+  EFM_ASSERT(pattern->count == next->count);
+#endif
+
+  next = pattern;
+}
+
+/**************************************************************************//**
+ * @brief Passes completed since patternOutStart()
+ *****************************************************************************/
+uint32_t patternOutPasses(void)
+{
+  return passes;
+}
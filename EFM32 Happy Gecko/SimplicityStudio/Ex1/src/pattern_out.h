@@ -0,0 +1,43 @@
+/**************************************************************************//**
+ * @file pattern_out.h
+ * @brief Periodic pattern output by the DMA, paced by a timer
+ *
+ * A table of register values is written to a GPIO port or peripheral
+ * register, one element per DMA request, over and over. A GPIO pattern
+ * goes to the port's DOUTTGL as toggle masks, so pins outside the table
+ * keep their state. Parts with the DMA loop extension reload the
+ * descriptor themselves. The Happy Gecko has no loop mode, there both
+ * ping-pong descriptors send the whole table and the one that finished is
+ * rearmed from the DMA interrupt, once per pass.
+ * A new table set with patternOutSwap() takes over at a pass boundary.
+ *****************************************************************************/
+#ifndef PATTERN_OUT_H
+#define PATTERN_OUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_dma.h"
+
+/* Most elements in a table, one descriptor cycle */
+#define PATTERN_OUT_MAX_COUNT    1024
+
+typedef struct
+{
+  const void   *data;     /* First element */
+  unsigned int count;     /* Elements in one pass */
+} patternOut_TypeDef;
+
+typedef struct
+{
+  unsigned int         channel;   /* Loop mode needs channel 0 or 1 */
+  uint32_t             select;    /* DMAREQ_xxx request pacing the output */
+  volatile void        *dst;      /* Register written */
+  DMA_DataSize_TypeDef size;      /* Element size */
+} patternOutInit_TypeDef;
+
+void patternOutStart(const patternOutInit_TypeDef *init, const patternOut_TypeDef *pattern);
+void patternOutSwap(const patternOut_TypeDef *pattern);
+uint32_t patternOutPasses(void);
+
+#endif /* PATTERN_OUT_H */
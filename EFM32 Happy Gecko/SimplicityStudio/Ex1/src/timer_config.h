@@ -0,0 +1,106 @@
+/**************************************************************************//**
+ * @file timer_config.h
+ * @brief TIMER prescaler and TOP worked out by the compiler
+ *
+ * A period is given in 1/256 timer clock counts, from a frequency with
+ * TIMER_CONFIG_HZ() or a time with TIMER_CONFIG_US(), so the error is
+ * against the period asked for and not a rounded count. The smallest
+ * prescaler that fits the period in the 16 bit counter is taken, it gives
+ * the finest steps and the smallest error. Everything is a constant
+ * expression: no division at run time, and TIMER_CONFIG_ASSERT() makes a
+ * period the timer cannot reach, or one off by more than a given error, a
+ * compile error.
+ *
+ * The clock is fixed at compile time, HFPERCLK after reset unless the
+ * project defines TIMER_CONFIG_CLOCK_HZ. Compare it with CMU_ClockFreqGet()
+ * at start-up when the clock setup may change.
+ *****************************************************************************/
+#ifndef TIMER_CONFIG_H
+#define TIMER_CONFIG_H
+
+#include <stdint.h>
+
+#include "em_timer.h"
+
+/* HFRCO 14 MHz band, HFPERCLK undivided */
+#ifndef TIMER_CONFIG_CLOCK_HZ
+#define TIMER_CONFIG_CLOCK_HZ       14000000UL
+#endif
+
+/* Largest prescaler, timerPrescale1024 */
+#define TIMER_CONFIG_PRESCALE_MAX   10
+
+/* Period in 1/256 counts */
+#define TIMER_CONFIG_FRAC_BITS      8
+#define TIMER_CONFIG_HZ(hz) \
+  ((((uint64_t)TIMER_CONFIG_CLOCK_HZ << TIMER_CONFIG_FRAC_BITS) + (hz) / 2) / (hz))
+#define TIMER_CONFIG_US(us) \
+  ((((uint64_t)TIMER_CONFIG_CLOCK_HZ << TIMER_CONFIG_FRAC_BITS) * (us) + 500000) / 1000000)
+
+/* Prescaled counts of a period rounded to the nearest, TOP + 1 */
+#define TIMER_CONFIG_TICKS(period, p) \
+  (((period) + ((1ULL << ((p) + TIMER_CONFIG_FRAC_BITS)) >> 1)) \
+   >> ((p) + TIMER_CONFIG_FRAC_BITS))
+
+#define TIMER_CONFIG_FITS(period, p)  (TIMER_CONFIG_TICKS(period, p) <= 0x10000)
+
+/* Smallest prescaler, as log2, the TIMER_Prescale_TypeDef value.
+ * TIMER_CONFIG_PRESCALE_MAX + 1 when even the largest one is too small. */
+#define TIMER_CONFIG_PRESCALE(period)     \
+  (TIMER_CONFIG_FITS(period, 0)  ? 0  :   \
+   TIMER_CONFIG_FITS(period, 1)  ? 1  :   \
+   TIMER_CONFIG_FITS(period, 2)  ? 2  :   \
+   TIMER_CONFIG_FITS(period, 3)  ? 3  :   \
+   TIMER_CONFIG_FITS(period, 4)  ? 4  :   \
+   TIMER_CONFIG_FITS(period, 5)  ? 5  :   \
+   TIMER_CONFIG_FITS(period, 6)  ? 6  :   \
+   TIMER_CONFIG_FITS(period, 7)  ? 7  :   \
+   TIMER_CONFIG_FITS(period, 8)  ? 8  :   \
+   TIMER_CONFIG_FITS(period, 9)  ? 9  :   \
+   TIMER_CONFIG_FITS(period, 10) ? 10 : 11)
+
+#define TIMER_CONFIG_TOP(period) \
+  ((uint32_t)TIMER_CONFIG_TICKS(period, TIMER_CONFIG_PRESCALE(period)) - 1)
+
+/* Period the timer actually runs, in 1/256 counts */
+#define TIMER_CONFIG_ACTUAL(period) \
+  ((uint64_t)(TIMER_CONFIG_TOP(period) + 1) \
+   << (TIMER_CONFIG_PRESCALE(period) + TIMER_CONFIG_FRAC_BITS))
+
+/* Period error in ppm, positive when the timer is slow */
+#define TIMER_CONFIG_ERROR_PPM(period) \
+  ((int32_t)(((int64_t)TIMER_CONFIG_ACTUAL(period) - (int64_t)(period)) * 1000000 \
+             / (int64_t)(period)))
+
+/* The timer reaches the period, at least a count and TOP at least 1 */
+#define TIMER_CONFIG_VALID(period)                                \
+  ((period) >= (1 << TIMER_CONFIG_FRAC_BITS)                      \
+   && TIMER_CONFIG_PRESCALE(period) <= TIMER_CONFIG_PRESCALE_MAX  \
+   && TIMER_CONFIG_TOP(period) >= 1)
+
+/* Compile error unless the period is reachable within maxPpm */
+#define TIMER_CONFIG_ASSERT(period, maxPpm)                                  \
+  _Static_assert(TIMER_CONFIG_VALID(period),                                 \
+                 "TIMER period out of range for the clock");                 \
+  _Static_assert(!TIMER_CONFIG_VALID(period)                                 \
+                 || (TIMER_CONFIG_ERROR_PPM(period) <= (maxPpm)              \
+                     && TIMER_CONFIG_ERROR_PPM(period) >= -(maxPpm)),        \
+                 "TIMER period error too large")
+
+/* TIMER_INIT_DEFAULT with the prescaler of a period, TOP goes in separately */
+#define TIMER_CONFIG_INIT(period)                                             \
+  {                                                                           \
+    .enable     = true,                                                       \
+    .debugRun   = false,                                                      \
+    .prescale   = (TIMER_Prescale_TypeDef)TIMER_CONFIG_PRESCALE(period),      \
+    .clkSel     = timerClkSelHFPerClk,                                        \
+    .fallAction = timerInputActionNone,                                       \
+    .riseAction = timerInputActionNone,                                       \
+    .mode       = timerModeUp,                                                \
+    .dmaClrAct  = false,                                                      \
+    .quadModeX4 = false,                                                      \
+    .oneShot    = false,                                                      \
+    .sync       = false,                                                      \
+  }
+
+#endif /* TIMER_CONFIG_H */
@@ -0,0 +1,190 @@
+/**************************************************************************//**
+ * @file isr_stats.c
+ * @brief Run time of interrupt handlers, min/max/histogram per handler
+ *
+ * Each entered handler has a frame with its entry time and the time spent
+ * in handlers nested in it. On exit the elapsed time goes to the frame
+ * below as nested time and the rest is recorded. The exception entry and
+ * exit of the core and the few cycles of the calls themselves are not in
+ * the handler's time. Before isrStatsInit() nothing is recorded.
+ *****************************************************************************/
+#include <stddef.h>
+#include <stdio.h>
+
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_core.h"
+#include "isr_stats.h"
+
+typedef struct
+{
+  uint32_t start;
+  uint32_t nested;
+} frame_TypeDef;
+
+static isrStatsInit_TypeDef config;
+static frame_TypeDef frames[ISR_STATS_DEPTH];
+static unsigned int depth;
+static isrStats_TypeDef *list;
+
+/**************************************************************************//**
+ * @brief Histogram bin of a run time, the M0+ has no CLZ
+ *****************************************************************************/
+static unsigned int binOf(uint32_t ticks)
+{
+  unsigned int bin = 0;
+
+  while (ticks > 1 && bin < ISR_STATS_BINS - 1)
+  {
+    ticks >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+/**************************************************************************//**
+ * @brief Ticks to microseconds
+ *****************************************************************************/
+static unsigned long toUs(uint64_t ticks)
+{
+  return (unsigned long)(ticks * 1000000 / config.clockHz);
+}
+
+/**************************************************************************//**
+ * @brief Start recording, with the time from a free running counter
+ * Records already listed are kept.
+ *****************************************************************************/
+void isrStatsInit(const isrStatsInit_TypeDef *init)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT(init->clock != NULL && init->clockHz > 0);
+
+  CORE_ENTER_ATOMIC();
+  config = *init;
+  depth  = 0;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief First thing in a handler
+ *****************************************************************************/
+void isrStatsEnter(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (config.clock == NULL)
+  {
+    return;
+  }
+
+  CORE_ENTER_ATOMIC();
+  EFM_ASSERT(depth < ISR_STATS_DEPTH);
+  frames[depth].nested = 0;
+  frames[depth].start  = config.clock();
+  depth++;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Last thing in a handler, records its run time
+ *****************************************************************************/
+void isrStatsExit(isrStats_TypeDef *stats)
+{
+  uint32_t elapsed, ticks;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (config.clock == NULL)
+  {
+    return;
+  }
+
+  CORE_ENTER_ATOMIC();
+  EFM_ASSERT(depth > 0);
+  depth--;
+  elapsed = (config.clock() - frames[depth].start) & config.clockMask;
+  ticks   = elapsed - frames[depth].nested;
+  if (depth > 0)
+  {
+    frames[depth - 1].nested += elapsed;
+  }
+
+  if (!stats->listed)
+  {
+    stats->listed = true;
+    stats->next   = list;
+    list          = stats;
+  }
+  if (stats->count == 0 || ticks < stats->min)
+  {
+    stats->min = ticks;
+  }
+  if (ticks > stats->max)
+  {
+    stats->max = ticks;
+  }
+  stats->count++;
+  stats->total += ticks;
+  stats->bins[binOf(ticks)]++;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Clear the records, they stay listed
+ *****************************************************************************/
+void isrStatsReset(void)
+{
+  isrStats_TypeDef *stats;
+  unsigned int i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  for (stats = list; stats != NULL; stats = stats->next)
+  {
+    stats->count = 0;
+    stats->min   = 0;
+    stats->max   = 0;
+    stats->total = 0;
+    for (i = 0; i < ISR_STATS_BINS; i++)
+    {
+      stats->bins[i] = 0;
+    }
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Print the records in microseconds, each bin as the power of two
+ * it starts at, in ticks of the clock printed first. Takes long on the LCD,
+ * call it from the main loop. A record may change while it is printed.
+ *****************************************************************************/
+void isrStatsDump(void)
+{
+  const isrStats_TypeDef *stats;
+  unsigned int i;
+
+  if (config.clock == NULL)
+  {
+    return;
+  }
+
+  printf("\nISR clock %lu Hz", (unsigned long)config.clockHz);
+  for (stats = list; stats != NULL; stats = stats->next)
+  {
+    if (stats->count == 0)
+    {
+      continue;
+    }
+    printf("\n%s %lux\n %lu-%lu us\n avg %lu us",
+           stats->name, (unsigned long)stats->count,
+           toUs(stats->min), toUs(stats->max),
+           toUs(stats->total / stats->count));
+    for (i = 0; i < ISR_STATS_BINS; i++)
+    {
+      if (stats->bins[i] != 0)
+      {
+        printf("\n 2^%u %lu", i, (unsigned long)stats->bins[i]);
+      }
+    }
+  }
+}
@@ -20,6 +20,7 @@
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
+#include "em_core.h"
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "em_pcnt.h"
@@ -29,6 +30,9 @@
 #include "textdisplay.h"
 #include "retargettextdisplay.h"
 #include "em4config.h"
+#include "timestamp.h"
+#include "swtimer.h"
+#include "isr_stats.h"
 
 
 
@@ -48,12 +52,15 @@ static void GpioSetup(void);
 #define LED_PORT                    gpioPortF
 #define LED_PIN                     4
 
-/* Defines for the RTC */
-#define LFXO_FREQUENCY              32768
-#define WAKEUP_INTERVAL_MS          10
-#define RTC_COUNT_BETWEEN_WAKEUP    ((LFXO_FREQUENCY * WAKEUP_INTERVAL_MS) / 1000)
+/* Stopwatch resolution, the time is read from the RTC when it is shown */
+#define TIME_RESOLUTION_MS          10
 
-/* The time of the stopwatch*/
+/* Display refresh while running; besides it the RTC only wakes the core for
+ * the LCD polarity toggle */
+#define DISPLAY_REFRESH_MS          100
+#define RTC_COUNT_BETWEEN_WAKEUP    SWTIMER_MS_TO_TICKS(DISPLAY_REFRESH_MS)
+
+/* The time of the stopwatch in TIME_RESOLUTION_MS, as last shown */
 uint32_t time = 0;
 
 /* Increment the stopwatch? */
@@ -62,6 +69,26 @@ bool enableCount = false;
 /* Display the gecko on the LCD? */
 bool enableGecko = false;
 
+/* Refreshes the display while the stopwatch runs */
+static swtimer_TypeDef stopwatchTimer;
+
+/* RTC ticks of the earlier runs, and the RTC time the current run started */
+static uint32_t pausedTicks = 0;
+static uint32_t runStart;
+
+static void stopwatchTick(swtimer_TypeDef *timer, void *user);
+
+/* LCD polarity inversion on a software timer, EXTCOMIN toggles per second */
+#define DISPLAY_POLARITY_TOGGLE_HZ  2
+
+static swtimer_TypeDef polarityTimer;
+static void (*polarityFunction)(void *);
+
+/* Run time of the handlers, printed by the main loop after a clear */
+static isrStats_TypeDef gpio2Stats  = ISR_STATS_INIT("GPIO2");
+static isrStats_TypeDef pendSVStats = ISR_STATS_INIT("PendSV");
+static volatile bool statsRequested = false;
+
 
 
 
@@ -122,14 +149,21 @@ void GPIO_IRQHandler_1(void)
   if (enableCount)
   {
     enableCount = false;
+    pausedTicks += swtimerNow() - runStart;
+    swtimerStop(&stopwatchTimer);
     printf("\nPause");
+
+    /* Show the exact time it was paused at */
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
   }
   else
   {
-    /* The interrupt handler is called to compute the proper time
-     * for the next interrupt, since enableCount is 0, the time will not
-     * be increased. */
-    RTC_IRQHandler();
+    /* Refresh when the tenths change, counted from the first start. While
+     * the stopwatch is paused only the LCD polarity toggle wakes the core. */
+    runStart = swtimerNow();
+    swtimerStart(&stopwatchTimer,
+                 RTC_COUNT_BETWEEN_WAKEUP - pausedTicks % RTC_COUNT_BETWEEN_WAKEUP,
+                 RTC_COUNT_BETWEEN_WAKEUP, stopwatchTick, NULL);
 
     printf("\nStart");
     enableCount = true;
@@ -141,6 +175,8 @@ void GPIO_IRQHandler_1(void)
  *****************************************************************************/
 void GPIO_IRQHandler_2(void)
 {
+  isrStatsEnter();
+
   /* Get the interrupt source, either Push Button 2 (pin B11) or pin D3 */
   uint32_t interrupt_source = GPIO_IntGet();
 
@@ -150,8 +186,11 @@ void GPIO_IRQHandler_2(void)
     GPIO_IntClear(1 << PB1_PIN);
     printf("\n\n\n-----Clear-----\n");
     time        = 0;
+    pausedTicks = 0;
     enableCount = false;
+    swtimerStop(&stopwatchTimer);
     printf("%lu",time);
+    statsRequested = true;
   }
 
   /* Pin D3 - channel 3 => 2^3 */
@@ -182,11 +221,36 @@ void GPIO_IRQHandler_2(void)
     /* Enable interrupts again */
     /* __enable_irq(); */
   }
+
+  isrStatsExit(&gpio2Stats);
+}
+
+/**************************************************************************//**
+ * @brief Stopwatch time in TIME_RESOLUTION_MS, derived from the RTC
+ *****************************************************************************/
+static uint32_t stopwatchTime(void)
+{
+  uint32_t ticks;
+  CORE_DECLARE_IRQ_STATE;
+
+  /* PB0 may start or pause it in between, PendSV runs below GPIO */
+  CORE_ENTER_ATOMIC();
+  ticks = pausedTicks;
+  if (enableCount)
+  {
+    ticks += swtimerNow() - runStart;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return (uint32_t)(((uint64_t)ticks * 1000) / ((uint64_t)SWTIMER_HZ * TIME_RESOLUTION_MS));
 }
 
 void PendSV_Handler(void)
 {
+  isrStatsEnter();
+  time = stopwatchTime();
   printf("%lu \n",time);
+  isrStatsExit(&pendSVStats);
 }
 
 
@@ -205,55 +269,43 @@ void GPIO_ODD_IRQHandler(void)
 }
 
 /**************************************************************************//**
- * @brief Real Time Counter Interrupt Handler
+ * @brief Display refresh, from the RTC interrupt
  *****************************************************************************/
-void RTC_IRQHandler(void)
+static void stopwatchTick(swtimer_TypeDef *timer, void *user)
 {
-  /* Clear interrupt source */
-  RTC_IntClear(RTC_IFC_COMP0);
-
-  /* Increase the timer when appropriate. */
-  if (enableCount)
-    time++;
+  (void)timer;
+  (void)user;
 
-  /* Only update the number if necessary */
-  if (enableCount)
-    /* Set lower priority interrupt which will process data */
-    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  /* Set lower priority interrupt which will read the time and show it */
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
 }
 
 /**************************************************************************//**
- * @brief Initialize Real Time Counter
+ * @brief EXTCOMIN toggle of the display driver, from the RTC interrupt
  *****************************************************************************/
-void initRTC()
+static void polarityTick(swtimer_TypeDef *timer, void *user)
 {
-  /* Starting LFXO and waiting until it is stable */
-  CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
-
-  /* Routing the LFXO clock to the RTC */
-  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
-  CMU_ClockEnable(cmuClock_RTC, true);
-
-  /* Enabling clock to the interface of the low energy modules */
-  CMU_ClockEnable(cmuClock_CORELE, true);
-
-  const RTC_Init_TypeDef rtcInit =
-  {
-    .enable   = true,
-    .debugRun = false,
-    .comp0Top = true,
-  };
+  (void)timer;
 
-  RTC_Init(&rtcInit);
-
-  /* Set comapre value for compare register 0 */
-  RTC_CompareSet(0, RTC_COUNT_BETWEEN_WAKEUP);
+  polarityFunction(user);
+}
 
-  /* Enable interrupt for compare register 0 */
-  RTC_IntEnable(RTC_IFC_COMP0);
+/**************************************************************************//**
+ * @brief PAL_TIMER_REPEAT_FUNCTION of the project, called by DISPLAY_Init()
+ * With it the display PAL leaves the RTC alone: its auto toggle would make
+ * COMP0 the TOP of the RTC, the swtimer counter would wrap there. The driver
+ * asks for 64 Hz, every call wakes the core from EM2, so the toggle runs at
+ * DISPLAY_POLARITY_TOGGLE_HZ instead, enough for the memory LCD.
+ *****************************************************************************/
+int displayPolarityRepeat(void (*pFunction)(void *), void *argument,
+                          unsigned int frequency)
+{
+  (void)frequency;
 
-  /* Enabling Interrupt from RTC */
-  NVIC_EnableIRQ(RTC_IRQn);
+  polarityFunction = pFunction;
+  swtimerStart(&polarityTimer, SWTIMER_HZ / DISPLAY_POLARITY_TOGGLE_HZ,
+               SWTIMER_HZ / DISPLAY_POLARITY_TOGGLE_HZ, polarityTick, argument);
+  return 0;
 }
 
 int main(void)
@@ -263,8 +315,19 @@ int main(void)
 
   /* Setup GPIO for pushbuttons. */
   GpioSetup();
-  initRTC();
-  /* Initialize the display module. */
+  swtimerInit();
+  timestampInit();
+
+  /* Handler run times from the timestamp counter */
+  const isrStatsInit_TypeDef statsInit =
+  {
+    .clock     = timestampGet,
+    .clockMask = 0xFFFFFFFFUL,
+    .clockHz   = timestampFrequency(),
+  };
+  isrStatsInit(&statsInit);
+
+  /* Initialize the display module, after the swtimer it toggles EXTCOMIN on */
   displayEnabled = true;
   DISPLAY_Init();
 
@@ -285,9 +348,19 @@ int main(void)
 
   while (1)
     {
-      /* Go to EM2 */
+      /* Go to EM2, the deepest mode the RTC keeps counting in */
       EMU_EnterEM2(true);
       /* Wait for interrupts */
+
+      /* The dump is slow on the LCD, keep it out of the handlers */
+      if (statsRequested)
+      {
+        statsRequested = false;
+        uint32_t start = timestampGet();
+        isrStatsDump();
+        printf("\ndump %lu us", (unsigned long)timestampToUs(timestampGet() - start));
+        isrStatsReset();
+      }
     }
 }
 
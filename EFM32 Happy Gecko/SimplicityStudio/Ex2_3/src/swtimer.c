@@ -0,0 +1,411 @@
+/**************************************************************************//**
+ * @file swtimer.c
+ * @brief Software timers on RTC compare channel 1
+ *
+ * The wheel has LEVELS levels of SLOTS lists, level n slots are 64^n ticks
+ * wide. A timer goes to the lowest level where its expiry shares the upper
+ * bits with the wheel time, so starting one is a few shifts and a list
+ * insert and stopping one a list remove. When the wheel time reaches the
+ * start of a slot above level 0 its timers are spread over the levels
+ * below; level 0 slots are single ticks and expire.
+ *
+ * Occupied slots are marked in a bitmap per level. The next expiry is the
+ * first marked level 0 slot, or the earliest timer in the first marked slot
+ * of a higher level, and only that is put in COMP1. The RTC is extended to
+ * 32 bits in software; COMP1 wakes the core at least every MAX_SLEEP ticks
+ * for that even with no timer running.
+ *****************************************************************************/
+#include <stddef.h>
+
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_rtc.h"
+#include "isr_stats.h"
+#include "swtimer.h"
+
+#define LEVELS          4
+#define SLOT_BITS       6
+#define SLOTS           (1U << SLOT_BITS)
+#define SLOT_MASK       (SLOTS - 1)
+
+#define RTC_MAX         0xFFFFFFUL
+
+/* COMP1 is set at least this many ticks ahead, nearer expiries are late */
+#define COMP_MIN        3
+
+/* Longest time between two reads of the RTC counter */
+#define MAX_SLEEP       (1UL << 22)
+
+static swtimer_TypeDef *wheel[LEVELS * SLOTS];
+static uint64_t occupied[LEVELS];
+static uint32_t now;          /* Wheel time, all before it is done */
+static uint32_t hwTime;       /* RTC counter extended to 32 bits */
+static uint32_t lastCnt;
+static uint32_t armed;        /* Time COMP1 is set to */
+static isrStats_TypeDef rtcStats = ISR_STATS_INIT("RTC");
+
+/**************************************************************************//**
+ * @brief Slot of a time on a level
+ *****************************************************************************/
+static unsigned int slotOf(uint32_t t, unsigned int level)
+{
+  return (t >> (level * SLOT_BITS)) & SLOT_MASK;
+}
+
+/**************************************************************************//**
+ * @brief Index of the lowest set bit, bits must not be 0
+ *****************************************************************************/
+static unsigned int lowestBit(uint64_t bits)
+{
+  unsigned int n = 0;
+  unsigned int width;
+
+  for (width = 32; width > 0; width /= 2)
+  {
+    if ((bits & ((1ULL << width) - 1)) == 0)
+    {
+      bits >>= width;
+      n += width;
+    }
+  }
+  return n;
+}
+
+/**************************************************************************//**
+ * @brief RTC counter extended to 32 bits
+ *****************************************************************************/
+static uint32_t hwNow(void)
+{
+  uint32_t cnt = RTC_CounterGet();
+
+  hwTime += (cnt - lastCnt) & RTC_MAX;
+  lastCnt = cnt;
+  return hwTime;
+}
+
+/**************************************************************************//**
+ * @brief Wake up at time t, or as soon as COMP1 can
+ *****************************************************************************/
+static void arm(uint32_t t)
+{
+  uint32_t delta = t - hwNow();
+
+  if ((int32_t)delta < COMP_MIN)
+  {
+    delta = COMP_MIN;
+  }
+  if (delta > MAX_SLEEP)
+  {
+    delta = MAX_SLEEP;
+  }
+  armed = hwTime + delta;
+  RTC_CompareSet(1, (lastCnt + delta) & RTC_MAX);
+}
+
+/**************************************************************************//**
+ * @brief Put a timer in the slot for its expiry
+ *****************************************************************************/
+static void insert(swtimer_TypeDef *timer)
+{
+  uint32_t expiry = timer->expiry;
+  unsigned int level = 0;
+  unsigned int slot;
+
+  while (level < LEVELS - 1 && ((expiry ^ now) >> ((level + 1) * SLOT_BITS)) != 0)
+  {
+    level++;
+  }
+  slot = slotOf(expiry, level);
+
+  timer->slot  = level * SLOTS + slot;
+  timer->next  = wheel[timer->slot];
+  timer->pprev = &wheel[timer->slot];
+  if (timer->next != NULL)
+  {
+    timer->next->pprev = &timer->next;
+  }
+  wheel[timer->slot] = timer;
+  occupied[level] |= 1ULL << slot;
+}
+
+/**************************************************************************//**
+ * @brief Take a timer out of its slot
+ *****************************************************************************/
+static void unlink(swtimer_TypeDef *timer)
+{
+  *timer->pprev = timer->next;
+  if (timer->next != NULL)
+  {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->pprev = NULL;
+  if (wheel[timer->slot] == NULL)
+  {
+    occupied[timer->slot / SLOTS] &= ~(1ULL << (timer->slot % SLOTS));
+  }
+}
+
+/**************************************************************************//**
+ * @brief First occupied slot after the wheel time
+ * Below the top level the slots up to the wheel time's are empty; on the
+ * top level those are a turn of the wheel ahead.
+ *****************************************************************************/
+static bool nextSlot(unsigned int *level, unsigned int *slot)
+{
+  uint64_t after;
+  unsigned int l;
+
+  for (l = 0; l < LEVELS; l++)
+  {
+    after = occupied[l] & ~((2ULL << slotOf(now, l)) - 1);
+    if (after == 0 && l == LEVELS - 1)
+    {
+      after = occupied[l];
+    }
+    if (after != 0)
+    {
+      *level = l;
+      *slot  = lowestBit(after);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * @brief First tick of a slot after the wheel time
+ *****************************************************************************/
+static uint32_t slotStart(unsigned int level, unsigned int slot)
+{
+  unsigned int shift = level * SLOT_BITS;
+  uint32_t turn = 1UL << (shift + SLOT_BITS);
+  uint32_t start = (now & ~(turn - 1)) + ((uint32_t)slot << shift);
+
+  if (slot <= slotOf(now, level))
+  {
+    start += turn;
+  }
+  return start;
+}
+
+/**************************************************************************//**
+ * @brief Earliest expiry of all running timers
+ *****************************************************************************/
+static bool nextExpiry(uint32_t *expiry)
+{
+  const swtimer_TypeDef *timer;
+  unsigned int level, slot;
+
+  if (!nextSlot(&level, &slot))
+  {
+    return false;
+  }
+  if (level == 0)
+  {
+    *expiry = slotStart(0, slot);
+    return true;
+  }
+
+  /* A higher level slot holds a range of expiries */
+  timer   = wheel[level * SLOTS + slot];
+  *expiry = timer->expiry;
+  for (timer = timer->next; timer != NULL; timer = timer->next)
+  {
+    if (timer->expiry - now < *expiry - now)
+    {
+      *expiry = timer->expiry;
+    }
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Run the wheel up to the target time
+ * A callback may start and stop any timer, the one it belongs to included.
+ *****************************************************************************/
+static void advance(uint32_t target)
+{
+  swtimer_TypeDef *timer;
+  unsigned int level, slot, index;
+  uint32_t start;
+
+  while (nextSlot(&level, &slot))
+  {
+    start = slotStart(level, slot);
+    if (start - now > target - now)
+    {
+      break;
+    }
+    now = start;
+
+    /* Spread over the lower levels, expiring now goes to the level 0 slot */
+    index = level * SLOTS + slot;
+    while (level > 0 && (timer = wheel[index]) != NULL)
+    {
+      unlink(timer);
+      insert(timer);
+    }
+
+    index = slotOf(now, 0);
+    while ((timer = wheel[index]) != NULL)
+    {
+      unlink(timer);
+      if (timer->period != 0)
+      {
+        timer->expiry += timer->period;
+        insert(timer);
+      }
+      timer->callback(timer, timer->user);
+    }
+  }
+  now = target;
+}
+
+/**************************************************************************//**
+ * @brief RTC compare 1, expire what is due and set the next wake-up
+ *****************************************************************************/
+void RTC_IRQHandler(void)
+{
+  uint32_t next;
+  bool pending;
+
+  isrStatsEnter();
+  RTC_IntClear(RTC_IFC_COMP1);
+
+  /* The counter must run all 24 bits, the display PAL's EXTCOMIN auto
+   * toggle would have made COMP0 the TOP */
+  EFM_ASSERT((RTC->CTRL & RTC_CTRL_COMP0TOP) == 0);
+
+  /* Callbacks take time, timers may have become due meanwhile */
+  do
+  {
+    advance(hwNow());
+    pending = nextExpiry(&next);
+  } while (pending && (int32_t)(next - hwNow()) <= 0);
+
+  arm(pending ? next : hwTime + MAX_SLEEP);
+  isrStatsExit(&rtcStats);
+}
+
+/**************************************************************************//**
+ * @brief Start the RTC from the LFXO, no timers running
+ * Takes over the RTC and its interrupt, COMP0 is left unused. Nothing else
+ * may reconfigure the RTC; the display PAL does unless the project gives it
+ * a PAL_TIMER_REPEAT_FUNCTION for EXTCOMIN.
+ *****************************************************************************/
+void swtimerInit(void)
+{
+  unsigned int i;
+
+  /* Starting LFXO and waiting until it is stable */
+  CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+
+  /* Routing the LFXO clock to the RTC */
+  CMU_ClockSelectSet(cmuClock_LFA, cmuSelect_LFXO);
+  CMU_ClockEnable(cmuClock_RTC, true);
+
+  /* Enabling clock to the interface of the low energy modules */
+  CMU_ClockEnable(cmuClock_CORELE, true);
+
+  const RTC_Init_TypeDef rtcInit =
+  {
+    .enable   = true,
+    .debugRun = false,
+    .comp0Top = false,                    /* Free running, all 24 bits */
+  };
+  RTC_Init(&rtcInit);
+
+  for (i = 0; i < LEVELS * SLOTS; i++)
+  {
+    wheel[i] = NULL;
+  }
+  for (i = 0; i < LEVELS; i++)
+  {
+    occupied[i] = 0;
+  }
+  lastCnt = RTC_CounterGet();
+  hwTime  = 0;
+  now     = 0;
+  arm(MAX_SLEEP);
+
+  RTC_IntClear(RTC_IFC_COMP1);
+  RTC_IntEnable(RTC_IEN_COMP1);
+  NVIC_ClearPendingIRQ(RTC_IRQn);
+  NVIC_EnableIRQ(RTC_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief Start or restart a timer
+ * The callback runs delay ticks from now and then every period ticks, once
+ * only for a period of 0. A delay of 0 counts as 1.
+ *****************************************************************************/
+void swtimerStart(swtimer_TypeDef *timer, uint32_t delay, uint32_t period,
+                  swtimerCallback_TypeDef callback, void *user)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  EFM_ASSERT(callback != NULL);
+  EFM_ASSERT(delay <= SWTIMER_MAX_TICKS && period <= SWTIMER_MAX_TICKS);
+
+  if (delay == 0)
+  {
+    delay = 1;
+  }
+
+  CORE_ENTER_ATOMIC();
+  if (timer->pprev != NULL)
+  {
+    unlink(timer);
+  }
+  timer->expiry   = hwNow() + delay;
+  timer->period   = period;
+  timer->callback = callback;
+  timer->user     = user;
+  insert(timer);
+  if ((int32_t)(timer->expiry - armed) < 0)
+  {
+    arm(timer->expiry);
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Stop a timer, nothing happens if it is not running
+ * COMP1 stays set, a wake-up for it finds nothing to do.
+ *****************************************************************************/
+void swtimerStop(swtimer_TypeDef *timer)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (timer->pprev != NULL)
+  {
+    unlink(timer);
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Whether a timer is waiting to expire
+ *****************************************************************************/
+bool swtimerRunning(const swtimer_TypeDef *timer)
+{
+  return timer->pprev != NULL;
+}
+
+/**************************************************************************//**
+ * @brief Time in RTC ticks, wraps after 2^32
+ *****************************************************************************/
+uint32_t swtimerNow(void)
+{
+  uint32_t t;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  t = hwNow();
+  CORE_EXIT_ATOMIC();
+
+  return t;
+}
@@ -0,0 +1,48 @@
+/**************************************************************************//**
+ * @file swtimer.h
+ * @brief Software timers on RTC compare channel 1
+ *
+ * Any number of one-shot and periodic timers share the RTC, which counts
+ * LFXO ticks freely; COMP1 is set to the next expiry only, so there is no
+ * periodic tick and the core can stay in EM2 between expiries. Timers are
+ * kept in a hierarchical timer wheel, starting and stopping one does not
+ * depend on how many are running. Callbacks run in the RTC interrupt. The
+ * display PAL must not use the RTC for EXTCOMIN, see swtimerInit().
+ *****************************************************************************/
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* RTC ticks per second, the LFXO undivided */
+#define SWTIMER_HZ                32768
+#define SWTIMER_MS_TO_TICKS(ms)   ((uint32_t)(((uint64_t)(ms) * SWTIMER_HZ) / 1000))
+
+/* Longest delay or period, 256 s */
+#define SWTIMER_MAX_TICKS         (1UL << 23)
+
+typedef struct swtimer swtimer_TypeDef;
+
+typedef void (*swtimerCallback_TypeDef)(swtimer_TypeDef *timer, void *user);
+
+/* Allocated zeroed by the caller, owned by the service while running */
+struct swtimer
+{
+  swtimer_TypeDef         *next;
+  swtimer_TypeDef         **pprev;    /* NULL when not running */
+  uint32_t                expiry;
+  uint32_t                period;     /* 0 for a one-shot timer */
+  uint8_t                 slot;
+  swtimerCallback_TypeDef callback;
+  void                    *user;
+};
+
+void swtimerInit(void);
+void swtimerStart(swtimer_TypeDef *timer, uint32_t delay, uint32_t period,
+                  swtimerCallback_TypeDef callback, void *user);
+void swtimerStop(swtimer_TypeDef *timer);
+bool swtimerRunning(const swtimer_TypeDef *timer);
+uint32_t swtimerNow(void);
+
+#endif /* SWTIMER_H */
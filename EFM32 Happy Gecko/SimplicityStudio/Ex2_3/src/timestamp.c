@@ -0,0 +1,127 @@
+/**************************************************************************//**
+ * @file timestamp.c
+ * @brief Free-running 32 bit timestamp from TIMER0 and TIMER1 in cascade
+ *
+ * TIMER1 is clocked by TIMER0 overflows (clkSel cascade) and synchronized
+ * to it, so a start, stop or reload of TIMER0 does the same to TIMER1. The
+ * high half is counted a clock after the low half wraps; a read is repeated
+ * until the high half is stable around it and the low half is past that
+ * clock. TIMER1 overflows are counted in its interrupt for the 64 bit time,
+ * at 14 MHz that is once every five minutes.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_timer.h"
+#include "timestamp.h"
+
+/* TIMER0 counts after a wrap before TIMER1 is sure to have counted it */
+#define CASCADE_SETTLE    4
+
+static volatile uint32_t overflows;
+static uint32_t frequency;
+
+/**************************************************************************//**
+ * @brief TIMER1 overflow, the 32 bit counter wrapped
+ *****************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  TIMER_IntClear(TIMER1, TIMER_IFC_OF);
+  overflows++;
+}
+
+/**************************************************************************//**
+ * @brief Start the counter from zero
+ * Takes over TIMER0, TIMER1 and the TIMER1 interrupt.
+ *****************************************************************************/
+void timestampInit(void)
+{
+  TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = true,                   /* TIMER1 first, it waits for TIMER0 */
+    .debugRun   = false,                  /* Counter not running on debug halt */
+    .prescale   = timerPrescale1,         /* Every HFPERCLK cycle */
+    .clkSel     = timerClkSelCascade,     /* TIMER1 counts TIMER0 overflows */
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = true,                   /* Start/stop/reload with TIMER0 */
+  };
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  TIMER_TopSet(TIMER1, 0xFFFF);
+  TIMER_CounterSet(TIMER1, 0);
+  TIMER_Init(TIMER1, &timerInit);
+  TIMER_IntClear(TIMER1, TIMER_IFC_OF);
+  TIMER_IntEnable(TIMER1, TIMER_IEN_OF);
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);
+  NVIC_EnableIRQ(TIMER1_IRQn);
+
+  timerInit.clkSel = timerClkSelHFPerClk;
+  timerInit.sync   = false;
+  TIMER_TopSet(TIMER0, 0xFFFF);
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_Init(TIMER0, &timerInit);
+
+  overflows = 0;
+  frequency = CMU_ClockFreqGet(cmuClock_TIMER0);
+}
+
+/**************************************************************************//**
+ * @brief Time in HFPERCLK cycles, wraps after 2^32
+ * Safe from any context, the timers are only read.
+ *****************************************************************************/
+uint32_t timestampGet(void)
+{
+  uint32_t high, low;
+
+  do
+  {
+    high = TIMER1->CNT;
+    low  = TIMER0->CNT;
+  } while (high != TIMER1->CNT || low < CASCADE_SETTLE);
+
+  return (high << 16) | low;
+}
+
+/**************************************************************************//**
+ * @brief Time in HFPERCLK cycles, with the wraps counted in software
+ * An overflow that is pending while interrupts are masked is counted here.
+ *****************************************************************************/
+uint64_t timestampGet64(void)
+{
+  uint32_t high, low;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  low  = timestampGet();
+  high = overflows;
+  if ((TIMER1->IF & TIMER_IF_OF) && low < 0x80000000UL)
+  {
+    high++;
+  }
+  CORE_EXIT_ATOMIC();
+
+  return ((uint64_t)high << 32) | low;
+}
+
+/**************************************************************************//**
+ * @brief Counter frequency in Hz, HFPERCLK at timestampInit()
+ *****************************************************************************/
+uint32_t timestampFrequency(void)
+{
+  return frequency;
+}
+
+/**************************************************************************//**
+ * @brief Convert a difference of two timestamps to microseconds
+ *****************************************************************************/
+uint32_t timestampToUs(uint32_t ticks)
+{
+  return (uint32_t)((uint64_t)ticks * 1000000 / frequency);
+}
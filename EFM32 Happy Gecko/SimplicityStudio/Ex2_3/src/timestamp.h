@@ -0,0 +1,21 @@
+/**************************************************************************//**
+ * @file timestamp.h
+ * @brief Free-running 32 bit timestamp from TIMER0 and TIMER1 in cascade
+ *
+ * TIMER0 counts HFPERCLK, TIMER1 counts TIMER0 overflows, together one
+ * 32 bit counter at HFPERCLK resolution. timestampGet64() extends it in
+ * software. The timers stop in EM2 and below, time spent there is not
+ * counted.
+ *****************************************************************************/
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdint.h>
+
+void timestampInit(void);
+uint32_t timestampGet(void);
+uint64_t timestampGet64(void);
+uint32_t timestampFrequency(void);
+uint32_t timestampToUs(uint32_t ticks);
+
+#endif /* TIMESTAMP_H */
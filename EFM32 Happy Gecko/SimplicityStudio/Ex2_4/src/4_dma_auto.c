@@ -30,6 +30,8 @@
 #include "retargettextdisplay.h"
 #include "em4config.h"
 
+#include "dma_copy.h"
+
 
 static DISPLAY_Device_t displayDevice;    /* Display device handle.*/
 
@@ -45,8 +47,8 @@ DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((align
 #error Undefined toolkit, need to define alignment
 #endif
 
-/* DMA channel to use */
-#define DMA_CHANNEL_FLASH    0
+/* Number of DMA channels shared by the copy service */
+#define DMA_COPY_CHANNELS    2
 
 /* Status of the transfer */
 bool flashTransferActive;
@@ -60,68 +62,59 @@ const char flashData[8] = "TESTING";
 /* Buffer to transfer to - initialize with zeros */
 char ramBuffer[9] = { 0 };
 
+/* Bulk buffer filled by the DMA while the CPU keeps working */
+static uint32_t bulkBuffer[256];
+
 /**************************************************************************//**
- * @brief DMA callback function
- * This function is called when the DMA transfer is complete
+ * @brief Copy callback function
+ * This function is called when the transfer is complete
  *****************************************************************************/
-void flashTransferComplete(unsigned int channel, bool primary, void *user)
+void flashTransferComplete(void *user)
 {
   /* Clearing flag to indicate that transfer is complete */
   flashTransferActive = false;
-
-  /* Indicate that the transfer is complete turning on the antenna symbol
-   * and write the content of the ramBuffer to the LCD screen */
-  printf("\nANT\n");
-  printf("%s",ramBuffer);
 }
 
 /**************************************************************************//**
  * @brief Flash transfer function
- * This function sets up the DMA transfer
+ * The copy service picks the DMA or the CPU depending on the size
  *****************************************************************************/
 void performFlashTransfer(void)
 {
-  /* Setting call-back function */
-  DMA_CB_TypeDef cb[DMA_CHAN_COUNT];
-  cb[DMA_CHANNEL_FLASH].cbFunc = flashTransferComplete;
-
-  /* usrPtr can be used to send data to the callback function,
-   * but this is not used here, which is indicated by the NULL pointer */
-  cb[DMA_CHANNEL_FLASH].userPtr = NULL;
-
-  /* Setting up channel */
-  DMA_CfgChannel_TypeDef chnlCfg;
-  chnlCfg.highPri   = false;
-  chnlCfg.enableInt = true;
-  chnlCfg.select    = 0;
-  chnlCfg.cb        = &(cb[DMA_CHANNEL_FLASH]);
-  DMA_CfgChannel(DMA_CHANNEL_FLASH, &chnlCfg);
-
-  /* Setting up transfer descriptor */
-  DMA_CfgDescr_TypeDef descrCfg;
-  descrCfg.dstInc  = dmaDataInc1;
-  descrCfg.srcInc  = dmaDataInc1;
-  descrCfg.size    = dmaDataSize1;
-  descrCfg.arbRate = dmaArbitrate1;
-  descrCfg.hprot   = 0;
-  DMA_CfgDescr(DMA_CHANNEL_FLASH, true, &descrCfg);
+  dmaCopy_TypeDef copy;
 
   /* Setting flag to indicate that transfer is in progress
    * will be cleared by call-back function */
   flashTransferActive = true;
 
-  /* Starting the transfer. Using Auto (all data is transfered at once) */
-  DMA_ActivateAuto(DMA_CHANNEL_FLASH,
-                   true,
-                   (void *) &ramBuffer,
-                   (void *) &flashData,
-                   FLASHDATA_SIZE - 1);
+  dmaCopyStart(&copy, ramBuffer, flashData, FLASHDATA_SIZE,
+               flashTransferComplete, NULL);
 
   /* Entering EM1 to wait for completion (the DMA requires EM1) */
-  while (flashTransferActive)
+  dmaCopyWait(&copy);
+
+  /* Indicate that the transfer is complete turning on the antenna symbol
+   * and write the content of the ramBuffer to the LCD screen */
+  printf("\nANT\n");
+  printf("%s %s", ramBuffer, copy.usedDma ? "DMA" : "CPU");
+}
+
+/**************************************************************************//**
+ * @brief Bulk fill function
+ * The CPU counts while the DMA fills, to show the overlap
+ *****************************************************************************/
+void performBulkFill(void)
+{
+  dmaCopy_TypeDef fill;
+  uint32_t work = 0;
+
+  dmaFillStart(&fill, bulkBuffer, 0x55, sizeof(bulkBuffer), NULL, NULL);
+  while (!dmaCopyDone(&fill))
   {
-    EMU_EnterEM1();
+    work++;
   }
+
+  printf("\nfill %s, %lu loops", fill.usedDma ? "DMA" : "CPU", (unsigned long) work);
 }
 
 /**************************************************************************//**
@@ -156,8 +149,25 @@ int main(void)
   dmaInit.controlBlock = dmaControlBlock;
   DMA_Init(&dmaInit);
 
-  /* Configure the DMA and perform the transfer */
+  /* Share two channels for copies, pick the DMA/CPU threshold in the bulk
+   * buffer before it is used */
+  dmaCopyInit(DMA_COPY_CHANNELS);
+  if (!dmaCopyCalibrate(bulkBuffer, sizeof(bulkBuffer)))
+  {
+    printf("\ncopy not calibrated");
+  }
+  else if (dmaCopyThresholdGet() == DMA_COPY_CPU_ONLY)
+  {
+    printf("\ncopy always CPU");
+  }
+  else
+  {
+    printf("\ncopy threshold %lu B", (unsigned long) dmaCopyThresholdGet());
+  }
+
+  /* Perform the transfers */
   performFlashTransfer();
+  performBulkFill();
 
   while (1)
   {
@@ -0,0 +1,116 @@
+/**************************************************************************//**
+ * @file dma_channel.c
+ * @brief Static DMA channel manager
+ *
+ * Allocation and release can be called from interrupt handlers, e.g. a
+ * completion callback releasing its own channel.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_core.h"
+#include "em_assert.h"
+#include "dma_channel.h"
+
+/* Projects with their own DMA_IRQHandler keep its callback table up to date */
+#if defined(EXCLUDE_DEFAULT_DMA_IRQ_HANDLER)
+#include "dma_dispatch.h"
+#define DMA_CHANNEL_CFG    dmaDispatchCfgChannel
+#else
+#define DMA_CHANNEL_CFG    DMA_CfgChannel
+#endif
+
+static uint32_t inUse;
+static DMA_CB_TypeDef callbacks[DMA_CHAN_COUNT];
+static dmaChannelUsage_TypeDef usage[DMA_CHAN_COUNT];
+
+/**************************************************************************//**
+ * @brief Allocate and configure a channel
+ * Returns the channel, or DMA_CHANNEL_NONE when all are in use. DMA_Init
+ * must have been called.
+ *****************************************************************************/
+int dmaChannelAlloc(const dmaChannelCfg_TypeDef *cfg)
+{
+  CORE_DECLARE_IRQ_STATE;
+  DMA_CfgChannel_TypeDef chnlCfg;
+  int channel = DMA_CHANNEL_NONE;
+  int candidate;
+  int i;
+
+  CORE_ENTER_CRITICAL();
+  for (i = 0; i < DMA_CHAN_COUNT; i++)
+  {
+    /* High priority from the bottom, default from the top */
+    candidate = cfg->highPri ? i : DMA_CHAN_COUNT - 1 - i;
+    if (!(inUse & (1UL << candidate)))
+    {
+      channel = candidate;
+      inUse |= 1UL << channel;
+      break;
+    }
+  }
+  CORE_EXIT_CRITICAL();
+
+  if (channel == DMA_CHANNEL_NONE)
+  {
+    return DMA_CHANNEL_NONE;
+  }
+
+  usage[channel].owner   = cfg->owner ? cfg->owner : "?";
+  usage[channel].highPri = cfg->highPri;
+  usage[channel].allocations++;
+
+  callbacks[channel].cbFunc  = cfg->cbFunc;
+  callbacks[channel].userPtr = cfg->userPtr;
+  callbacks[channel].primary = true;
+
+  chnlCfg.highPri   = cfg->highPri;
+  chnlCfg.enableInt = cfg->enableInt;
+  chnlCfg.select    = cfg->select;
+  chnlCfg.cb        = &callbacks[channel];
+  DMA_CHANNEL_CFG(channel, &chnlCfg);
+
+  return channel;
+}
+
+/**************************************************************************//**
+ * @brief Stop a channel and return it to the free pool
+ *****************************************************************************/
+void dmaChannelRelease(unsigned int channel)
+{
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t bit = 1UL << channel;
+
+  EFM_ASSERT(channel < DMA_CHAN_COUNT);
+  EFM_ASSERT(inUse & bit);
+
+  CORE_ENTER_CRITICAL();
+  DMA->CHENC = bit;
+  DMA->IEN  &= ~bit;
+  DMA->IFC   = bit;
+  callbacks[channel].cbFunc  = NULL;
+  callbacks[channel].userPtr = NULL;
+  usage[channel].owner = NULL;
+  inUse &= ~bit;
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief Change the user pointer passed to the channel's callback
+ *****************************************************************************/
+void dmaChannelUserSet(unsigned int channel, void *userPtr)
+{
+  EFM_ASSERT(channel < DMA_CHAN_COUNT);
+
+  callbacks[channel].userPtr = userPtr;
+}
+
+uint32_t dmaChannelInUse(void)
+{
+  return inUse;
+}
+
+const dmaChannelUsage_TypeDef *dmaChannelUsageGet(unsigned int channel)
+{
+  EFM_ASSERT(channel < DMA_CHAN_COUNT);
+
+  return &usage[channel];
+}
@@ -0,0 +1,299 @@
+/**************************************************************************//**
+ * @file dma_copy.c
+ * @brief Asynchronous memory copy and fill on a pool of DMA channels
+ *
+ * A transfer uses the widest element size the addresses and length allow
+ * and is split into auto-request cycles of at most 1024 elements, the
+ * completion callback starts the next one. Calibration times both ways with
+ * the cycle counter.
+ *****************************************************************************/
+#include <string.h>
+
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_core.h"
+#include "em_dma.h"
+#include "em_emu.h"
+#include "cycle_counter.h"
+#include "dma_channel.h"
+#include "dma_copy.h"
+
+#define DMA_COPY_MAX_ELEMENTS   1024
+#define DMA_COPY_ARBRATE        dmaArbitrate8
+
+/* Calibration sizes, doubling from MIN to MAX bytes */
+#define DMA_COPY_CAL_MIN        8
+#define DMA_COPY_CAL_MAX        512
+
+static uint32_t freeChannels;
+static uint32_t threshold = DMA_COPY_CAL_MAX;
+
+/**************************************************************************//**
+ * @brief Start the next auto-request cycle of a transfer
+ *****************************************************************************/
+static void activateChunk(dmaCopy_TypeDef *copy)
+{
+  DMA_CfgDescr_TypeDef descrCfg;
+
+  copy->chunk = copy->remaining;
+  if (copy->chunk > DMA_COPY_MAX_ELEMENTS)
+  {
+    copy->chunk = DMA_COPY_MAX_ELEMENTS;
+  }
+
+  descrCfg.dstInc  = (DMA_DataInc_TypeDef)copy->shift;
+  descrCfg.srcInc  = copy->fill ? dmaDataIncNone : (DMA_DataInc_TypeDef)copy->shift;
+  descrCfg.size    = (DMA_DataSize_TypeDef)copy->shift;
+  descrCfg.arbRate = DMA_COPY_ARBRATE;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(copy->channel, true, &descrCfg);
+
+  DMA_ActivateAuto(copy->channel,
+                   true,
+                   copy->dst,
+                   copy->fill ? (const void *)&copy->fillWord : copy->src,
+                   copy->chunk - 1);
+}
+
+static void finish(dmaCopy_TypeDef *copy)
+{
+  copy->done = true;
+  if (copy->cbFunc)
+  {
+    copy->cbFunc(copy->user);
+  }
+}
+
+/**************************************************************************//**
+ * @brief DMA callback, continues or completes the transfer
+ *****************************************************************************/
+static void chunkDone(unsigned int channel, bool primary, void *user)
+{
+  dmaCopy_TypeDef *copy = user;
+  uint32_t bytes = copy->chunk << copy->shift;
+
+  copy->remaining -= copy->chunk;
+  copy->dst += bytes;
+  if (!copy->fill)
+  {
+    copy->src += bytes;
+  }
+
+  if (copy->remaining)
+  {
+    activateChunk(copy);
+    return;
+  }
+
+  freeChannels |= 1UL << channel;
+  finish(copy);
+}
+
+static int allocChannel(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  int channel = -1;
+  uint32_t bit;
+
+  CORE_ENTER_CRITICAL();
+  if (freeChannels)
+  {
+    bit = freeChannels & (0 - freeChannels);
+    freeChannels &= ~bit;
+    for (channel = 0; !(bit & 1); bit >>= 1)
+    {
+      channel++;
+    }
+  }
+  CORE_EXIT_CRITICAL();
+
+  return channel;
+}
+
+/**************************************************************************//**
+ * @brief Common start of copies and fills
+ *****************************************************************************/
+static void start(dmaCopy_TypeDef *copy, void *dst, const void *src, uint32_t bytes,
+                  bool fill, uint32_t limit)
+{
+  uint32_t align = (uint32_t)dst | bytes | (fill ? 0 : (uint32_t)src);
+  int channel = -1;
+
+  copy->done    = false;
+  copy->usedDma = false;
+  copy->dst     = dst;
+  copy->src     = src;
+  copy->fill    = fill;
+
+  if (limit != DMA_COPY_CPU_ONLY && bytes >= limit && bytes > 0)
+  {
+    channel = allocChannel();
+  }
+
+  if (channel < 0)
+  {
+    if (fill)
+    {
+      memset(dst, (int)(copy->fillWord & 0xFF), bytes);
+    }
+    else
+    {
+      memcpy(dst, src, bytes);
+    }
+    finish(copy);
+    return;
+  }
+
+  copy->shift = (align & 3) == 0 ? 2 : ((align & 1) == 0 ? 1 : 0);
+  copy->remaining = bytes >> copy->shift;
+  copy->channel   = channel;
+  copy->usedDma   = true;
+  dmaChannelUserSet(channel, copy);
+  activateChunk(copy);
+}
+
+/**************************************************************************//**
+ * @brief Take up to 'channels' default priority channels for the pool
+ * DMA_Init must have been called. Returns the number of channels obtained,
+ * with none every transfer is done by the CPU.
+ *****************************************************************************/
+unsigned int dmaCopyInit(unsigned int channels)
+{
+  dmaChannelCfg_TypeDef chnlCfg;
+  unsigned int count;
+  int channel;
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = 0;
+  chnlCfg.cbFunc    = chunkDone;
+  chnlCfg.userPtr   = NULL;
+  chnlCfg.owner     = "copy";
+
+  for (count = 0; count < channels; count++)
+  {
+    channel = dmaChannelAlloc(&chnlCfg);
+    if (channel == DMA_CHANNEL_NONE)
+    {
+      break;
+    }
+    freeChannels |= 1UL << channel;
+  }
+  return count;
+}
+
+/**************************************************************************//**
+ * @brief Time CPU and DMA copies of growing size
+ * The threshold becomes the first size where the DMA finishes first,
+ * counting its setup and interrupt, DMA_COPY_CPU_ONLY when it never does.
+ * The copies go from one half of the caller's word aligned scratch buffer
+ * to the other, sizes up to half of it and at most DMA_COPY_CAL_MAX.
+ * Returns false and keeps the threshold when no copy got a DMA channel.
+ * Starts the cycle counter.
+ *****************************************************************************/
+bool dmaCopyCalibrate(void *scratch, uint32_t scratchBytes)
+{
+  uint8_t *calSrc = scratch;
+  uint8_t *calDst = calSrc + scratchBytes / 2;
+  dmaCopy_TypeDef copy;
+  uint32_t bytes;
+  uint32_t t0;
+  uint32_t cpuCycles;
+  uint32_t dmaCycles;
+  bool measured = false;
+
+  EFM_ASSERT(((uint32_t)scratch & 3) == 0 && scratchBytes >= 2 * DMA_COPY_CAL_MIN);
+
+  cycleCounterStart();
+
+  copy.cbFunc = NULL;
+  for (bytes = DMA_COPY_CAL_MIN;
+       bytes <= DMA_COPY_CAL_MAX && bytes <= scratchBytes / 2;
+       bytes <<= 1)
+  {
+    t0 = cycleCounterGet();
+    memcpy(calDst, calSrc, bytes);
+    cpuCycles = (cycleCounterGet() - t0) & CYCLE_COUNTER_MASK;
+
+    t0 = cycleCounterGet();
+    start(&copy, calDst, calSrc, bytes, false, 0);
+    while (!copy.done)
+    {
+    }
+    dmaCycles = (cycleCounterGet() - t0) & CYCLE_COUNTER_MASK;
+
+    if (!copy.usedDma)
+    {
+      continue;
+    }
+    measured = true;
+    if (dmaCycles < cpuCycles)
+    {
+      threshold = bytes;
+      return true;
+    }
+  }
+
+  if (measured)
+  {
+    threshold = DMA_COPY_CPU_ONLY;
+  }
+  return measured;
+}
+
+void dmaCopyThresholdSet(uint32_t bytes)
+{
+  threshold = bytes;
+}
+
+uint32_t dmaCopyThresholdGet(void)
+{
+  return threshold;
+}
+
+/**************************************************************************//**
+ * @brief Start copying bytes from src to dst
+ *****************************************************************************/
+void dmaCopyStart(dmaCopy_TypeDef *copy, void *dst, const void *src, uint32_t bytes,
+                  dmaCopyCb_TypeDef cbFunc, void *user)
+{
+  copy->cbFunc = cbFunc;
+  copy->user   = user;
+  start(copy, dst, src, bytes, false, threshold);
+}
+
+/**************************************************************************//**
+ * @brief Start filling bytes at dst with value
+ *****************************************************************************/
+void dmaFillStart(dmaCopy_TypeDef *copy, void *dst, uint8_t value, uint32_t bytes,
+                  dmaCopyCb_TypeDef cbFunc, void *user)
+{
+  copy->cbFunc   = cbFunc;
+  copy->user     = user;
+  copy->fillWord = value * 0x01010101UL;
+  start(copy, dst, NULL, bytes, true, threshold);
+}
+
+bool dmaCopyDone(const dmaCopy_TypeDef *copy)
+{
+  return copy->done;
+}
+
+/**************************************************************************//**
+ * @brief Sleep in EM1 until the transfer is done
+ * Interrupts are masked around the check so the completion can not slip in
+ * between the check and the sleep, a pending interrupt still wakes the core.
+ *****************************************************************************/
+void dmaCopyWait(const dmaCopy_TypeDef *copy)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  while (!copy->done)
+  {
+    EMU_EnterEM1();
+    CORE_EXIT_CRITICAL();
+    CORE_ENTER_CRITICAL();
+  }
+  CORE_EXIT_CRITICAL();
+}
@@ -0,0 +1,52 @@
+/**************************************************************************//**
+ * @file dma_copy.h
+ * @brief Asynchronous memory copy and fill on a pool of DMA channels
+ *
+ * Copies and fills run as auto-request cycles on one of the pool channels,
+ * the caller keeps running and checks or waits on its dmaCopy_TypeDef.
+ * Below the threshold, or when all pool channels are busy, the CPU does the
+ * work straight away and the handle is done on return. The threshold comes
+ * from dmaCopyCalibrate(), which times both paths at startup in a buffer
+ * the caller lends it.
+ *****************************************************************************/
+#ifndef DMA_COPY_H
+#define DMA_COPY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Threshold of a pool where the DMA never beats the CPU */
+#define DMA_COPY_CPU_ONLY   UINT32_MAX
+
+/* Called from the DMA interrupt (or from the start call for CPU copies) */
+typedef void (*dmaCopyCb_TypeDef)(void *user);
+
+typedef struct
+{
+  volatile bool     done;
+  bool              usedDma;
+  unsigned int      channel;
+  uint8_t           *dst;
+  const uint8_t     *src;
+  uint32_t          remaining;  /* Elements still to move */
+  uint32_t          chunk;      /* Elements in the running cycle */
+  unsigned int      shift;      /* log2 of the element size */
+  bool              fill;
+  uint32_t          fillWord;   /* Source of a fill */
+  dmaCopyCb_TypeDef cbFunc;
+  void              *user;
+} dmaCopy_TypeDef;
+
+unsigned int dmaCopyInit(unsigned int channels);
+bool dmaCopyCalibrate(void *scratch, uint32_t scratchBytes);
+void dmaCopyThresholdSet(uint32_t bytes);
+uint32_t dmaCopyThresholdGet(void);
+
+void dmaCopyStart(dmaCopy_TypeDef *copy, void *dst, const void *src, uint32_t bytes,
+                  dmaCopyCb_TypeDef cbFunc, void *user);
+void dmaFillStart(dmaCopy_TypeDef *copy, void *dst, uint8_t value, uint32_t bytes,
+                  dmaCopyCb_TypeDef cbFunc, void *user);
+bool dmaCopyDone(const dmaCopy_TypeDef *copy);
+void dmaCopyWait(const dmaCopy_TypeDef *copy);
+
+#endif /* DMA_COPY_H */
@@ -25,12 +25,20 @@
 #include "em_rtc.h"
 #include "em_dma.h"
 #include "em_timer.h"
+#include "em_assert.h"
 
 #include "display.h"
 #include "textdisplay.h"
 #include "retargettextdisplay.h"
 #include "em4config.h"
 
+#include "dma_stream.h"
+#include "dma_sg.h"
+#include "dma_dispatch.h"
+#include "dma_channel.h"
+#include "isr_stats.h"
+#include "timer_config.h"
+
 static DISPLAY_Device_t displayDevice;    /* Display device handle.         */
 
 /* LED driver */
@@ -42,7 +50,6 @@ static DISPLAY_Device_t displayDevice;    /* Display device handle.         */
 
 /* / ********************************************* */
 /* Defines*/
-#define DMA_CHANNEL_FLASH    0
 
 /* DMA control block, must be aligned to 256. */
 #if defined (__ICCARM__)
@@ -56,9 +63,6 @@ DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((align
 #error Undefined toolkit, need to define alignment
 #endif
 
-/* DMA channel to use */
-#define DMA_CHANNEL_FLASH    0
-
 /* Status of the transfer */
 bool flashTransferActive;
 
@@ -71,6 +75,46 @@ const char flashData[8] = "TESTING";
 /* Buffer to transfer to - initialize with zeros */
 char ramBuffer[9] = { 0 };
 
+/* LED pattern stream: one GPIO toggle mask per TIMER0 overflow */
+#define STREAM_COUNT         32
+#define STREAM_RATE_HZ       1000
+#define STATS_INTERVAL       64      /* buffers between printed statistics */
+#define STREAM_PERIOD        TIMER_CONFIG_HZ(STREAM_RATE_HZ)
+
+TIMER_CONFIG_ASSERT(STREAM_PERIOD, 100);
+
+#define LED_PORT             gpioPortF
+#define LED0_PIN             4
+#define LED1_PIN             5
+
+/* Push button 0 prints the handler run times */
+#define PB0_PORT             gpioPortC
+#define PB0_PIN              9
+
+/* Free running clock of the handler run times */
+#define STATS_TIMER          TIMER1
+
+/* Scatter-gather: prefix and flash string gathered into one buffer by a
+ * descriptor chain that is built by the compiler and stays in flash */
+static const char gatherPrefix[4] = { 'S', 'G', ':', ' ' };
+static struct
+{
+  char prefix[4];
+  char text[FLASHDATA_SIZE];
+} gatherBuffer;
+static const DMA_DESCRIPTOR_TypeDef gatherChain[] =
+{
+  DMA_SG_MEM_COPY(gatherBuffer.prefix, gatherPrefix),
+  DMA_SG_MEM_COPY_LAST(gatherBuffer.text, flashData),
+};
+static volatile bool gatherActive;
+
+static uint32_t streamBuffer[2][STREAM_COUNT];
+static dmaStream_TypeDef ledStream;
+static uint32_t streamPhase;
+
+static volatile bool statsRequested;
+
 /**************************************************************************//**
  * @brief RTC Handler
  * Interrupt Service Routine for Real Time Counter
@@ -93,21 +137,21 @@ void flashTransferComplete(unsigned int channel, bool primary, void *user)
  *****************************************************************************/
 void performFlashTransfer(void)
 {
-  /* Setting call-back function */
-  DMA_CB_TypeDef cb[DMA_CHAN_COUNT];
-  cb[DMA_CHANNEL_FLASH].cbFunc = flashTransferComplete;
-
-  /* usrPtr can be used to send data to the callback function,
+  /* Setting up channel, the channel manager keeps the call-back.
+   * userPtr can be used to send data to the callback function,
    * but this is not used here, which is indicated by the NULL pointer */
-  cb[DMA_CHANNEL_FLASH].userPtr = NULL;
-
-  /* Setting up channel */
-  DMA_CfgChannel_TypeDef chnlCfg;
+  dmaChannelCfg_TypeDef chnlCfg;
   chnlCfg.highPri   = false;
   chnlCfg.enableInt = true;
   chnlCfg.select    = 0;
-  chnlCfg.cb        = &(cb[DMA_CHANNEL_FLASH]);
-  DMA_CfgChannel(DMA_CHANNEL_FLASH, &chnlCfg);
+  chnlCfg.cbFunc    = flashTransferComplete;
+  chnlCfg.userPtr   = NULL;
+  chnlCfg.owner     = "flash";
+  int channel = dmaChannelAlloc(&chnlCfg);
+  if (channel == DMA_CHANNEL_NONE)
+  {
+    return;
+  }
 
   /* Setting up channel descriptor */
   DMA_CfgDescr_TypeDef descrCfg;
@@ -116,48 +160,169 @@ void performFlashTransfer(void)
   descrCfg.size    = dmaDataSize1;
   descrCfg.arbRate = dmaArbitrate1;
   descrCfg.hprot   = 0;
-  DMA_CfgDescr(DMA_CHANNEL_FLASH, true, &descrCfg);
+  DMA_CfgDescr(channel, true, &descrCfg);
 
   /* Setting flag to indicate that transfer is in progress
    * will be cleared by call-back function */
   flashTransferActive = true;
 
-  DMA_ActivateBasic(DMA_CHANNEL_FLASH,
-                    true,
-                    false,
-                    (void *) &ramBuffer,
-                    (void *) &flashData,
-                    FLASHDATA_SIZE - 1);
+  /* One software request moves the whole string, no timer needed */
+  DMA_ActivateAuto(channel,
+                   true,
+                   (void *) &ramBuffer,
+                   (void *) &flashData,
+                   FLASHDATA_SIZE - 1);
 
   /* Entering EM1 to wait for completion (the DMA requires EM1) */
   while (flashTransferActive)
   {
     EMU_EnterEM1();
   }
+  dmaChannelRelease(channel);
+}
+
+/**************************************************************************//**
+ * @brief Gather transfer complete callback
+ *****************************************************************************/
+void gatherTransferComplete(unsigned int channel, bool primary, void *user)
+{
+  gatherActive = false;
 }
 
-void TIMER0_IRQHandler(void)
+/**************************************************************************//**
+ * @brief Gather transfer function
+ * The chain needs no descriptor setup, only the channel is configured
+ *****************************************************************************/
+void performGatherTransfer(void)
 {
-  /* Clear flag for TIMER0 overflow interrupt */
-  TIMER_IntClear(TIMER0, TIMER_IF_OF);
+  dmaChannelCfg_TypeDef chnlCfg;
+  int channel;
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = 0;
+  chnlCfg.cbFunc    = gatherTransferComplete;
+  chnlCfg.userPtr   = NULL;
+  chnlCfg.owner     = "gather";
+  channel = dmaChannelAlloc(&chnlCfg);
+  if (channel == DMA_CHANNEL_NONE)
+  {
+    return;
+  }
+
+  gatherActive = true;
+  DMA_SG_ACTIVATE(channel, gatherChain);
 
-  /* If the total transfer has not finished, send a request for another
-   * transfer */
-  if (flashTransferActive)
+  while (gatherActive)
   {
-    /* Manual software request to DMA channel 0 */
-    DMA->CHSWREQ = DMA_CHSWREQ_CH0SWREQ;
+    EMU_EnterEM1();
+  }
+  dmaChannelRelease(channel);
+
+  printf("\n%s", gatherBuffer.prefix);
+}
+
+/**************************************************************************//**
+ * @brief Fill function for the LED stream
+ * LED0 toggles on every element, LED1 every 256 elements
+ *****************************************************************************/
+void fillLedPattern(void *buffer, unsigned int count, void *user)
+{
+  uint32_t *mask = buffer;
+  unsigned int i;
 
-    /* Output the buffer */
-    printf("%s",ramBuffer);
+  for (i = 0; i < count; i++)
+  {
+    mask[i] = 1 << LED0_PIN;
+    if ((streamPhase++ & 0xFF) == 0)
+    {
+      mask[i] |= 1 << LED1_PIN;
+    }
   }
-  else
+}
+
+/**************************************************************************//**
+ * @brief Start streaming the LED pattern
+ * TIMER0 overflow requests the DMA directly, the CPU only wakes up once per
+ * buffer of STREAM_COUNT elements to refill it.
+ *****************************************************************************/
+void startLedStream(void)
+{
+  dmaStreamInit_TypeDef streamInit =
+  {
+    .select  = DMAREQ_TIMER0_UFOF,
+    .dst     = &GPIO->P[LED_PORT].DOUTTGL,
+    .size    = dmaDataSize4,
+    .buffer  = { streamBuffer[0], streamBuffer[1] },
+    .count   = STREAM_COUNT,
+    .fill    = fillLedPattern,
+    .user    = NULL,
+  };
+
+  GPIO_PinModeSet(LED_PORT, LED0_PIN, gpioModePushPull, 0);
+  GPIO_PinModeSet(LED_PORT, LED1_PIN, gpioModePushPull, 0);
+
+  if (!dmaStreamStart(&ledStream, &streamInit))
   {
-    /* The transfer has completed, no more need for the interrupt */
-    TIMER_IntDisable(TIMER0, TIMER_IEN_OF);
+    printf("\nNo DMA channel");
   }
 }
 
+/**************************************************************************//**
+ * @brief Push button 0, the main loop prints the handler run times
+ *****************************************************************************/
+void GPIO_ODD_IRQHandler(void)
+{
+  GPIO_IntClear(1 << PB0_PIN);
+  statsRequested = true;
+}
+
+/**************************************************************************//**
+ * @brief Handler run time clock, STATS_TIMER counting HFPERCLK
+ *****************************************************************************/
+static uint32_t statsClock(void)
+{
+  return TIMER_CounterGet(STATS_TIMER);
+}
+
+/**************************************************************************//**
+ * @brief Start the handler run time clock and the dump button
+ * A 16 bit counter at HFPERCLK, DMA_IRQHandler stays well below a wrap.
+ *****************************************************************************/
+static void startIsrStats(void)
+{
+  const TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = true,
+    .debugRun   = false,
+    .prescale   = timerPrescale1,
+    .clkSel     = timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = false,
+  };
+
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+  TIMER_TopSet(STATS_TIMER, 0xFFFF);
+  TIMER_Init(STATS_TIMER, &timerInit);
+
+  const isrStatsInit_TypeDef statsInit =
+  {
+    .clock     = statsClock,
+    .clockMask = 0xFFFF,
+    .clockHz   = CMU_ClockFreqGet(cmuClock_TIMER1),
+  };
+  isrStatsInit(&statsInit);
+
+  GPIO_PinModeSet(PB0_PORT, PB0_PIN, gpioModeInput, 1);
+  GPIO_IntConfig(PB0_PORT, PB0_PIN, false, true, true);
+  NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+  NVIC_EnableIRQ(GPIO_ODD_IRQn);
+}
 
 /**************************************************************************//**
  * @brief  Main function
@@ -182,34 +347,27 @@ int main(void)
 	  while ( 1 ) ;
   }
 
-  /* Enable the DMA and TIMER0 clocks */
+  /* Enable the DMA, TIMER0 and GPIO clocks */
   CMU_ClockEnable(cmuClock_DMA, true);
   CMU_ClockEnable(cmuClock_TIMER0, true);
-
-  /* Enable overflow interrupt */
-  TIMER_IntEnable(TIMER0, TIMER_IF_OF);
-
-  /* Enable TIMER0 interrupt vector in NVIC */
-  NVIC_EnableIRQ(TIMER0_IRQn);
-
-  /* Initialize TIMER0 */
-  TIMER_Init_TypeDef timerInit =
-  {
-    .enable     = true,
-    .debugRun   = true,
-    .prescale   = timerPrescale64,
-    .clkSel     = timerClkSelHFPerClk,
-    .fallAction = timerInputActionNone,
-    .riseAction = timerInputActionNone,
-    .mode       = timerModeUp,
-    .dmaClrAct  = false,
-    .quadModeX4 = false,
-    .oneShot    = false,
-    .sync       = false,
-  };
+  CMU_ClockEnable(cmuClock_GPIO, true);
+
+  /* Initialize TIMER0, its overflow is the DMA request of the LED stream.
+   * The request is cleared when the DMA serves it, so no interrupt is used.
+   * Prescaler and TOP are constants, the clock must match. */
+  EFM_ASSERT(CMU_ClockFreqGet(cmuClock_TIMER0) == TIMER_CONFIG_CLOCK_HZ);
+  TIMER_Init_TypeDef timerInit = TIMER_CONFIG_INIT(STREAM_PERIOD);
+  timerInit.enable    = false;
+  timerInit.debugRun  = true;
+  timerInit.dmaClrAct = true;
   TIMER_Init(TIMER0, &timerInit);
+  TIMER_TopSet(TIMER0, TIMER_CONFIG_TOP(STREAM_PERIOD));
+
+  /* Time the DMA interrupt */
+  startIsrStats();
 
-  /* Initialize DMA */
+  /* Initialize DMA, its interrupt goes through the dispatch table */
+  dmaDispatchInit();
   DMA_Init_TypeDef dmaInit;
   dmaInit.hprot        = 0;
   dmaInit.controlBlock = dmaControlBlock;
@@ -217,11 +375,40 @@ int main(void)
 
   /* Configure the DMA and perform the transfer */
   performFlashTransfer();
+  performGatherTransfer();
 
+  /* Stream the LED pattern, paced by TIMER0 */
+  startLedStream();
+  TIMER_Enable(TIMER0, true);
+
+  uint32_t reported = 0;
   while (1)
   {
-    /* The transfer has finished. We wish to display the result on the LCD
-     * but use as little power as possible; go to EM2 (the LCD requires EM2). */
-    EMU_EnterEM2(true);
+    /* The DMA needs EM1, the CPU is woken once per buffer */
+    EMU_EnterEM1();
+
+    if (ledStream.interrupts - reported >= STATS_INTERVAL)
+    {
+      uint32_t perKb = dmaStreamIrqPerKb100(&ledStream);
+      const dmaDispatchStats_TypeDef *dispatch = dmaDispatchStatsGet(ledStream.channel);
+
+      reported = ledStream.interrupts;
+      printf("\n%lu IRQ %lu B\n%lu.%02lu IRQ/KB\n%lu underruns",
+             (unsigned long) ledStream.interrupts,
+             (unsigned long) ledStream.bytes,
+             (unsigned long) (perKb / 100),
+             (unsigned long) (perKb % 100),
+             (unsigned long) ledStream.underruns);
+      printf("\nlat %lu max %lu cyc",
+             (unsigned long) (dispatch->latencyTotal / dispatch->dispatches),
+             (unsigned long) dispatch->latencyMax);
+    }
+
+    if (statsRequested)
+    {
+      statsRequested = false;
+      isrStatsDump();
+      isrStatsReset();
+    }
   }
 }
@@ -0,0 +1,45 @@
+/**************************************************************************//**
+ * @file dma_channel.h
+ * @brief Static DMA channel manager
+ *
+ * Owns the DMA_CB_TypeDef of every channel, so callback storage lives as
+ * long as the channel is configured, and hands channels out to the
+ * subsystems sharing the DMA controller. High priority users get the
+ * lowest free channel (served first within the high priority group),
+ * default users the highest free one. Released channels are disabled and
+ * can be allocated again.
+ *****************************************************************************/
+#ifndef DMA_CHANNEL_H
+#define DMA_CHANNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_dma.h"
+
+#define DMA_CHANNEL_NONE    (-1)
+
+typedef struct
+{
+  bool                highPri;    /* High priority class */
+  bool                enableInt;  /* Call cbFunc on completion */
+  uint32_t            select;     /* DMAREQ_xxx, 0 for software requests */
+  DMA_FuncPtr_TypeDef cbFunc;
+  void                *userPtr;
+  const char          *owner;     /* Name shown in the usage report */
+} dmaChannelCfg_TypeDef;
+
+typedef struct
+{
+  const char *owner;              /* NULL when free */
+  bool       highPri;
+  uint32_t   allocations;         /* Times the channel was handed out */
+} dmaChannelUsage_TypeDef;
+
+int dmaChannelAlloc(const dmaChannelCfg_TypeDef *cfg);
+void dmaChannelRelease(unsigned int channel);
+void dmaChannelUserSet(unsigned int channel, void *userPtr);
+uint32_t dmaChannelInUse(void);
+const dmaChannelUsage_TypeDef *dmaChannelUsageGet(unsigned int channel);
+
+#endif /* DMA_CHANNEL_H */
@@ -0,0 +1,135 @@
+/**************************************************************************//**
+ * @file dma_dispatch.c
+ * @brief DMA interrupt handler visiting only the pending channels
+ *
+ * The Cortex-M0+ has no CLZ instruction, so the lowest pending channel is
+ * found with a de Bruijn multiply and a 32 entry table: a fixed handful of
+ * cycles per pending channel instead of a shift per channel. Lowest channel
+ * first keeps the emlib order within the high and default priority groups.
+ *
+ * Latency is measured in core clock cycles with the cycle counter.
+ *****************************************************************************/
+#include "em_assert.h"
+#include "cycle_counter.h"
+#include "isr_stats.h"
+#include "dma_dispatch.h"
+
+/* Bit position for ((bit * 0x077CB531) >> 27) of a single set bit */
+static const uint8_t debruijnPosition[32] =
+{
+  0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+  31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+
+static DMA_CB_TypeDef *callbacks[DMA_CHAN_COUNT];
+static dmaDispatchStats_TypeDef stats[DMA_CHAN_COUNT];
+static isrStats_TypeDef dmaStats = ISR_STATS_INIT("DMA");
+
+/**************************************************************************//**
+ * @brief Start the cycle counter and clear the callback table
+ *****************************************************************************/
+void dmaDispatchInit(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < DMA_CHAN_COUNT; i++)
+  {
+    callbacks[i] = NULL;
+    stats[i].dispatches   = 0;
+    stats[i].latencyLast  = 0;
+    stats[i].latencyMax   = 0;
+    stats[i].latencyTotal = 0;
+  }
+
+  cycleCounterStart();
+}
+
+/**************************************************************************//**
+ * @brief DMA_CfgChannel() that also enters the callback in the table
+ *****************************************************************************/
+void dmaDispatchCfgChannel(unsigned int channel, DMA_CfgChannel_TypeDef *cfg)
+{
+  EFM_ASSERT(channel < DMA_CHAN_COUNT);
+
+  DMA_CfgChannel(channel, cfg);
+  callbacks[channel] = cfg->cb;
+}
+
+const dmaDispatchStats_TypeDef *dmaDispatchStatsGet(unsigned int channel)
+{
+  EFM_ASSERT(channel < DMA_CHAN_COUNT);
+
+  return &stats[channel];
+}
+
+/**************************************************************************//**
+ * @brief Call the callbacks of one priority group, lowest channel first
+ *****************************************************************************/
+static void dispatchGroup(uint32_t pending, uint32_t entry)
+{
+  uint32_t bit;
+  uint32_t latency;
+  unsigned int channel;
+  bool primary;
+  DMA_CB_TypeDef *cb;
+  dmaDispatchStats_TypeDef *s;
+
+  while (pending)
+  {
+    bit      = pending & (0 - pending);
+    pending ^= bit;
+    channel  = debruijnPosition[(bit * 0x077CB531UL) >> 27];
+
+    /* Clear before the callback, it may start another cycle */
+    DMA->IFC = bit;
+
+    cb = callbacks[channel];
+    if (cb)
+    {
+      /* Toggle the next descriptor indicator first, as emlib does */
+      primary      = cb->primary;
+      cb->primary ^= 1;
+
+      latency = (cycleCounterGet() - entry) & CYCLE_COUNTER_MASK;
+      s = &stats[channel];
+      s->dispatches++;
+      s->latencyLast   = latency;
+      s->latencyTotal += latency;
+      if (latency > s->latencyMax)
+      {
+        s->latencyMax = latency;
+      }
+
+      if (cb->cbFunc)
+      {
+        cb->cbFunc(channel, primary, cb->userPtr);
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief DMA interrupt handler
+ * High priority channels first, then the default priority ones
+ *****************************************************************************/
+void DMA_IRQHandler(void)
+{
+  uint32_t entry = cycleCounterGet();
+  uint32_t pending;
+  uint32_t prio;
+
+  isrStatsEnter();
+
+  pending  = DMA->IF;
+  pending &= DMA->IEN;
+
+  /* Assert on bus error. */
+  EFM_ASSERT(!(pending & DMA_IF_ERR));
+
+  pending &= (1UL << DMA_CHAN_COUNT) - 1;
+  prio     = DMA->CHPRIS;
+
+  dispatchGroup(pending & prio, entry);
+  dispatchGroup(pending & ~prio, entry);
+  isrStatsExit(&dmaStats);
+}
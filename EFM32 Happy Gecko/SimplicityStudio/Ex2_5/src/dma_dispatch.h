@@ -0,0 +1,31 @@
+/**************************************************************************//**
+ * @file dma_dispatch.h
+ * @brief DMA interrupt handler visiting only the pending channels
+ *
+ * Replaces the emlib DMA_IRQHandler (build with
+ * EXCLUDE_DEFAULT_DMA_IRQ_HANDLER). Callbacks are kept in a table in RAM
+ * indexed by channel, filled by dmaDispatchCfgChannel(), so the handler does
+ * not read CTRLBASE and the descriptor USER word for every channel. Each
+ * dispatch records the cycles from handler entry to the callback.
+ *****************************************************************************/
+#ifndef DMA_DISPATCH_H
+#define DMA_DISPATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_dma.h"
+
+typedef struct
+{
+  uint32_t dispatches;     /* Callbacks called for the channel */
+  uint32_t latencyLast;    /* Cycles from DMA_IRQHandler entry to callback */
+  uint32_t latencyMax;
+  uint32_t latencyTotal;
+} dmaDispatchStats_TypeDef;
+
+void dmaDispatchInit(void);
+void dmaDispatchCfgChannel(unsigned int channel, DMA_CfgChannel_TypeDef *cfg);
+const dmaDispatchStats_TypeDef *dmaDispatchStatsGet(unsigned int channel);
+
+#endif /* DMA_DISPATCH_H */
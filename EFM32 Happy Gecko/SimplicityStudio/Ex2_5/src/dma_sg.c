@@ -0,0 +1,82 @@
+/**************************************************************************//**
+ * @file dma_sg.c
+ * @brief Scatter-gather descriptor chains built at compile time
+ *
+ * Same as DMA_ActivateScatterGather(), except that the chain is only read:
+ * the DMA_SG_xxx_LAST macros already gave the last step the cycle type that
+ * ends the chain, so the table can stay in flash.
+ *****************************************************************************/
+#include "em_assert.h"
+#include "dma_sg.h"
+
+/**************************************************************************//**
+ * @brief Start a scatter-gather chain
+ * The channel must have been allocated with dmaChannelAlloc().
+ * Memory chains start right away, peripheral chains on the channel's
+ * requests.
+ *****************************************************************************/
+void dmaSgActivate(unsigned int channel,
+                   bool useBurst,
+                   const DMA_DESCRIPTOR_TypeDef *chain,
+                   unsigned int count)
+{
+  DMA_DESCRIPTOR_TypeDef *descr;
+  DMA_CB_TypeDef *cb;
+  uint32_t cycleCtrl;
+  uint32_t lastCtrl;
+  uint32_t chBit;
+
+  EFM_ASSERT(channel < DMA_CHAN_COUNT);
+  EFM_ASSERT(chain);
+  EFM_ASSERT(count && (count <= 256));
+
+  /* Memory or peripheral chain, from the first step */
+  cycleCtrl  = chain->CTRL & _DMA_CTRL_CYCLE_CTRL_MASK;
+  cycleCtrl &= ~(1 << _DMA_CTRL_CYCLE_CTRL_SHIFT);
+  EFM_ASSERT((cycleCtrl == dmaCycleCtrlMemScatterGather)
+             || (cycleCtrl == dmaCycleCtrlPerScatterGather)
+             || (count == 1));
+
+  /* A single step chain only has its last step to go by */
+  lastCtrl = (chain[count - 1].CTRL & _DMA_CTRL_CYCLE_CTRL_MASK)
+             >> _DMA_CTRL_CYCLE_CTRL_SHIFT;
+  if (count == 1)
+  {
+    cycleCtrl = (lastCtrl == dmaCycleCtrlAuto) ? dmaCycleCtrlMemScatterGather
+                                                : dmaCycleCtrlPerScatterGather;
+  }
+  EFM_ASSERT(lastCtrl == ((cycleCtrl == dmaCycleCtrlMemScatterGather)
+                          ? dmaCycleCtrlAuto : dmaCycleCtrlBasic));
+
+  /* The primary descriptor copies one step at a time into the alternate one */
+  descr = (DMA_DESCRIPTOR_TypeDef *)(DMA->CTRLBASE) + channel;
+  descr->SRCEND = (uint32_t *)chain + (count * 4) - 1;
+  descr->DSTEND = (uint32_t *)((DMA_DESCRIPTOR_TypeDef *)(DMA->ALTCTRLBASE)
+                               + channel + 1) - 1;
+
+  /* The callback is issued for the alternate descriptor, which ends the chain */
+  cb = (DMA_CB_TypeDef *)(descr->USER);
+  if (cb)
+  {
+    cb->primary = false;
+  }
+
+  descr->CTRL = ((uint32_t)dmaDataInc4 << _DMA_CTRL_DST_INC_SHIFT)
+                | ((uint32_t)dmaDataSize4 << _DMA_CTRL_DST_SIZE_SHIFT)
+                | ((uint32_t)dmaDataInc4 << _DMA_CTRL_SRC_INC_SHIFT)
+                | ((uint32_t)dmaDataSize4 << _DMA_CTRL_SRC_SIZE_SHIFT)
+                | ((uint32_t)dmaArbitrate4 << _DMA_CTRL_R_POWER_SHIFT)
+                | (((count * 4) - 1) << _DMA_CTRL_N_MINUS_1_SHIFT)
+                | (((uint32_t)useBurst & 1) << _DMA_CTRL_NEXT_USEBURST_SHIFT)
+                | (cycleCtrl << _DMA_CTRL_CYCLE_CTRL_SHIFT);
+
+  chBit = 1 << channel;
+  DMA->CHALTC = chBit;
+  DMA->CHENS  = chBit;
+
+  /* Peripheral chains wait for the peripheral's request */
+  if (cycleCtrl == dmaCycleCtrlMemScatterGather)
+  {
+    DMA->CHSWREQ = chBit;
+  }
+}
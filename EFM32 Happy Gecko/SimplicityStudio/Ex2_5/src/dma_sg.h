@@ -0,0 +1,144 @@
+/**************************************************************************//**
+ * @file dma_sg.h
+ * @brief Scatter-gather descriptor chains built at compile time
+ *
+ * DMA_CfgDescrScatterGather() fills alternate descriptors one by one at run
+ * time and DMA_ActivateScatterGather() patches the last one. The macros below
+ * build the same descriptors as constant initializers instead, so a chain can
+ * be a const table in flash, and dmaSgActivate() starts it with a handful of
+ * register writes:
+ *
+ *   static const DMA_DESCRIPTOR_TypeDef chain[] =
+ *   {
+ *     DMA_SG_MEM_COPY(frame.header, header),
+ *     DMA_SG_MEM_COPY_LAST(frame.payload, payload),
+ *   };
+ *   DMA_SG_ACTIVATE(channel, chain);
+ *
+ * Memory operands are arrays, the whole array is moved. Peripheral operands
+ * are register pointers like &USART1->TXDATA. A chain holds either memory
+ * steps (started by software, runs to the end) or peripheral steps (each
+ * element waits for the channel's request), and ends with a _LAST step.
+ *
+ * Mismatched element sizes, misaligned element types, steps longer than 1024
+ * elements or a register narrower than the elements fail to compile.
+ *****************************************************************************/
+#ifndef DMA_SG_H
+#define DMA_SG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_dma.h"
+
+/* Elements moved per arbitration in memory steps */
+#ifndef DMA_SG_MEM_ARBRATE
+#define DMA_SG_MEM_ARBRATE    dmaArbitrate8
+#endif
+
+/* Evaluates to 0, or stops the compile with msg */
+#define DMA_SG_CHECK(cond, msg) \
+  (0 * sizeof(struct { _Static_assert(cond, msg); int dmaSgCheck; }))
+
+#define DMA_SG_IS_ARRAY(a) \
+  (!__builtin_types_compatible_p(__typeof__(a), __typeof__(&(a)[0])))
+
+#define DMA_SG_LEN(a)         (sizeof(a) / sizeof((a)[0]))
+
+/* Size and increment field value for an element of 'bytes' */
+#define DMA_SG_SIZE(bytes)    ((bytes) == 1 ? 0U : ((bytes) == 2 ? 1U : 2U))
+
+#define DMA_SG_CHECK_ARRAY(a)                                                \
+  (DMA_SG_CHECK(DMA_SG_IS_ARRAY(a), "DMA_SG: memory operand must be an array") \
+   + DMA_SG_CHECK(sizeof((a)[0]) == 1 || sizeof((a)[0]) == 2                 \
+                  || sizeof((a)[0]) == 4, "DMA_SG: element must be 1, 2 or 4 bytes") \
+   + DMA_SG_CHECK(__alignof__(a) >= sizeof((a)[0]),                          \
+                  "DMA_SG: array not aligned to its element size")           \
+   + DMA_SG_CHECK(DMA_SG_LEN(a) >= 1 && DMA_SG_LEN(a) <= 1024,               \
+                  "DMA_SG: step must move 1 to 1024 elements"))
+
+#define DMA_SG_CTRL(dstInc, srcInc, bytes, n, arbRate, cycle)                \
+  (((uint32_t)(dstInc) << _DMA_CTRL_DST_INC_SHIFT)                          \
+   | ((uint32_t)DMA_SG_SIZE(bytes) << _DMA_CTRL_DST_SIZE_SHIFT)             \
+   | ((uint32_t)(srcInc) << _DMA_CTRL_SRC_INC_SHIFT)                        \
+   | ((uint32_t)DMA_SG_SIZE(bytes) << _DMA_CTRL_SRC_SIZE_SHIFT)             \
+   | ((uint32_t)(arbRate) << _DMA_CTRL_R_POWER_SHIFT)                       \
+   | ((uint32_t)((n) - 1) << _DMA_CTRL_N_MINUS_1_SHIFT)                     \
+   | ((uint32_t)(cycle) << _DMA_CTRL_CYCLE_CTRL_SHIFT))
+
+/* Address of the last element, the descriptor holds end pointers */
+#define DMA_SG_END(a)         ((void *)((a) + (DMA_SG_LEN(a) - 1)))
+
+/* Array to array of the same element size */
+#define DMA_SG_MEM_STEP(dst, src, cycle)                                     \
+  {                                                                          \
+    .SRCEND = DMA_SG_END(src),                                               \
+    .DSTEND = DMA_SG_END(dst),                                               \
+    .CTRL   = DMA_SG_CTRL(DMA_SG_SIZE(sizeof((dst)[0])),                     \
+                          DMA_SG_SIZE(sizeof((src)[0])),                     \
+                          sizeof((src)[0]), DMA_SG_LEN(src),                 \
+                          DMA_SG_MEM_ARBRATE, cycle)                         \
+              + DMA_SG_CHECK_ARRAY(dst) + DMA_SG_CHECK_ARRAY(src)            \
+              + DMA_SG_CHECK(sizeof((dst)[0]) == sizeof((src)[0]),           \
+                             "DMA_SG: element sizes differ")                 \
+              + DMA_SG_CHECK(sizeof(dst) >= sizeof(src),                     \
+                             "DMA_SG: destination smaller than source"),     \
+    .USER   = 0,                                                             \
+  }
+
+/* Array to a register, one element per request */
+#define DMA_SG_WRITE_STEP(reg, src, cycle)                                   \
+  {                                                                          \
+    .SRCEND = DMA_SG_END(src),                                               \
+    .DSTEND = (void *)(reg),                                                 \
+    .CTRL   = DMA_SG_CTRL(dmaDataIncNone, DMA_SG_SIZE(sizeof((src)[0])),     \
+                          sizeof((src)[0]), DMA_SG_LEN(src),                 \
+                          dmaArbitrate1, cycle)                              \
+              + DMA_SG_CHECK_ARRAY(src)                                      \
+              + DMA_SG_CHECK(sizeof(*(reg)) >= sizeof((src)[0]),             \
+                             "DMA_SG: register narrower than the elements"), \
+    .USER   = 0,                                                             \
+  }
+
+/* Register to an array, one element per request */
+#define DMA_SG_READ_STEP(dst, reg, cycle)                                    \
+  {                                                                          \
+    .SRCEND = (void *)(reg),                                                 \
+    .DSTEND = DMA_SG_END(dst),                                               \
+    .CTRL   = DMA_SG_CTRL(DMA_SG_SIZE(sizeof((dst)[0])), dmaDataIncNone,     \
+                          sizeof((dst)[0]), DMA_SG_LEN(dst),                 \
+                          dmaArbitrate1, cycle)                              \
+              + DMA_SG_CHECK_ARRAY(dst)                                      \
+              + DMA_SG_CHECK(sizeof(*(reg)) >= sizeof((dst)[0]),             \
+                             "DMA_SG: register narrower than the elements"), \
+    .USER   = 0,                                                             \
+  }
+
+/* Alternate descriptor cycle types, the last step ends the chain with a
+ * cycle that raises dma_done */
+#define DMA_SG_CYCLE_MEM      (dmaCycleCtrlMemScatterGather + 1)
+#define DMA_SG_CYCLE_PER      (dmaCycleCtrlPerScatterGather + 1)
+
+#define DMA_SG_MEM_COPY(dst, src)       DMA_SG_MEM_STEP(dst, src, DMA_SG_CYCLE_MEM)
+#define DMA_SG_MEM_COPY_LAST(dst, src)  DMA_SG_MEM_STEP(dst, src, dmaCycleCtrlAuto)
+
+#define DMA_SG_PER_COPY(dst, src)       DMA_SG_MEM_STEP(dst, src, DMA_SG_CYCLE_PER)
+#define DMA_SG_PER_COPY_LAST(dst, src)  DMA_SG_MEM_STEP(dst, src, dmaCycleCtrlBasic)
+#define DMA_SG_PER_WRITE(reg, src)      DMA_SG_WRITE_STEP(reg, src, DMA_SG_CYCLE_PER)
+#define DMA_SG_PER_WRITE_LAST(reg, src) DMA_SG_WRITE_STEP(reg, src, dmaCycleCtrlBasic)
+#define DMA_SG_PER_READ(dst, reg)       DMA_SG_READ_STEP(dst, reg, DMA_SG_CYCLE_PER)
+#define DMA_SG_PER_READ_LAST(dst, reg)  DMA_SG_READ_STEP(dst, reg, dmaCycleCtrlBasic)
+
+/* Start a chain table, its length is checked at compile time */
+#define DMA_SG_ACTIVATE(channel, chain)                                      \
+  dmaSgActivate((channel), false, (chain),                                   \
+                DMA_SG_LEN(chain)                                            \
+                + DMA_SG_CHECK(DMA_SG_LEN(chain) <= 256,                     \
+                               "DMA_SG: at most 256 steps per chain"))
+
+void dmaSgActivate(unsigned int channel,
+                   bool useBurst,
+                   const DMA_DESCRIPTOR_TypeDef *chain,
+                   unsigned int count);
+
+#endif /* DMA_SG_H */
@@ -0,0 +1,161 @@
+/**************************************************************************//**
+ * @file dma_stream.c
+ * @brief Continuous DMA streaming to a peripheral with ping-pong buffers
+ *
+ * Both buffers are filled before the ping-pong cycle starts. Each completion
+ * callback refills the buffer that just finished and refreshes its
+ * descriptor, the controller has switched to the other one by then. Stopping
+ * turns the next refreshed buffer into a basic cycle, after which the
+ * channel disables itself and goes back to the channel manager.
+ *
+ * A callback late by a whole buffer finds both done, their completions
+ * merged into one interrupt, and the channel disabled. Without a stop that
+ * is an underrun: it is counted and the stream starts over from two fresh
+ * buffers. Bytes are counted per buffer handed over, so none are missed.
+ *****************************************************************************/
+#include "em_assert.h"
+#include "dma_stream.h"
+#include "dma_channel.h"
+
+/**************************************************************************//**
+ * @brief Fill both buffers and start the ping-pong cycle on them
+ *****************************************************************************/
+static void dmaStreamActivate(dmaStream_TypeDef *stream)
+{
+  dmaStreamInit_TypeDef *init = &stream->init;
+
+  init->fill(init->buffer[0], init->count, init->user);
+  init->fill(init->buffer[1], init->count, init->user);
+  stream->queued = 2;
+
+  DMA_ActivatePingPong(stream->channel,
+                       false,
+                       (void *)init->dst,
+                       init->buffer[0],
+                       init->count - 1,
+                       (void *)init->dst,
+                       init->buffer[1],
+                       init->count - 1);
+}
+
+/**************************************************************************//**
+ * @brief Ping-pong completion callback
+ * Called from DMA_IRQHandler when one of the buffers has been sent
+ *****************************************************************************/
+static void dmaStreamDone(unsigned int channel, bool primary, void *user)
+{
+  dmaStream_TypeDef *stream = user;
+  dmaStreamInit_TypeDef *init = &stream->init;
+
+  stream->interrupts++;
+
+  /* Everything handed over is done: the basic cycle queued by stop, or
+   * both buffers because the refill came too late */
+  if (!DMA_ChannelEnabled(channel))
+  {
+    stream->bytes += (stream->queued * init->count) << init->size;
+    stream->queued = 0;
+    if (!stream->stopping)
+    {
+      stream->underruns++;
+      dmaStreamActivate(stream);
+      return;
+    }
+    dmaChannelRelease(channel);
+    stream->active = false;
+    return;
+  }
+
+  stream->bytes += init->count << init->size;
+  stream->queued--;
+
+  /* The other buffer is the last one, nothing to hand back */
+  if (stream->lastQueued)
+  {
+    return;
+  }
+
+  init->fill(init->buffer[primary ? 0 : 1], init->count, init->user);
+  DMA_RefreshPingPong(channel, primary, false, NULL, NULL,
+                      init->count - 1, stream->stopping);
+
+  /* Too late if the other buffer ran out meanwhile, its interrupt is
+   * pending and restarts the stream */
+  if (DMA_ChannelEnabled(channel))
+  {
+    stream->queued++;
+    stream->lastQueued = stream->stopping;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start streaming
+ * DMA_Init must have been called and the request source must be set up to
+ * clear its request when the DMA serves it (e.g. TIMER dmaClrAct).
+ * Returns false when no DMA channel is free.
+ *****************************************************************************/
+bool dmaStreamStart(dmaStream_TypeDef *stream, const dmaStreamInit_TypeDef *init)
+{
+  dmaChannelCfg_TypeDef chnlCfg;
+  DMA_CfgDescr_TypeDef descrCfg;
+  int channel;
+
+  EFM_ASSERT(init->count > 0 && init->count <= DMA_STREAM_MAX_COUNT);
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = init->select;
+  chnlCfg.cbFunc    = dmaStreamDone;
+  chnlCfg.userPtr   = stream;
+  chnlCfg.owner     = "stream";
+  channel = dmaChannelAlloc(&chnlCfg);
+  if (channel == DMA_CHANNEL_NONE)
+  {
+    return false;
+  }
+
+  stream->init       = *init;
+  stream->channel    = channel;
+  stream->active     = true;
+  stream->stopping   = false;
+  stream->lastQueued = false;
+  stream->interrupts = 0;
+  stream->bytes      = 0;
+  stream->underruns  = 0;
+
+  /* Buffer to register, one element per request */
+  descrCfg.dstInc  = dmaDataIncNone;
+  descrCfg.srcInc  = (DMA_DataInc_TypeDef)init->size;
+  descrCfg.size    = init->size;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(channel, true, &descrCfg);
+  DMA_CfgDescr(channel, false, &descrCfg);
+
+  dmaStreamActivate(stream);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Stop streaming
+ * The buffers already handed to the DMA are still sent, active goes false
+ * when the last one is done and bytes counts them all.
+ *****************************************************************************/
+void dmaStreamStop(dmaStream_TypeDef *stream)
+{
+  stream->stopping = true;
+}
+
+/**************************************************************************//**
+ * @brief DMA interrupts per KB streamed, in hundredths
+ *****************************************************************************/
+uint32_t dmaStreamIrqPerKb100(const dmaStream_TypeDef *stream)
+{
+  uint32_t bytes = stream->bytes;
+
+  if (bytes == 0)
+  {
+    return 0;
+  }
+  return (uint32_t)(((uint64_t)stream->interrupts * 1024 * 100) / bytes);
+}
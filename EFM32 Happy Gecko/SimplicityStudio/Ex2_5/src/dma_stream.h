@@ -0,0 +1,52 @@
+/**************************************************************************//**
+ * @file dma_stream.h
+ * @brief Continuous DMA streaming to a peripheral with ping-pong buffers
+ *
+ * A peripheral or timer DMA request moves one element from the active buffer
+ * to a fixed register. When a buffer is done the DMA interrupt fills it again
+ * and hands it back to the controller while the other buffer is being sent,
+ * so the CPU wakes once per buffer instead of once per element.
+ *****************************************************************************/
+#ifndef DMA_STREAM_H
+#define DMA_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_dma.h"
+
+/* Most elements a descriptor can move in one cycle */
+#define DMA_STREAM_MAX_COUNT    1024
+
+/* Fills the next 'count' elements of the stream into 'buffer' */
+typedef void (*dmaStreamFill_TypeDef)(void *buffer, unsigned int count, void *user);
+
+typedef struct
+{
+  uint32_t              select;     /* DMAREQ_xxx request pacing the stream */
+  volatile void         *dst;       /* Peripheral register written */
+  DMA_DataSize_TypeDef  size;       /* Element size */
+  void                  *buffer[2]; /* Ping-pong buffers */
+  unsigned int          count;      /* Elements per buffer */
+  dmaStreamFill_TypeDef fill;       /* Called for every buffer, also from IRQ */
+  void                  *user;      /* Passed on to fill */
+} dmaStreamInit_TypeDef;
+
+typedef struct
+{
+  dmaStreamInit_TypeDef init;
+  unsigned int          channel;    /* Allocated by dmaStreamStart */
+  volatile bool         active;
+  volatile bool         stopping;
+  bool                  lastQueued;
+  unsigned int          queued;     /* Buffers handed to the DMA, not yet done */
+  volatile uint32_t     interrupts; /* DMA interrupts for this stream */
+  volatile uint32_t     bytes;      /* Bytes moved by completed buffers */
+  volatile uint32_t     underruns;  /* Restarts after both buffers ran out */
+} dmaStream_TypeDef;
+
+bool dmaStreamStart(dmaStream_TypeDef *stream, const dmaStreamInit_TypeDef *init);
+void dmaStreamStop(dmaStream_TypeDef *stream);
+uint32_t dmaStreamIrqPerKb100(const dmaStream_TypeDef *stream);
+
+#endif /* DMA_STREAM_H */
@@ -0,0 +1,56 @@
+/**************************************************************************//**
+ * @file isr_stats.h
+ * @brief Run time of interrupt handlers, min/max/histogram per handler
+ *
+ * A handler calls isrStatsEnter() first and isrStatsExit() with its own
+ * record last; the time in between, less the time of handlers that
+ * preempted it, is its run time. The time comes from a free running
+ * counter of the project's choosing (a TIMER, cycleCounterGet(), or the
+ * simulator's cycle count under HostSim). A handler
+ * that is not instrumented counts for the one it preempted. Records are
+ * listed at their first exit, isrStatsDump() prints them all.
+ *****************************************************************************/
+#ifndef ISR_STATS_H
+#define ISR_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Bin n counts run times of 2^n up to 2^(n+1) - 1 ticks, bin 0 also 0,
+ * the last one everything longer */
+#define ISR_STATS_BINS          24
+
+/* Handlers that can be nested, the four priority levels of the M0+ */
+#define ISR_STATS_DEPTH         4
+
+#define ISR_STATS_INIT(n)       { .name = (n) }
+
+typedef struct isrStats isrStats_TypeDef;
+
+/* Static in the instrumented file, initialized with ISR_STATS_INIT() */
+struct isrStats
+{
+  const char       *name;
+  isrStats_TypeDef *next;       /* Dump list */
+  bool             listed;
+  uint32_t         count;
+  uint32_t         min;         /* Ticks */
+  uint32_t         max;
+  uint64_t         total;
+  uint32_t         bins[ISR_STATS_BINS];
+};
+
+typedef struct
+{
+  uint32_t (*clock)(void);      /* Free running up counter */
+  uint32_t clockMask;           /* Its width, 0xFFFFFFFF for 32 bits */
+  uint32_t clockHz;             /* Its frequency, for the dump */
+} isrStatsInit_TypeDef;
+
+void isrStatsInit(const isrStatsInit_TypeDef *init);
+void isrStatsEnter(void);
+void isrStatsExit(isrStats_TypeDef *stats);
+void isrStatsReset(void);
+void isrStatsDump(void);
+
+#endif /* ISR_STATS_H */
@@ -14,6 +14,8 @@
  * terms of that agreement.
  *
  ******************************************************************************/
+#include <stdio.h>
+
 #include "em_device.h"
 #include "em_acmp.h"
 #include "em_chip.h"
@@ -22,31 +24,149 @@
 #include "em_gpio.h"
 #include "em_prs.h"
 #include "em_timer.h"
+#include "em_dma.h"
 
 #include "display.h"
 #include "textdisplay.h"
 #include "retargettextdisplay.h"
 #include "em4config.h"
 
+#include "capture_dma.h"
+#include "pulse_stats.h"
+#include "freq_counter.h"
+
 static DISPLAY_Device_t displayDevice;    /* Display device handle.         */
 
 /* Defines for Push Button 0 */
 #define PB0_PORT                    gpioPortC
 #define PB0_PIN                     9
 
+/* DMA channel moving the captures */
+#define CAPTURE_DMA_CHANNEL         0
+
+/* TIMER0 prescaler, also used to turn ticks into milliseconds */
+#define CAPTURE_PRESCALE            1024
+
+/* Histogram bin width and summary refreshes per second (TIMER1) */
+#define HISTOGRAM_BIN_MS            100
+#define SUMMARY_HZ                  1
 
+/* PRS channels of the pin and of the frequency counter gate, TIMER1 */
+#define PB0_PRS_CH                  5
+#define GATE_PRS_CH                 6
+
+/* DMA control block, must be aligned to 256. */
+#if defined (__ICCARM__)
+#pragma data_alignment=256
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2];
+#elif defined (__CC_ARM)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#elif defined (__GNUC__)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#else
+#error Undefined toolkit, need to define alignment
+#endif
+
+static pulseStats_TypeDef pulseStats;
+static volatile bool summaryDue;
+static volatile freqCounterResult_TypeDef frequency;
+static volatile bool frequencyValid;
 
 /**************************************************************************//**
- * @brief TIMER0_IRQHandler
- * Interrupt Service Routine TIMER0 Interrupt Line
+ * @brief Frequency counter result, from the TIMER2 interrupt
  *****************************************************************************/
-void TIMER0_IRQHandler(void)
+static void frequencyDone(const freqCounterResult_TypeDef *result)
 {
-  /* Clear flag for TIMER0 CC0 interrupt */
-  TIMER_IntClear(TIMER0, TIMER_IF_CC0);
+  frequency.mode    = result->mode;
+  frequency.milliHz = result->milliHz;
+  frequencyValid    = true;
+}
 
-  /* Write capture value on LCD */
-  printf("%lu\n",TIMER_CaptureGet(TIMER0, 0));
+/**************************************************************************//**
+ * @brief TIMER1_IRQHandler
+ * Paces the summary on the LCD, printing is too slow for every pulse
+ *****************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  TIMER_IntClear(TIMER1, TIMER_IF_OF);
+  summaryDue = true;
+}
+
+/**************************************************************************//**
+ * @brief Timer ticks to milliseconds
+ *****************************************************************************/
+static uint32_t ticksToMs(uint32_t ticks)
+{
+  return (uint32_t)(((uint64_t)ticks * CAPTURE_PRESCALE * 1000)
+                    / CMU_ClockFreqGet(cmuClock_TIMER0));
+}
+
+/**************************************************************************//**
+ * @brief Milliseconds to timer ticks
+ *****************************************************************************/
+static uint32_t msToTicks(uint32_t ms)
+{
+  return (uint32_t)(((uint64_t)ms * CMU_ClockFreqGet(cmuClock_TIMER0))
+                    / (CAPTURE_PRESCALE * 1000));
+}
+
+/**************************************************************************//**
+ * @brief Print the pulse width summary, fits the 16 text lines of the LCD
+ *****************************************************************************/
+void showSummary(void)
+{
+  unsigned int i;
+
+  if (frequencyValid)
+  {
+    printf("\n%lu.%03lu Hz %s", (unsigned long)(frequency.milliHz / 1000),
+           (unsigned long)(frequency.milliHz % 1000),
+           frequency.mode == freqCounterModeCount ? "count" : "period");
+  }
+  printf("\npulses %lu lost %lu", (unsigned long)pulseStats.count,
+         (unsigned long)captureDmaLost());
+  if (pulseStats.count == 0)
+  {
+    return;
+  }
+  printf("\nmin  %lu ms", (unsigned long)ticksToMs(pulseStats.min));
+  printf("\nmax  %lu ms", (unsigned long)ticksToMs(pulseStats.max));
+  printf("\nmean %lu ms", (unsigned long)ticksToMs(pulseStatsMean(&pulseStats)));
+  for (i = 0; i < PULSE_STATS_BINS; i++)
+  {
+    printf("\n%s%4u ms %lu", i == PULSE_STATS_BINS - 1 ? ">=" : "< ",
+           (i + (i < PULSE_STATS_BINS - 1)) * HISTOGRAM_BIN_MS,
+           (unsigned long)pulseStats.bins[i]);
+  }
+}
+
+/**************************************************************************//**
+ * @brief  Summary timer setup
+ * TIMER1 overflows SUMMARY_HZ times a second
+ *****************************************************************************/
+void summaryTimerSetup(void)
+{
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  const TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = true,
+    .debugRun   = false,
+    .prescale   = timerPrescale1024,
+    .clkSel     = timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = false,
+  };
+
+  TIMER_TopSet(TIMER1, CMU_ClockFreqGet(cmuClock_TIMER1) / 1024 / SUMMARY_HZ - 1);
+  TIMER_Init(TIMER1, &timerInit);
+  TIMER_IntEnable(TIMER1, TIMER_IEN_OF);
+  NVIC_EnableIRQ(TIMER1_IRQn);
 }
 
 /**************************************************************************//**
@@ -79,7 +199,7 @@ void TIMER_setup(void)
   {
     .eventCtrl = timerEventRising,        /* Input capture event control */
     .edge      = timerEdgeRising,         /* Input capture on rising edge */
-    .prsSel    = timerPRSSELCh5,          /* Prs channel select channel 5*/
+    .prsSel    = (TIMER_PRSSEL_TypeDef)PB0_PRS_CH, /* Prs channel of the button */
     .cufoa     = timerOutputActionNone,   /* No action on counter underflow */
     .cofoa     = timerOutputActionNone,   /* No action on counter overflow */
     .cmoa      = timerOutputActionNone,   /* No action on counter match */
@@ -103,7 +223,7 @@ void TIMER_setup(void)
     .fallAction = timerInputActionReloadStart,  /* Reload and start on falling edge */
     .riseAction = timerInputActionStop,         /* Stop counter on rising edge */
     .mode       = timerModeUp,                  /* Counting up */
-    .dmaClrAct  = false,                        /* No DMA */
+    .dmaClrAct  = true,                         /* DMA reading CCV clears the request */
     .quadModeX4 = false,                        /* No quad decoding */
     .oneShot    = false,                        /* Counting up constinuously */
     .sync       = false,                        /* No start/stop/reload by other timers */
@@ -114,7 +234,7 @@ void TIMER_setup(void)
 
 
   /* PRS setup */
-  PRS_SourceSignalSet(5, PRS_CH_CTRL_SOURCESEL_GPIOH, PRS_CH_CTRL_SIGSEL_GPIOPIN9, prsEdgeOff);
+  PRS_SourceSignalSet(PB0_PRS_CH, PRS_CH_CTRL_SOURCESEL_GPIOH, PRS_CH_CTRL_SIGSEL_GPIOPIN9, prsEdgeOff);
 
 
 }
@@ -148,16 +268,52 @@ int main(void)
   /* Initialise the TIMER */
   TIMER_setup();
 
-  /* Enable timer interrupt */
-  TIMER_IntEnable(TIMER0, TIMER_IEN_CC0);
+  /* Captures go to RAM by DMA, no interrupt per pulse */
+  CMU_ClockEnable(cmuClock_DMA, true);
+  DMA_Init_TypeDef dmaInit;
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+
+  const captureDmaInit_TypeDef captureInit =
+  {
+    .timer   = TIMER0,
+    .cc      = 0,
+    .select  = DMAREQ_TIMER0_CC0,
+    .channel = CAPTURE_DMA_CHANNEL,
+  };
+  captureDmaStart(&captureInit);
 
-  /* Enable TIMER0 interrupt vector in NVIC */
-  NVIC_EnableIRQ(TIMER0_IRQn);
+  pulseStatsInit(&pulseStats, msToTicks(HISTOGRAM_BIN_MS));
+  summaryTimerSetup();
 
+  /* The summary tick is also the gate of the frequency counter */
+  PRS_SourceSignalSet(GATE_PRS_CH, PRS_CH_CTRL_SOURCESEL_TIMER1,
+                      PRS_CH_CTRL_SIGSEL_TIMER1OF, prsEdgePos);
+  const freqCounterInit_TypeDef freqInit =
+  {
+    .signalPrs = PB0_PRS_CH,
+    .gatePrs   = GATE_PRS_CH,
+    .gateHz    = SUMMARY_HZ,
+    .callback  = frequencyDone,
+  };
+  freqCounterStart(&freqInit);
 
   while (1)
   {
-    /* Enter EM1 while waiting for capture. */
+    uint32_t width;
+
+    /* Enter EM1 while waiting for captures and the summary timer. */
     EMU_EnterEM1();
+
+    while (captureDmaGet(&width))
+    {
+      pulseStatsAdd(&pulseStats, width);
+    }
+    if (summaryDue)
+    {
+      summaryDue = false;
+      showSummary();
+    }
   }
 }
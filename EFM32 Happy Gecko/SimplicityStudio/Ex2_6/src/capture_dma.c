@@ -0,0 +1,114 @@
+/**************************************************************************//**
+ * @file capture_dma.c
+ * @brief TIMER input capture values moved to a RAM ring by the DMA
+ *
+ * Entries are 32 bit copies of the 16 bit CCV register, CAPTURE_EMPTY can
+ * not be a capture value. A reader that falls more than a ring behind loses
+ * the oldest captures, the order of what is left is then not kept.
+ *****************************************************************************/
+#include "em_assert.h"
+#include "em_dma.h"
+#include "capture_dma.h"
+
+#define CAPTURE_HALF      (CAPTURE_DMA_RING / 2)
+#define CAPTURE_EMPTY     0xFFFFFFFFUL
+
+static volatile uint32_t ring[CAPTURE_DMA_RING];
+static unsigned int readIndex;
+static uint32_t consumed;
+static volatile uint32_t halvesDone;
+static DMA_CB_TypeDef cb;
+
+/**************************************************************************//**
+ * @brief Ping-pong completion callback, a ring half is full
+ * The controller writes the other half now, this one is queued after it.
+ *****************************************************************************/
+static void captureHalfDone(unsigned int channel, bool primary, void *user)
+{
+  (void)user;
+
+  halvesDone++;
+  DMA_RefreshPingPong(channel, primary, false, NULL, NULL, CAPTURE_HALF - 1, false);
+}
+
+/**************************************************************************//**
+ * @brief Start recording
+ * DMA_Init must have been called. The timer is started by the caller.
+ *****************************************************************************/
+void captureDmaStart(const captureDmaInit_TypeDef *init)
+{
+  DMA_CfgChannel_TypeDef chnlCfg;
+  DMA_CfgDescr_TypeDef descrCfg;
+  unsigned int i;
+
+  EFM_ASSERT(init->cc < 3);
+
+  for (i = 0; i < CAPTURE_DMA_RING; i++)
+  {
+    ring[i] = CAPTURE_EMPTY;
+  }
+  readIndex  = 0;
+  consumed   = 0;
+  halvesDone = 0;
+
+  cb.cbFunc  = captureHalfDone;
+  cb.userPtr = NULL;
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = init->select;
+  chnlCfg.cb        = &cb;
+  DMA_CfgChannel(init->channel, &chnlCfg);
+
+  /* Register to ring, one capture per request */
+  descrCfg.dstInc  = dmaDataInc4;
+  descrCfg.srcInc  = dmaDataIncNone;
+  descrCfg.size    = dmaDataSize4;
+  descrCfg.arbRate = dmaArbitrate1;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(init->channel, true, &descrCfg);
+  DMA_CfgDescr(init->channel, false, &descrCfg);
+
+  DMA_ActivatePingPong(init->channel,
+                       false,
+                       (void *)&ring[0],
+                       (void *)&init->timer->CC[init->cc].CCV,
+                       CAPTURE_HALF - 1,
+                       (void *)&ring[CAPTURE_HALF],
+                       (void *)&init->timer->CC[init->cc].CCV,
+                       CAPTURE_HALF - 1);
+}
+
+/**************************************************************************//**
+ * @brief Take the next capture from the ring, false when there is none
+ *****************************************************************************/
+bool captureDmaGet(uint32_t *value)
+{
+  uint32_t v = ring[readIndex];
+
+  if (v == CAPTURE_EMPTY)
+  {
+    return false;
+  }
+  ring[readIndex] = CAPTURE_EMPTY;
+  readIndex = (readIndex + 1) % CAPTURE_DMA_RING;
+  consumed++;
+
+  *value = v;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Captures overwritten before they were read, at least
+ * Counts what the completed halves prove, not the half being written.
+ *****************************************************************************/
+uint32_t captureDmaLost(void)
+{
+  uint32_t written = halvesDone * CAPTURE_HALF;
+
+  if (written <= consumed + CAPTURE_DMA_RING)
+  {
+    return 0;
+  }
+  return written - consumed - CAPTURE_DMA_RING;
+}
@@ -0,0 +1,34 @@
+/**************************************************************************//**
+ * @file capture_dma.h
+ * @brief TIMER input capture values moved to a RAM ring by the DMA
+ *
+ * The capture DMA request of a TIMER CC channel makes the DMA copy CCV into
+ * the next ring entry, the CPU is not involved per edge. The ring is the two
+ * halves of a ping-pong cycle, the DMA interrupt only rearms a half once per
+ * CAPTURE_DMA_RING / 2 captures. Read entries are marked empty again, so the
+ * reader needs no position from the controller.
+ *****************************************************************************/
+#ifndef CAPTURE_DMA_H
+#define CAPTURE_DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_device.h"
+
+/* Ring entries, even */
+#define CAPTURE_DMA_RING    64
+
+typedef struct
+{
+  TIMER_TypeDef *timer;     /* Set up with dmaClrAct, CC in capture mode */
+  unsigned int  cc;
+  uint32_t      select;     /* DMAREQ_TIMERn_CCx of that channel */
+  unsigned int  channel;    /* DMA channel */
+} captureDmaInit_TypeDef;
+
+void captureDmaStart(const captureDmaInit_TypeDef *init);
+bool captureDmaGet(uint32_t *value);
+uint32_t captureDmaLost(void);
+
+#endif /* CAPTURE_DMA_H */
@@ -0,0 +1,253 @@
+/**************************************************************************//**
+ * @file freq_counter.c
+ * @brief Frequency of a PRS signal measured by TIMER2, gated over the PRS
+ *
+ * Counting mode: the CC1 input is the signal and the timer clock, CC2
+ * captures the count on the gate. The overflow interrupt extends the count
+ * to 32 bits, the edges of a window are the difference of two captures.
+ * The signal is synchronized to HFPERCLK, so it must stay below half of it.
+ *
+ * Period mode: the CC0 input is the signal, its rising edge captures the
+ * count and reloads and starts the timer, so CCV is the last period. CC2
+ * still takes the gate only for the interrupt. The prescaler is ranged to
+ * keep the period between PERIOD_MIN and 65536 ticks; a window that saw an
+ * overflow at the largest prescaler reports 0 Hz, one without a new period
+ * reports nothing.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_timer.h"
+#include "freq_counter.h"
+
+#define FC_TIMER        TIMER2
+#define SIGNAL_CC       0         /* Period mode */
+#define CLOCK_CC        1         /* Counting mode */
+#define GATE_CC         2
+#define MAX_TOP         0xFFFF
+#define MAX_PRESCALE    timerPrescale1024
+
+/* Shortest period in ticks before a smaller prescaler is taken */
+#define PERIOD_MIN      16384
+
+static freqCounterInit_TypeDef config;
+static freqCounterMode_TypeDef mode;
+static uint32_t prescale;
+static uint32_t clockHz;
+
+/* Counting mode */
+static uint32_t wraps;
+static uint32_t lastCount;
+static bool primed;
+
+/**************************************************************************//**
+ * @brief Set up TIMER2 for one of the modes, measuring starts over
+ *****************************************************************************/
+static void setMode(freqCounterMode_TypeDef newMode, uint32_t newPrescale)
+{
+  bool counting = newMode == freqCounterModeCount;
+
+  mode      = newMode;
+  prescale  = counting ? 0 : newPrescale;
+  wraps     = 0;
+  lastCount = 0;
+  primed    = false;
+
+  TIMER_Enable(FC_TIMER, false);
+  TIMER_IntDisable(FC_TIMER, _TIMER_IEN_MASK);
+
+  TIMER_InitCC_TypeDef timerCCInit =
+  {
+    .eventCtrl = timerEventRising,
+    .edge      = timerEdgeRising,
+    .prsSel    = (TIMER_PRSSEL_TypeDef)config.signalPrs,
+    .cufoa     = timerOutputActionNone,
+    .cofoa     = timerOutputActionNone,
+    .cmoa      = timerOutputActionNone,
+    .mode      = counting ? timerCCModeOff : timerCCModeCapture,
+    .filter    = false,
+    .prsInput  = !counting,
+    .coist     = false,
+    .outInvert = false,
+  };
+  TIMER_InitCC(FC_TIMER, SIGNAL_CC, &timerCCInit);
+
+  /* As the clock the CC1 input needs no capture, only the PRS */
+  timerCCInit.mode     = timerCCModeOff;
+  timerCCInit.prsInput = counting;
+  TIMER_InitCC(FC_TIMER, CLOCK_CC, &timerCCInit);
+
+  timerCCInit.prsSel   = (TIMER_PRSSEL_TypeDef)config.gatePrs;
+  timerCCInit.mode     = timerCCModeCapture;
+  timerCCInit.prsInput = true;
+  TIMER_InitCC(FC_TIMER, GATE_CC, &timerCCInit);
+
+  const TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = counting,                /* Period mode starts on the first edge */
+    .debugRun   = false,
+    .prescale   = (TIMER_Prescale_TypeDef)prescale,
+    .clkSel     = counting ? timerClkSelCC1 : timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = counting ? timerInputActionNone : timerInputActionReloadStart,
+    .mode       = timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = false,
+  };
+  TIMER_TopSet(FC_TIMER, MAX_TOP);
+  TIMER_CounterSet(FC_TIMER, 0);
+  TIMER_Init(FC_TIMER, &timerInit);
+
+  TIMER_IntClear(FC_TIMER, _TIMER_IFC_MASK);
+  TIMER_IntEnable(FC_TIMER, (TIMER_IEN_CC0 << GATE_CC) | (counting ? TIMER_IEN_OF : 0));
+}
+
+/**************************************************************************//**
+ * @brief Smallest prescaler that keeps a period at f below MAX_TOP / 2 ticks
+ *****************************************************************************/
+static uint32_t prescaleFor(uint64_t milliHz)
+{
+  uint32_t p = 0;
+
+  if (milliHz == 0)
+  {
+    return MAX_PRESCALE;
+  }
+  while (p < MAX_PRESCALE
+         && (uint64_t)clockHz * 1000 / (milliHz << p) > MAX_TOP / 2)
+  {
+    p++;
+  }
+  return p;
+}
+
+/**************************************************************************//**
+ * @brief End of a counting mode window
+ *****************************************************************************/
+static void countWindow(uint32_t flags)
+{
+  uint32_t gate = TIMER_CaptureGet(FC_TIMER, GATE_CC);
+  uint32_t count, edges;
+  freqCounterResult_TypeDef result;
+
+  /* An overflow flagged together with a small capture came before it */
+  count = ((wraps + ((flags & TIMER_IF_OF) && gate < 0x8000)) << 16) | gate;
+  edges = count - lastCount;
+  lastCount = count;
+  if (!primed)
+  {
+    primed = true;
+    return;
+  }
+
+  result.mode    = freqCounterModeCount;
+  result.milliHz = (uint64_t)edges * config.gateHz * 1000;
+  config.callback(&result);
+
+  if (edges < FREQ_COUNTER_COUNT_MIN)
+  {
+    setMode(freqCounterModePeriod, prescaleFor(result.milliHz));
+  }
+}
+
+/**************************************************************************//**
+ * @brief End of a period mode window
+ *****************************************************************************/
+static void periodWindow(uint32_t flags)
+{
+  freqCounterResult_TypeDef result;
+  uint32_t ticks;
+
+  result.mode = freqCounterModePeriod;
+
+  if (flags & TIMER_IF_OF)
+  {
+    /* No edge for 65536 ticks, the period is too long for the prescaler */
+    if (prescale < MAX_PRESCALE)
+    {
+      setMode(freqCounterModePeriod, prescale + 1);
+      return;
+    }
+    result.milliHz = 0;
+    config.callback(&result);
+    return;
+  }
+  if (!(flags & (TIMER_IF_CC0 << SIGNAL_CC)))
+  {
+    return;
+  }
+
+  /* Of up to two buffered captures the later one */
+  ticks = TIMER_CaptureGet(FC_TIMER, SIGNAL_CC);
+  if (FC_TIMER->STATUS & (TIMER_STATUS_ICV0 << SIGNAL_CC))
+  {
+    ticks = TIMER_CaptureGet(FC_TIMER, SIGNAL_CC);
+  }
+  /* The edge that started the timer captured 0 */
+  if (ticks == 0)
+  {
+    return;
+  }
+
+  result.milliHz = (uint64_t)clockHz * 1000 / ((uint64_t)ticks << prescale);
+  config.callback(&result);
+
+  if (result.milliHz >= (uint64_t)2 * FREQ_COUNTER_COUNT_MIN * config.gateHz * 1000)
+  {
+    setMode(freqCounterModeCount, 0);
+  }
+  else if (ticks < PERIOD_MIN && prescale > 0)
+  {
+    setMode(freqCounterModePeriod, prescaleFor(result.milliHz));
+  }
+}
+
+/**************************************************************************//**
+ * @brief Gate windows and count wraps
+ *****************************************************************************/
+void TIMER2_IRQHandler(void)
+{
+  uint32_t flags = TIMER_IntGet(FC_TIMER);
+
+  TIMER_IntClear(FC_TIMER, flags);
+
+  if (mode == freqCounterModeCount)
+  {
+    if (flags & (TIMER_IF_CC0 << GATE_CC))
+    {
+      countWindow(flags);
+    }
+    /* Unless the window just switched to period mode */
+    if ((flags & TIMER_IF_OF) && mode == freqCounterModeCount)
+    {
+      wraps++;
+    }
+  }
+  else if (flags & (TIMER_IF_CC0 << GATE_CC))
+  {
+    periodWindow(flags);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Start measuring, in counting mode
+ * The signal and the gate must already be on their PRS channels. Takes
+ * over TIMER2 and its interrupt.
+ *****************************************************************************/
+void freqCounterStart(const freqCounterInit_TypeDef *init)
+{
+  EFM_ASSERT(init->signalPrs != init->gatePrs);
+  EFM_ASSERT(init->gateHz > 0 && init->callback != NULL);
+
+  config = *init;
+
+  CMU_ClockEnable(cmuClock_TIMER2, true);
+  clockHz = CMU_ClockFreqGet(cmuClock_TIMER2);
+
+  setMode(freqCounterModeCount, 0);
+
+  NVIC_ClearPendingIRQ(TIMER2_IRQn);
+  NVIC_EnableIRQ(TIMER2_IRQn);
+}
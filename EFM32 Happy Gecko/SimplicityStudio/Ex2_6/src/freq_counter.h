@@ -0,0 +1,46 @@
+/**************************************************************************//**
+ * @file freq_counter.h
+ * @brief Frequency of a PRS signal measured by TIMER2, gated over the PRS
+ *
+ * Counting mode clocks TIMER2 from the signal and captures the count at the
+ * end of each gate window, the gate being a pulse on another PRS channel
+ * from a second timer or the RTC. Period mode clocks TIMER2 from HFPERCLK
+ * and captures it, then restarts it, on each rising edge of the signal.
+ * The counter switches to period mode when fewer than FREQ_COUNTER_COUNT_MIN
+ * edges fall in a window and back when the period says there would be twice
+ * as many. Either way the CPU only sees one interrupt per gate window (and
+ * one per 65536 edges when counting), the result goes to a callback.
+ *****************************************************************************/
+#ifndef FREQ_COUNTER_H
+#define FREQ_COUNTER_H
+
+#include <stdint.h>
+
+/* Edges per gate window below which a period is more exact than a count */
+#define FREQ_COUNTER_COUNT_MIN    1000
+
+typedef enum
+{
+  freqCounterModeCount,
+  freqCounterModePeriod,
+} freqCounterMode_TypeDef;
+
+typedef struct
+{
+  freqCounterMode_TypeDef mode;     /* How it was measured */
+  uint64_t                milliHz;  /* 0 below the range of period mode */
+} freqCounterResult_TypeDef;
+
+typedef void (*freqCounterCallback_TypeDef)(const freqCounterResult_TypeDef *result);
+
+typedef struct
+{
+  unsigned int                signalPrs;  /* PRS channel carrying the signal */
+  unsigned int                gatePrs;    /* PRS channel pulsing at the end of each window */
+  uint32_t                    gateHz;     /* Gate windows per second */
+  freqCounterCallback_TypeDef callback;   /* Called from the TIMER2 interrupt */
+} freqCounterInit_TypeDef;
+
+void freqCounterStart(const freqCounterInit_TypeDef *init);
+
+#endif /* FREQ_COUNTER_H */
@@ -0,0 +1,57 @@
+/**************************************************************************//**
+ * @file pulse_stats.c
+ * @brief Running minimum, maximum, mean and histogram of pulse widths
+ *****************************************************************************/
+#include <string.h>
+
+#include "em_assert.h"
+#include "pulse_stats.h"
+
+/**************************************************************************//**
+ * @brief Clear the statistics, histogram bins binWidth ticks wide
+ *****************************************************************************/
+void pulseStatsInit(pulseStats_TypeDef *stats, uint32_t binWidth)
+{
+  EFM_ASSERT(binWidth > 0);
+
+  memset(stats, 0, sizeof(*stats));
+  stats->min      = UINT32_MAX;
+  stats->binWidth = binWidth;
+}
+
+/**************************************************************************//**
+ * @brief Add a pulse width in ticks, past the last bin it counts in that one
+ *****************************************************************************/
+void pulseStatsAdd(pulseStats_TypeDef *stats, uint32_t width)
+{
+  uint32_t bin = width / stats->binWidth;
+
+  if (bin >= PULSE_STATS_BINS)
+  {
+    bin = PULSE_STATS_BINS - 1;
+  }
+  stats->bins[bin]++;
+
+  if (width < stats->min)
+  {
+    stats->min = width;
+  }
+  if (width > stats->max)
+  {
+    stats->max = width;
+  }
+  stats->sum += width;
+  stats->count++;
+}
+
+/**************************************************************************//**
+ * @brief Mean width, 0 before the first pulse
+ *****************************************************************************/
+uint32_t pulseStatsMean(const pulseStats_TypeDef *stats)
+{
+  if (stats->count == 0)
+  {
+    return 0;
+  }
+  return (uint32_t)(stats->sum / stats->count);
+}
@@ -0,0 +1,29 @@
+/**************************************************************************//**
+ * @file pulse_stats.h
+ * @brief Running minimum, maximum, mean and histogram of pulse widths
+ *
+ * Widths are in timer ticks, bins are binWidth ticks wide and the last bin
+ * takes everything longer.
+ *****************************************************************************/
+#ifndef PULSE_STATS_H
+#define PULSE_STATS_H
+
+#include <stdint.h>
+
+#define PULSE_STATS_BINS    8
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t binWidth;
+  uint32_t bins[PULSE_STATS_BINS];
+} pulseStats_TypeDef;
+
+void pulseStatsInit(pulseStats_TypeDef *stats, uint32_t binWidth);
+void pulseStatsAdd(pulseStats_TypeDef *stats, uint32_t width);
+uint32_t pulseStatsMean(const pulseStats_TypeDef *stats);
+
+#endif /* PULSE_STATS_H */
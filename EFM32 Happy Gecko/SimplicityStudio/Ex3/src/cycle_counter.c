@@ -0,0 +1,27 @@
+/**************************************************************************//**
+ * @file cycle_counter.c
+ * @brief Core clock cycle counter on SysTick
+ *****************************************************************************/
+#include "em_device.h"
+#include "cycle_counter.h"
+
+/**************************************************************************//**
+ * @brief Start SysTick counting core clock cycles, unless it already runs
+ *****************************************************************************/
+void cycleCounterStart(void)
+{
+  if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk))
+  {
+    SysTick->LOAD = CYCLE_COUNTER_MASK;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Cycles counted up, wrapping at 24 bits
+ *****************************************************************************/
+uint32_t cycleCounterGet(void)
+{
+  return ~SysTick->VAL & CYCLE_COUNTER_MASK;
+}
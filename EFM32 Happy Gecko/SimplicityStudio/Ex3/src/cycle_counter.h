@@ -0,0 +1,22 @@
+/**************************************************************************//**
+ * @file cycle_counter.h
+ * @brief Core clock cycle counter on SysTick
+ *
+ * The Cortex-M0+ has no DWT cycle counter. SysTick stands in for it as a
+ * free running 24 bit down counter on the core clock, its interrupt off;
+ * cycleCounterGet() turns that into an up count, so an interval is
+ * (cycleCounterGet() - start) & CYCLE_COUNTER_MASK. Intervals must stay
+ * below 2^24 cycles, 1.2 s at 14 MHz. Every user calls cycleCounterStart(),
+ * the first one starts it and the others keep it running as it is.
+ *****************************************************************************/
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+#define CYCLE_COUNTER_MASK    0xFFFFFFUL
+
+void cycleCounterStart(void);
+uint32_t cycleCounterGet(void);
+
+#endif /* CYCLE_COUNTER_H */
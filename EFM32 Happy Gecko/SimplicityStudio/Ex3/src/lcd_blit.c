@@ -0,0 +1,168 @@
+/***************************************************************************//**
+ * @file lcd_blit.c
+ * @brief DMA rectangle copy of prerendered 1 bpp images
+ *
+ * The 2D copy only exists for channel 0, on parts that have it the blitter
+ * asks the channel manager for a high priority channel, the lowest free
+ * one, and must be the first to do so. Without it the Happy Gecko gets a memory
+ * scatter-gather chain with one entry per row; DMA_ActivateScatterGather
+ * starts it with a software request and the chain runs without further
+ * CPU work. Bytes are copied one at a time as the framebuffer rows are not
+ * word aligned.
+ ******************************************************************************/
+#include "em_device.h"
+#include "em_core.h"
+#include "em_dma.h"
+#include "em_emu.h"
+#include "em_assert.h"
+#include "dma_channel.h"
+#include "lcd_blit.h"
+
+static unsigned int dmaChannel;
+static volatile bool busy;
+
+#if !defined(_DMA_RECT0_MASK)
+static DMA_DESCRIPTOR_TypeDef chain[LCD_BLIT_MAX_ROWS];
+#endif
+
+static void blitDone(unsigned int channel, bool primary, void *user)
+{
+  (void)channel;
+  (void)primary;
+  (void)user;
+
+  busy = false;
+}
+
+/***************************************************************************//**
+ * @brief Set up the DMA channel for the blitter
+ * DMA_Init must have been called. Returns false when no DMA channel is free.
+ ******************************************************************************/
+bool lcdBlitInit(void)
+{
+  dmaChannelCfg_TypeDef chnlCfg;
+  int channel;
+
+#if defined(_DMA_RECT0_MASK)
+  DMA_CfgDescr_TypeDef descrCfg;
+
+  chnlCfg.highPri   = true;
+#else
+  chnlCfg.highPri   = false;
+#endif
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = 0;
+  chnlCfg.cbFunc    = blitDone;
+  chnlCfg.userPtr   = NULL;
+  chnlCfg.owner     = "blit";
+  channel = dmaChannelAlloc(&chnlCfg);
+  if (channel == DMA_CHANNEL_NONE) {
+    return false;
+  }
+  dmaChannel = (unsigned int)channel;
+
+#if defined(_DMA_RECT0_MASK)
+  EFM_ASSERT(channel == 0);
+
+  descrCfg.dstInc  = dmaDataInc1;
+  descrCfg.srcInc  = dmaDataInc1;
+  descrCfg.size    = dmaDataSize1;
+  descrCfg.arbRate = dmaArbitrate1024;
+  descrCfg.hprot   = 0;
+  DMA_CfgDescr(dmaChannel, true, &descrCfg);
+#endif
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief Start copying an image to dst, a buffer with rows dstStride apart
+ * Waits for the previous blit. The copy runs on, lcdBlitWait() before
+ * the destination is used.
+ ******************************************************************************/
+void lcdBlit(uint8_t *dst, unsigned int dstStride, const lcdBlitImage_TypeDef *image)
+{
+#if defined(_DMA_RECT0_MASK)
+  DMA_CfgRect_TypeDef rectCfg;
+#else
+  DMA_CfgDescrSGAlt_TypeDef cfg;
+  unsigned int row;
+#endif
+
+  EFM_ASSERT(image->widthBytes > 0 && image->height > 0);
+
+  lcdBlitWait();
+  busy = true;
+
+#if defined(_DMA_RECT0_MASK)
+  /* Strides count elements from the start of one row to the next */
+  rectCfg.dstStride = dstStride;
+  rectCfg.srcStride = image->stride;
+  rectCfg.height    = image->height - 1;
+  DMA_CfgRect(dmaChannel, &rectCfg);
+  DMA_ActivateAuto(dmaChannel, true, dst, image->data, image->widthBytes - 1);
+#else
+  EFM_ASSERT(image->height <= LCD_BLIT_MAX_ROWS);
+
+  cfg.nMinus1    = image->widthBytes - 1;
+  cfg.dstInc     = dmaDataInc1;
+  cfg.srcInc     = dmaDataInc1;
+  cfg.size       = dmaDataSize1;
+  cfg.arbRate    = dmaArbitrate1024;
+  cfg.hprot      = 0;
+  cfg.peripheral = false;
+  for (row = 0; row < image->height; row++) {
+    cfg.dst = dst + row * dstStride;
+    cfg.src = (void *)(image->data + row * image->stride);
+    DMA_CfgDescrScatterGather(chain, row, &cfg);
+  }
+  DMA_ActivateScatterGather(dmaChannel, false, chain, image->height);
+#endif
+}
+
+bool lcdBlitBusy(void)
+{
+  return busy;
+}
+
+/***************************************************************************//**
+ * @brief Sleep in EM1 until the blit in progress is done
+ ******************************************************************************/
+void lcdBlitWait(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  while (busy) {
+    EMU_EnterEM1();
+    CORE_EXIT_CRITICAL();
+    CORE_ENTER_CRITICAL();
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief Prerender an image moved right by shift (0..7) pixels
+ * dst gets widthBytes + 1 bytes per row, packed, the uncovered pixels are
+ * taken from background. Bit 0 is the leftmost pixel of a byte, as in the
+ * memory LCD framebuffer. Done once per image and bit position, not per blit.
+ ******************************************************************************/
+void lcdBlitShift(uint8_t *dst, const lcdBlitImage_TypeDef *image,
+                  unsigned int shift, uint8_t background)
+{
+  const uint8_t *src;
+  unsigned int row, i;
+  uint8_t low = (uint8_t)((1U << shift) - 1);
+  uint8_t carry;
+
+  EFM_ASSERT(shift < 8);
+
+  for (row = 0; row < image->height; row++) {
+    src = image->data + row * image->stride;
+    carry = background & low;
+    for (i = 0; i < image->widthBytes; i++) {
+      *dst++ = (uint8_t)(src[i] << shift) | carry;
+      carry = (uint8_t)(src[i] >> (8 - shift));
+    }
+    *dst++ = carry | (background & (uint8_t)~low);
+  }
+}
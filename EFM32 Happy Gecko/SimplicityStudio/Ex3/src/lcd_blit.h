@@ -0,0 +1,35 @@
+/***************************************************************************//**
+ * @file lcd_blit.h
+ * @brief DMA rectangle copy of prerendered 1 bpp images
+ *
+ * Copies a rectangle of whole bytes between buffers with different strides,
+ * e.g. a glyph into the memory LCD framebuffer. Parts with the DMA 2D copy
+ * (RECT0) use it, the others get one memory scatter-gather entry per row;
+ * either way the CPU only sets the copy up. Images are opaque and byte
+ * granular, an image for an x that is not a multiple of 8 is prerendered
+ * shifted with lcdBlitShift().
+ ******************************************************************************/
+#ifndef LCD_BLIT_H
+#define LCD_BLIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Tallest image without the 2D copy, one descriptor per row */
+#define LCD_BLIT_MAX_ROWS    24
+
+typedef struct {
+  const uint8_t *data;      /* Top row */
+  uint16_t      widthBytes;
+  uint16_t      height;
+  uint16_t      stride;     /* Bytes from one row to the next */
+} lcdBlitImage_TypeDef;
+
+bool lcdBlitInit(void);
+void lcdBlit(uint8_t *dst, unsigned int dstStride, const lcdBlitImage_TypeDef *image);
+bool lcdBlitBusy(void);
+void lcdBlitWait(void);
+void lcdBlitShift(uint8_t *dst, const lcdBlitImage_TypeDef *image,
+                  unsigned int shift, uint8_t background);
+
+#endif /* LCD_BLIT_H */
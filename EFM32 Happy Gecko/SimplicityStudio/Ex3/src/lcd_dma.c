@@ -0,0 +1,294 @@
+/***************************************************************************//**
+ * @file lcd_dma.c
+ * @brief Memory LCD framebuffer flushed by the DMA
+ *
+ * DISPLAY_Init has set up the USART for SPI, the chip select and EXTCOMIN,
+ * only the data transfer is taken over here. The DMA is done when the last
+ * byte is in the USART, chip select is released from the TX complete
+ * interrupt once it has been shifted out. A flush must not overlap
+ * DMD_updateDisplay, both use the same USART.
+ *
+ * Flushes are timed in core clock cycles with the cycle counter.
+ ******************************************************************************/
+#include <string.h>
+
+#include "em_device.h"
+#include "em_core.h"
+#include "em_dma.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "displayconfig.h"
+#include "displaypal.h"
+#include "cycle_counter.h"
+#include "dma_channel.h"
+#include "lcd_dma.h"
+
+/* The SLSTK3400A memory LCD is on USART0 */
+#define LCD_USART             USART0
+#define LCD_DMAREQ            DMAREQ_USART0_TXBL
+
+/* LS013B7DH03 update command, gate addresses count from 1 */
+#define LCD_CMD_UPDATE        0x01
+
+/* Chip select setup and hold time, microseconds */
+#define LCD_SCS_SETUP_US      6
+#define LCD_SCS_HOLD_US       2
+
+#define DMA_MAX_ELEMENTS      1024
+#define CHAIN_LENGTH          16
+
+/* One line as it goes out on SPI */
+struct lcdLine {
+  uint8_t address;
+  uint8_t data[LCD_DMA_LINE_BYTES];
+  uint8_t trailer;
+};
+
+#if defined(__GNUC__)
+_Static_assert(sizeof(struct lcdLine) == LCD_DMA_STRIDE, "LCD line is not packed");
+#endif
+
+#define LINES_PER_ENTRY       (DMA_MAX_ELEMENTS / sizeof(struct lcdLine))
+#define ENTRIES_PER_FRAME     ((LCD_DMA_HEIGHT + LINES_PER_ENTRY - 1) / LINES_PER_ENTRY)
+
+static struct lcdLine frame[LCD_DMA_HEIGHT];
+static uint32_t dirty[LCD_DMA_HEIGHT / 32];
+
+static const uint8_t updateCommand = LCD_CMD_UPDATE;
+static const uint8_t frameTrailer = 0;
+
+static DMA_DESCRIPTOR_TypeDef chain[CHAIN_LENGTH];
+static unsigned int dmaChannel;
+static volatile bool busy;
+static uint32_t startTick;
+static lcdDmaStats_TypeDef stats;
+
+static bool lineDirty(unsigned int y)
+{
+  return (dirty[y / 32] >> (y % 32)) & 1;
+}
+
+/***************************************************************************//**
+ * @brief Append one USART transfer to the scatter-gather chain
+ ******************************************************************************/
+static unsigned int addEntry(unsigned int count, const void *src, unsigned int bytes)
+{
+  DMA_CfgDescrSGAlt_TypeDef cfg;
+
+  cfg.dst        = (void *)&LCD_USART->TXDATA;
+  cfg.src        = (void *)src;
+  cfg.nMinus1    = bytes - 1;
+  cfg.dstInc     = dmaDataIncNone;
+  cfg.srcInc     = dmaDataInc1;
+  cfg.size       = dmaDataSize1;
+  cfg.arbRate    = dmaArbitrate1;
+  cfg.hprot      = 0;
+  cfg.peripheral = true;
+  DMA_CfgDescrScatterGather(chain, count, &cfg);
+
+  return count + 1;
+}
+
+/***************************************************************************//**
+ * @brief DMA completion callback, the last byte is still being sent
+ ******************************************************************************/
+static void flushDone(unsigned int channel, bool primary, void *user)
+{
+  (void)channel;
+  (void)primary;
+  (void)user;
+
+  LCD_USART->IFC = USART_IFC_TXC;
+  LCD_USART->IEN |= USART_IEN_TXC;
+
+  /* Already out while the DMA interrupt was pending */
+  if (LCD_USART->STATUS & USART_STATUS_TXC) {
+    LCD_USART->IFS = USART_IFS_TXC;
+  }
+}
+
+/***************************************************************************//**
+ * @brief USART TX complete: the frame is out, release the chip select
+ ******************************************************************************/
+void USART0_TX_IRQHandler(void)
+{
+  LCD_USART->IEN &= ~USART_IEN_TXC;
+  LCD_USART->IFC = USART_IFC_TXC;
+
+  PAL_TimerMicroSecondsDelay(LCD_SCS_HOLD_US);
+  GPIO_PinOutClear((GPIO_Port_TypeDef)LCD_PORT_SCS, LCD_PIN_SCS);
+
+  stats.cyclesLast = (cycleCounterGet() - startTick) & CYCLE_COUNTER_MASK;
+  stats.frames++;
+  busy = false;
+}
+
+/***************************************************************************//**
+ * @brief Set up the framebuffer and the DMA channel
+ * DISPLAY_Init and DMA_Init must have been called. The framebuffer starts
+ * white, all lines changed. Returns false when no DMA channel is free.
+ ******************************************************************************/
+bool lcdDmaInit(void)
+{
+  dmaChannelCfg_TypeDef chnlCfg;
+  int channel;
+  unsigned int y;
+
+  for (y = 0; y < LCD_DMA_HEIGHT; y++) {
+    frame[y].address = y + 1;
+    frame[y].trailer = 0;
+  }
+  lcdDmaClear();
+
+  chnlCfg.highPri   = false;
+  chnlCfg.enableInt = true;
+  chnlCfg.select    = LCD_DMAREQ;
+  chnlCfg.cbFunc    = flushDone;
+  chnlCfg.userPtr   = NULL;
+  chnlCfg.owner     = "lcd";
+  channel = dmaChannelAlloc(&chnlCfg);
+  if (channel == DMA_CHANNEL_NONE) {
+    return false;
+  }
+  dmaChannel = (unsigned int)channel;
+
+  NVIC_ClearPendingIRQ(USART0_TX_IRQn);
+  NVIC_EnableIRQ(USART0_TX_IRQn);
+
+  cycleCounterStart();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief Pixel data of line y, marked as changed
+ * Waits for a flush in progress, it may still be reading the line.
+ ******************************************************************************/
+uint8_t *lcdDmaLine(unsigned int y)
+{
+  lcdDmaWait();
+  dirty[y / 32] |= 1UL << (y % 32);
+
+  return frame[y].data;
+}
+
+/***************************************************************************//**
+ * @brief Pixel data of lines y to y + count - 1, marked as changed
+ * The lines are LCD_DMA_STRIDE bytes apart, for lcdBlit().
+ ******************************************************************************/
+uint8_t *lcdDmaLines(unsigned int y, unsigned int count)
+{
+  unsigned int i;
+
+  lcdDmaWait();
+  for (i = y; i < y + count; i++) {
+    dirty[i / 32] |= 1UL << (i % 32);
+  }
+
+  return frame[y].data;
+}
+
+/***************************************************************************//**
+ * @brief Fill the framebuffer with white
+ ******************************************************************************/
+void lcdDmaClear(void)
+{
+  unsigned int y;
+
+  lcdDmaWait();
+  for (y = 0; y < LCD_DMA_HEIGHT; y++) {
+    memset(frame[y].data, LCD_DMA_WHITE, LCD_DMA_LINE_BYTES);
+  }
+  memset(dirty, 0xFF, sizeof(dirty));
+}
+
+/***************************************************************************//**
+ * @brief Send the changed lines
+ * Returns false when no line has changed. The transfer runs on, use
+ * lcdDmaWait() or lcdDmaBusy() to find out when it is done.
+ ******************************************************************************/
+bool lcdDmaFlush(void)
+{
+  unsigned int count, y, first, end, last, n;
+  unsigned int lines = 0;
+  uint32_t t0;
+
+  lcdDmaWait();
+  t0 = cycleCounterGet();
+
+  for (last = LCD_DMA_HEIGHT; last > 0 && !lineDirty(last - 1); last--) {
+  }
+  if (last == 0) {
+    return false;
+  }
+
+  count = addEntry(0, &updateCommand, 1);
+  y = 0;
+  while (y < last) {
+    if (!lineDirty(y)) {
+      y++;
+      continue;
+    }
+
+    first = y;
+    if (count + ENTRIES_PER_FRAME + 1 >= CHAIN_LENGTH) {
+      /* Chain nearly full, the rest goes in one run with its clean lines */
+      y = last;
+    } else {
+      while (y < last && lineDirty(y)) {
+        y++;
+      }
+    }
+    end = y;
+    lines += end - first;
+
+    /* Consecutive lines are contiguous, split only at the DMA cycle limit */
+    while (first < end) {
+      n = end - first;
+      if (n > LINES_PER_ENTRY) {
+        n = LINES_PER_ENTRY;
+      }
+      count = addEntry(count, &frame[first], n * sizeof(struct lcdLine));
+      first += n;
+    }
+  }
+  count = addEntry(count, &frameTrailer, 1);
+
+  memset(dirty, 0, sizeof(dirty));
+  stats.linesLast = lines;
+  stats.lines    += lines;
+  startTick = t0;
+  busy = true;
+
+  GPIO_PinOutSet((GPIO_Port_TypeDef)LCD_PORT_SCS, LCD_PIN_SCS);
+  PAL_TimerMicroSecondsDelay(LCD_SCS_SETUP_US);
+  DMA_ActivateScatterGather(dmaChannel, false, chain, count);
+
+  stats.cyclesSetup = (cycleCounterGet() - t0) & CYCLE_COUNTER_MASK;
+  return true;
+}
+
+bool lcdDmaBusy(void)
+{
+  return busy;
+}
+
+/***************************************************************************//**
+ * @brief Sleep in EM1 until the flush in progress is done
+ ******************************************************************************/
+void lcdDmaWait(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  while (busy) {
+    EMU_EnterEM1();
+    CORE_EXIT_CRITICAL();
+    CORE_ENTER_CRITICAL();
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+const lcdDmaStats_TypeDef *lcdDmaStatsGet(void)
+{
+  return &stats;
+}
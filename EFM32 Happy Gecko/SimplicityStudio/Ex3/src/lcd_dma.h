@@ -0,0 +1,44 @@
+/***************************************************************************//**
+ * @file lcd_dma.h
+ * @brief Memory LCD framebuffer flushed by the DMA
+ *
+ * The framebuffer is kept in the order the LS013B7DH03 takes it over SPI,
+ * every line as gate address, pixel data and a dummy trailer byte. A run of
+ * changed lines is then one contiguous block, and a flush is a peripheral
+ * scatter-gather chain of: update command, one entry per run, final dummy
+ * byte. The USART TX buffer level paces the DMA while the CPU sleeps in EM1.
+ ******************************************************************************/
+#ifndef LCD_DMA_H
+#define LCD_DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LCD_DMA_WIDTH         128
+#define LCD_DMA_HEIGHT        128
+#define LCD_DMA_LINE_BYTES    (LCD_DMA_WIDTH / 8)
+
+/* Bytes from one line's pixel data to the next, address and trailer between */
+#define LCD_DMA_STRIDE        (LCD_DMA_LINE_BYTES + 2)
+
+/* Pixel bit value of a white pixel, bit 0 of a byte is its leftmost pixel */
+#define LCD_DMA_WHITE         0xFF
+
+typedef struct {
+  uint32_t frames;        /* Flushes completed */
+  uint32_t lines;         /* Lines sent by all flushes */
+  uint32_t linesLast;     /* Lines sent by the last flush */
+  uint32_t cyclesSetup;   /* Core cycles to build and start the last chain */
+  uint32_t cyclesLast;    /* Core cycles from start to chip select release */
+} lcdDmaStats_TypeDef;
+
+bool lcdDmaInit(void);
+uint8_t *lcdDmaLine(unsigned int y);
+uint8_t *lcdDmaLines(unsigned int y, unsigned int count);
+void lcdDmaClear(void);
+bool lcdDmaFlush(void);
+bool lcdDmaBusy(void);
+void lcdDmaWait(void);
+const lcdDmaStats_TypeDef *lcdDmaStatsGet(void);
+
+#endif /* LCD_DMA_H */
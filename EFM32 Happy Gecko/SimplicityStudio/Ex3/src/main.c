@@ -4,17 +4,23 @@
 #include <stdbool.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include "em_device.h"
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_emu.h"
+#include "em_core.h"
 #include "em_gpio.h"
 #include "em_pcnt.h"
 #include "em_prs.h"
+#include "em_dma.h"
 #include "display.h"
 #include "glib.h"
 #include "bspconfig.h"
+#include "cycle_counter.h"
+#include "lcd_dma.h"
+#include "lcd_blit.h"
 
 /* Defines for the LED 0 */
 #define LED0_PORT    gpioPortF
@@ -24,6 +30,45 @@
  * = frequency of LCD polarity inversion. */
 #define RTC_PULSE_FREQUENCY    (64)
 
+/* Longest time between two PCNT wraps in RTC pulses, TOP fits 8 bits */
+#define WAKEUP_MAX_PULSES      256
+
+/* Pulses the new TOP is kept ahead of the counter, for the LF sync */
+#define WAKEUP_MIN_PULSES      2
+
+/* Seconds the LED stays on for a scheduled time */
+#define LED_ON_SECONDS         30
+
+/* Position of the digital clock, the lines a clock update changes */
+#define CLOCK_Y                52
+#define CLOCK_HEIGHT           20
+
+/* "hh:mm:ss" in byte aligned 16x20 cells across the display */
+#define CLOCK_CHARS            8
+#define GLYPH_WIDTH_BYTES      2
+#define GLYPH_COLON            10
+#define GLYPH_COUNT            11
+
+/* Typical EFM32HG supply current from the datasheet, only used to estimate
+ * the energy of a display refresh */
+#define EM0_UA_PER_MHZ         127
+#define EM1_UA_PER_MHZ         48
+#define SUPPLY_MV              3300
+
+/* Seconds the flush benchmark stays on the display */
+#define BENCHMARK_SHOW_SECONDS 3
+
+/* DMA control block, must be aligned to 256. */
+#if defined (__ICCARM__)
+#pragma data_alignment=256
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2];
+#elif defined (__CC_ARM)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#elif defined (__GNUC__)
+DMA_DESCRIPTOR_TypeDef dmaControlBlock[DMA_CHAN_COUNT * 2] __attribute__ ((aligned(256)));
+#else
+#error Undefined toolkit, need to define alignment
+#endif
 
 /* The current time reference. Number of seconds since midnight
  * January 1, 1970.  */
@@ -32,8 +77,14 @@ static volatile time_t curCount =0;
 static volatile time_t ledTime =0;
 static volatile time_t timeArray[9];
 
-/* PCNT interrupt counter */
-static volatile int pcntIrqCount = 0;
+/* Seconds counted since start */
+static volatile int secondCount = 0;
+
+/* The PCNT counts the RTC pulses, TOP is moved to the next deadline so it
+ * only wraps when something is due. The time is derived from the count. */
+static uint32_t pulseBase;     /* Pulses before the last wrap */
+static uint32_t pulseTop;      /* TOP the counter is running to */
+static uint32_t secondStart;   /* Pulse count the current second began at */
 
 /* Flag to check when we should redraw a frame */
 static volatile bool updateDisplay = true;
@@ -44,8 +95,172 @@ static volatile bool buttonPressed = false;
 /* Global glib context */
 GLIB_Context_t gc;
 
+/* Seven segment glyphs of the digits and the colon, drawn once at startup */
+static uint8_t glyphData[GLYPH_COUNT][CLOCK_HEIGHT][GLYPH_WIDTH_BYTES];
+static lcdBlitImage_TypeDef glyph[GLYPH_COUNT];
+
+/* Characters currently in the framebuffer, 0 when unknown */
+static char clockShown[CLOCK_CHARS];
+
+/* Segment rectangles as first row, rows, first column, columns */
+static const uint8_t segmentRect[8][4] = {
+  {  0, 2,  3, 10 },  /* a */
+  {  2, 7, 13,  2 },  /* b */
+  { 11, 7, 13,  2 },  /* c */
+  { 18, 2,  3, 10 },  /* d */
+  { 11, 7,  1,  2 },  /* e */
+  {  2, 7,  1,  2 },  /* f */
+  {  9, 2,  3, 10 },  /* g */
+  {  5, 2,  7,  2 },  /* colon, drawn twice */
+};
+
+/* Segments a..g of the digits 0..9 in bits 0..6 */
+static const uint8_t digitSegments[10] = {
+  0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+};
+
 
 
+/***************************************************************************//**
+ * @brief   RTC pulses since start. Interrupts must be masked.
+ *
+ ******************************************************************************/
+static uint32_t pulsesNow(void)
+{
+  uint32_t cnt = PCNT_CounterGet(PCNT0);
+
+  /* A wrap the interrupt has not counted yet */
+  if (PCNT0->IF & PCNT_IF_OF) {
+    return pulseBase + pulseTop + 1 + PCNT_CounterGet(PCNT0);
+  }
+  return pulseBase + cnt;
+}
+
+/***************************************************************************//**
+ * @brief   One second of the clock has passed.
+ *
+ ******************************************************************************/
+static void secondElapsed(void)
+{
+  secondCount++;
+
+  /* Increase time with 1s */
+  if (!(timeIsFastForwarding))
+  {
+    curTime++;
+
+    /* Check if current time is been set a a scheduled time*/
+    for(int i =0; i<10; i++)
+    {
+    	if(timeArray[i] == curTime) //turn on led
+    	{
+    		GPIO_PinOutSet(LED0_PORT, LED0_PIN);
+    		ledTime = curTime;
+    	}
+
+    	if(curTime >= ledTime+LED_ON_SECONDS) //after 30sec turn led back off
+    	{
+    		GPIO_PinOutClear(LED0_PORT, LED0_PIN);
+
+    	}
+    }
+  }
+
+  /* Notify main loop to redraw clock on display. */
+  if(!(scheduleTimeRequest))
+	  updateDisplay = true;
+}
+
+/***************************************************************************//**
+ * @brief   Counts the seconds that passed since the last call.
+ *          Interrupts must be masked.
+ *
+ ******************************************************************************/
+static void clockCatchUp(void)
+{
+  uint32_t now = pulsesNow();
+
+  while (now - secondStart >= RTC_PULSE_FREQUENCY) {
+    secondStart += RTC_PULSE_FREQUENCY;
+    secondElapsed();
+  }
+}
+
+/***************************************************************************//**
+ * @brief   Pulse count of the next wake-up.
+ *          Every second while the clock is shown or being set, otherwise at
+ *          the next scheduled time or when the LED goes off.
+ *
+ ******************************************************************************/
+static uint32_t nextDeadline(void)
+{
+  time_t seconds = 0;
+  time_t wait;
+  int i;
+
+  if (!scheduleTimeRequest || timeIsFastForwarding) {
+    return secondStart + RTC_PULSE_FREQUENCY;
+  }
+
+  for (i = 0; i < 9; i++) {
+    wait = timeArray[i] - curTime;
+    if (wait > 0 && (seconds == 0 || wait < seconds)) {
+      seconds = wait;
+    }
+  }
+  if (GPIO_PinOutGet(LED0_PORT, LED0_PIN)) {
+    wait = ledTime + LED_ON_SECONDS - curTime;
+    if (wait > 0 && (seconds == 0 || wait < seconds)) {
+      seconds = wait;
+    }
+  }
+  if (seconds == 0 || seconds > WAKEUP_MAX_PULSES / RTC_PULSE_FREQUENCY) {
+    return pulsesNow() + WAKEUP_MAX_PULSES;
+  }
+  return secondStart + (uint32_t)seconds * RTC_PULSE_FREQUENCY;
+}
+
+/***************************************************************************//**
+ * @brief   Moves the PCNT wrap to the next deadline. Interrupts must be
+ *          masked. Only TOP changes, no pulse is lost.
+ *
+ ******************************************************************************/
+static void wakeupSet(void)
+{
+  uint32_t cnt, top;
+
+  /* The interrupt sets it once it has counted the wrap */
+  if (PCNT0->IF & PCNT_IF_OF) {
+    return;
+  }
+
+  cnt = PCNT_CounterGet(PCNT0);
+  top = nextDeadline() - pulseBase - 1;
+  if ((int32_t)(top - cnt) < WAKEUP_MIN_PULSES) {
+    top = cnt + WAKEUP_MIN_PULSES;
+  }
+  if (top > WAKEUP_MAX_PULSES - 1) {
+    top = WAKEUP_MAX_PULSES - 1;
+  }
+  pulseTop = top;
+  PCNT_TopSet(PCNT0, top);
+}
+
+/***************************************************************************//**
+ * @brief   Brings the clock up to date and sets the next wake-up, after
+ *          anything that changes what is due.
+ *
+ ******************************************************************************/
+static void clockReschedule(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  clockCatchUp();
+  wakeupSet();
+  CORE_EXIT_ATOMIC();
+}
+
 /***************************************************************************//**
  * @brief Setup GPIO interrupt for pushbuttons.
  ******************************************************************************/
@@ -103,6 +318,9 @@ void GPIO_Unified_IRQ(void)
     updateDisplay = true;
 
   }
+
+  /* Wake up every second again, or at the changed scheduled time */
+  clockReschedule();
 }
 
 /***************************************************************************//**
@@ -122,7 +340,7 @@ void GPIO_ODD_IRQHandler(void)
 }
 
 /***************************************************************************//**
- * @brief   Set up PCNT to generate an interrupt every second.
+ * @brief   Set up PCNT to count the RTC pulses, waking up in a second.
  *
  ******************************************************************************/
 void pcntInit(void)
@@ -133,7 +351,7 @@ void pcntInit(void)
   CMU_ClockEnable(cmuClock_PCNT0, true);
   /* Set up the PCNT to count RTC_PULSE_FREQUENCY pulses -> one second */
   pcntInit.mode = pcntModeOvsSingle;
-  pcntInit.top = RTC_PULSE_FREQUENCY;
+  pcntInit.top = RTC_PULSE_FREQUENCY - 1;
   pcntInit.s1CntDir = false;
   /* The PRS channel used depends on the configuration and which pin the
      LCD inversion toggle is connected to. So use the generic define here. */
@@ -141,49 +359,29 @@ void pcntInit(void)
 
   PCNT_Init(PCNT0, &pcntInit);
 
+  pulseBase   = 0;
+  pulseTop    = RTC_PULSE_FREQUENCY - 1;
+  secondStart = 0;
+
   /* Select PRS as the input for the PCNT */
   PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
 
-  /* Enable PCNT interrupt every second */
+  /* Enable PCNT interrupt on the wrap */
   NVIC_EnableIRQ(PCNT0_IRQn);
   PCNT_IntEnable(PCNT0, PCNT_IF_OF);
 }
 
 /***************************************************************************//**
- * @brief   This interrupt is triggered at every second by the PCNT
+ * @brief   This interrupt is triggered at the next deadline by the PCNT
  *
  ******************************************************************************/
 void PCNT0_IRQHandler(void)
 {
   PCNT_IntClear(PCNT0, PCNT_IF_OF);
+  pulseBase += pulseTop + 1;
 
-  pcntIrqCount++;
-
-  /* Increase time with 1s */
-  if (!(timeIsFastForwarding))
-  {
-    curTime++;
-
-    /* Check if current time is been set a a scheduled time*/
-    for(int i =0; i<10; i++)
-    {
-    	if(timeArray[i] == curTime) //turn on led
-    	{
-    		GPIO_PinOutSet(LED0_PORT, LED0_PIN);
-    		ledTime = curTime;
-    	}
-
-    	if(curTime >= ledTime+30) //after 30sec turn led back off
-    	{
-    		GPIO_PinOutClear(LED0_PORT, LED0_PIN);
-
-    	}
-    }
-  }
-
-  /* Notify main loop to redraw clock on display. */
-  if(!(scheduleTimeRequest))
-	  updateDisplay = true;
+  clockCatchUp();
+  wakeupSet();
 }
 
 /***************************************************************************//**
@@ -197,9 +395,9 @@ void fastForwardTime(void (*drawClock)(struct tm*, bool redraw))
   struct tm    *time;
 
   /* Wait 2 seconds before starting to adjust quickly */
-  int waitForPcntIrqCount = pcntIrqCount + 2;
+  int waitForSecondCount = secondCount + 2;
 
-  while (pcntIrqCount != waitForPcntIrqCount) {
+  while (secondCount != waitForSecondCount) {
     /* Return if the button is released */
     if (GPIO_PinInGet(BSP_GPIO_PB1_PORT, BSP_GPIO_PB1_PIN) == 1)
     {
@@ -208,14 +406,15 @@ void fastForwardTime(void (*drawClock)(struct tm*, bool redraw))
     	else
     		time = gmtime((time_t const *) &curTime);
     	timeIsFastForwarding = false;
-    	drawClock(time, true);
+    	clockReschedule();
+    	drawClock(time, false);
     	return;
     }
 
     /* Keep updating the second counter while waiting */
     if (updateDisplay) {
     	time = gmtime((time_t const *) &curTime);
-    	drawClock(time, true);
+    	drawClock(time, false);
     }
 
     EMU_EnterEM2(false);
@@ -238,11 +437,12 @@ void fastForwardTime(void (*drawClock)(struct tm*, bool redraw))
     	}
 
 
-      drawClock(time, true);
+      drawClock(time, false);
     }
     i++;
   }
   timeIsFastForwarding = false;
+  clockReschedule();
 }
 
 void scheduleTime(void (*drawClock)(struct tm*, bool redraw))
@@ -255,36 +455,89 @@ void scheduleTime(void (*drawClock)(struct tm*, bool redraw))
   curCount += 1;
   buttonPressed = false;
   counttime = gmtime((time_t const *) &curCount);
-  drawClock(counttime, true);
+  drawClock(counttime, false);
   }
 
 if(curCount > 10)
   {
 	  curCount = 0;
 	  scheduleTimeRequest = false;
+	  clockReschedule();
+  }
+}
+
+/***************************************************************************//**
+ * @brief  Draws one segment rectangle black into a glyph.
+ *
+ ******************************************************************************/
+static void glyphSegment(unsigned int g, const uint8_t *rect, unsigned int rowOffset)
+{
+  unsigned int row, col;
+
+  for (row = rect[0] + rowOffset; row < rect[0] + rowOffset + rect[1]; row++) {
+    for (col = rect[2]; col < rect[2] + rect[3]; col++) {
+      glyphData[g][row][col / 8] &= ~(1 << (col % 8));
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief  Renders the clock glyphs, so that an update only copies them.
+ *
+ ******************************************************************************/
+static void glyphInit(void)
+{
+  unsigned int g, s;
+
+  memset(glyphData, LCD_DMA_WHITE, sizeof(glyphData));
+  for (g = 0; g < 10; g++) {
+    for (s = 0; s < 7; s++) {
+      if (digitSegments[g] & (1 << s)) {
+        glyphSegment(g, segmentRect[s], 0);
+      }
+    }
+  }
+  glyphSegment(GLYPH_COLON, segmentRect[7], 0);
+  glyphSegment(GLYPH_COLON, segmentRect[7], 8);
+
+  for (g = 0; g < GLYPH_COUNT; g++) {
+    glyph[g].data       = &glyphData[g][0][0];
+    glyph[g].widthBytes = GLYPH_WIDTH_BYTES;
+    glyph[g].height     = CLOCK_HEIGHT;
+    glyph[g].stride     = GLYPH_WIDTH_BYTES;
   }
 }
 
 /***************************************************************************//**
  * @brief  Updates the digital clock.
+ *         Only the characters that changed are copied into the framebuffer
+ *         by the DMA, and only their lines are sent to the display.
  *
  ******************************************************************************/
 void digitalClockUpdate(struct tm *time, bool redraw)
 {
   char clockString[16];
+  unsigned int i;
 
   if (redraw) {
-    GLIB_setFont(&gc, (GLIB_Font_t *)&GLIB_FontNumber16x20);
-    gc.backgroundColor = White;
-    gc.foregroundColor = Black;
-    GLIB_clear(&gc);
+    lcdDmaClear();
+    memset(clockShown, 0, sizeof(clockShown));
   }
 
   sprintf(clockString, "%02d:%02d:%02d", time->tm_hour, time->tm_min, time->tm_sec);
-  GLIB_drawString(&gc, clockString, strlen(clockString), 1, 52, true);
+  for (i = 0; i < CLOCK_CHARS; i++) {
+    if (clockString[i] == clockShown[i]) {
+      continue;
+    }
+    clockShown[i] = clockString[i];
+    lcdBlit(lcdDmaLines(CLOCK_Y, CLOCK_HEIGHT) + i * GLYPH_WIDTH_BYTES, LCD_DMA_STRIDE,
+            &glyph[clockString[i] == ':' ? GLYPH_COLON : clockString[i] - '0']);
+  }
+  lcdBlitWait();
 
   /* Update display */
-  DMD_updateDisplay();
+  lcdDmaFlush();
+  lcdDmaWait();
 }
 
 
@@ -314,6 +567,78 @@ void digitalClockShow(bool redraw)
   }
 }
 
+/***************************************************************************//**
+ * @brief  Energy in nJ of 'cycles' core clock cycles at a supply current
+ *         of uaPerMhz.
+ *
+ ******************************************************************************/
+static uint32_t energyNj(uint32_t uaPerMhz, uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)uaPerMhz * cycles * SUPPLY_MV) / 1000000);
+}
+
+/***************************************************************************//**
+ * @brief  Prints one result line of the flush benchmark.
+ *
+ ******************************************************************************/
+static void benchmarkLine(const char *name, uint32_t cycles, uint32_t nj, int32_t y)
+{
+  char line[24];
+  uint32_t us = cycles / (CMU_ClockFreqGet(cmuClock_CORE) / 1000000);
+
+  snprintf(line, sizeof(line), "%s%6lu us %3lu.%luuJ", name, (unsigned long)us,
+           (unsigned long)(nj / 1000), (unsigned long)(nj % 1000 / 100));
+  GLIB_drawString(&gc, line, strlen(line), 1, y, true);
+}
+
+/***************************************************************************//**
+ * @brief  Compares a display refresh by the CPU (DMD) with the DMA flush,
+ *         for a full frame and for the lines of a clock update.
+ *
+ *         DMD_updateDisplay sends the frame from the CPU in EM0. The DMA
+ *         flush costs EM0 only while the chain is built, the CPU sleeps in
+ *         EM1 while the USART paces the transfer.
+ *
+ ******************************************************************************/
+void lcdFlushBenchmark(void)
+{
+  const lcdDmaStats_TypeDef *stats = lcdDmaStatsGet();
+  uint32_t t0, cpuCycles, fullCycles, fullNj, clockCycles, clockNj;
+  unsigned int y;
+
+  GLIB_clear(&gc);
+  t0 = cycleCounterGet();
+  DMD_updateDisplay();
+  cpuCycles = (cycleCounterGet() - t0) & CYCLE_COUNTER_MASK;
+
+  lcdDmaClear();
+  lcdDmaFlush();
+  lcdDmaWait();
+  fullCycles = stats->cyclesLast;
+  fullNj     = energyNj(EM0_UA_PER_MHZ, stats->cyclesSetup)
+               + energyNj(EM1_UA_PER_MHZ, stats->cyclesLast - stats->cyclesSetup);
+
+  for (y = CLOCK_Y; y < CLOCK_Y + CLOCK_HEIGHT; y++) {
+    lcdDmaLine(y);
+  }
+  lcdDmaFlush();
+  lcdDmaWait();
+  clockCycles = stats->cyclesLast;
+  clockNj     = energyNj(EM0_UA_PER_MHZ, stats->cyclesSetup)
+                + energyNj(EM1_UA_PER_MHZ, stats->cyclesLast - stats->cyclesSetup);
+
+  GLIB_setFont(&gc, (GLIB_Font_t *)&GLIB_FontNarrow6x8);
+  gc.backgroundColor = White;
+  gc.foregroundColor = Black;
+  GLIB_clear(&gc);
+  GLIB_drawString(&gc, "Frame refresh", strlen("Frame refresh"), 1, 20, true);
+  benchmarkLine("CPU", cpuCycles, energyNj(EM0_UA_PER_MHZ, cpuCycles), 32);
+  benchmarkLine("DMA", fullCycles, fullNj, 42);
+  GLIB_drawString(&gc, "Clock lines", strlen("Clock lines"), 1, 62, true);
+  benchmarkLine("DMA", clockCycles, clockNj, 74);
+  DMD_updateDisplay();
+}
+
 /***************************************************************************//**
  * @brief  Main function of clock example.
  *
@@ -353,14 +678,36 @@ int main(void)
       ;
   }
 
-  /* Set PCNT to generate interrupt every second */
+  /* Set PCNT to wake up at the first second */
   pcntInit();
 
+  /* Initialize the DMA and the DMA flushed framebuffer, the blitter takes
+   * its channel first as the 2D copy only exists on channel 0 */
+  CMU_ClockEnable(cmuClock_DMA, true);
+  DMA_Init_TypeDef dmaInit;
+  dmaInit.hprot        = 0;
+  dmaInit.controlBlock = dmaControlBlock;
+  DMA_Init(&dmaInit);
+  if (!lcdBlitInit() || !lcdDmaInit()) {
+    while (true)
+      ;
+  }
+  glyphInit();
+
+  /* Show the refresh time and energy of both paths for a while */
+  lcdFlushBenchmark();
+  while (secondCount < BENCHMARK_SHOW_SECONDS) {
+    EMU_EnterEM2(false);
+  }
+
+  /* The benchmark screen goes, the first clock sends the whole frame */
+  updateDisplay = true;
+  digitalClockShow(true);
 
-  /* Enter infinite loop.*/
+  /* Enter infinite loop, only changed digits and the clock lines from now */
   while (true) {
-	digitalClockShow(true);
     /*Sleep between each frame update */
     EMU_EnterEM2(false);
+	digitalClockShow(false);
   }
 }
@@ -0,0 +1,196 @@
+/**************************************************************************//**
+ * @file half_bridge.c
+ * @brief Full bridge drive from two complementary PWM pairs
+ *
+ * Legs A and B of an H-bridge are driven at PWM_HZ, center aligned, with
+ * DEAD_TIME_NS between the high and low side of each leg. Leg B runs at the
+ * inverse duty cycle of leg A, so the load sees a bipolar voltage that
+ * slowly sweeps from -80 % to +80 % and back. Both legs are updated in the
+ * same period.
+ *
+ * An active high overcurrent signal on FAULT_PIN turns all gates off in
+ * hardware through PRS channel FAULT_PRS_CH. The fault is reported and
+ * cleared from the TIMER1 tick once the signal is low again.
+ *****************************************************************************/
+#include <stdio.h>
+
+#include "em_device.h"
+#include "em_chip.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+#include "display.h"
+#include "textdisplay.h"
+#include "retargettextdisplay.h"
+
+#include "pwm_dti.h"
+
+#define PWM_HZ            20000
+#define DEAD_TIME_NS      500
+
+/* TIMER0 location 1: CC0 PA0, CC1 PA1, CDTI0 PC13, CDTI1 PC14 */
+#define BRIDGE_LOCATION   TIMER_ROUTE_LOCATION_LOC1
+#define LEG_A             0
+#define LEG_B             1
+
+/* Overcurrent comparator output, active high */
+#define FAULT_PORT        gpioPortC
+#define FAULT_PIN         0
+#define FAULT_PRS_CH      0
+
+/* Duty cycle sweep, steps per second and range */
+#define SWEEP_HZ          10
+#define SWEEP_STEP        25
+#define SWEEP_MIN         100
+#define SWEEP_MAX         900
+
+static DISPLAY_Device_t displayDevice;    /* Display device handle.*/
+
+static volatile bool tick = false;
+
+/**************************************************************************//**
+ * @brief TIMER1 overflow, the sweep step
+ *****************************************************************************/
+void TIMER1_IRQHandler(void)
+{
+  TIMER_IntClear(TIMER1, TIMER_IFC_OF);
+  tick = true;
+}
+
+/**************************************************************************//**
+ * @brief Gate pins low and the fault input on the PRS
+ *****************************************************************************/
+static void setupPins(void)
+{
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+
+  GPIO_PinModeSet(gpioPortA, 0, gpioModePushPull, 0);
+  GPIO_PinModeSet(gpioPortA, 1, gpioModePushPull, 0);
+  GPIO_PinModeSet(gpioPortC, 13, gpioModePushPull, 0);
+  GPIO_PinModeSet(gpioPortC, 14, gpioModePushPull, 0);
+
+  /* The pin is a PRS producer once selected for its external interrupt,
+   * the interrupt itself stays off */
+  GPIO_PinModeSet(FAULT_PORT, FAULT_PIN, gpioModeInputPull, 0);
+  GPIO_IntConfig(FAULT_PORT, FAULT_PIN, false, false, false);
+  PRS_SourceSignalSet(FAULT_PRS_CH, PRS_CH_CTRL_SOURCESEL_GPIOL,
+                      PRS_CH_CTRL_SIGSEL_GPIOPIN0, prsEdgeOff);
+}
+
+/**************************************************************************//**
+ * @brief TIMER1 overflow at SWEEP_HZ
+ *****************************************************************************/
+static void setupTick(void)
+{
+  CMU_ClockEnable(cmuClock_TIMER1, true);
+
+  const TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = true,
+    .debugRun   = false,
+    .prescale   = timerPrescale1024,
+    .clkSel     = timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = false,
+  };
+
+  TIMER_TopSet(TIMER1, CMU_ClockFreqGet(cmuClock_TIMER1) / 1024 / SWEEP_HZ - 1);
+  TIMER_Init(TIMER1, &timerInit);
+  TIMER_IntEnable(TIMER1, TIMER_IEN_OF);
+  NVIC_EnableIRQ(TIMER1_IRQn);
+}
+
+/**************************************************************************//**
+ * @brief  Main function
+ *****************************************************************************/
+int main(void)
+{
+  uint32_t duty[PWM_DTI_CHANNELS] = { 500, 500, 0 };
+  uint32_t deadTimeNs;
+  int32_t step = SWEEP_STEP;
+  bool faulted = false;
+
+  /* Chip errata */
+  CHIP_Init();
+
+  /* Initialize the LCD */
+  DISPLAY_Init();
+
+  /* Retrieve the properties of the display. */
+  if ( DISPLAY_DeviceGet(0, &displayDevice) != DISPLAY_EMSTATUS_OK ) {
+	  /* Unable to get display handle. */
+	  while ( 1 ) ;
+  }
+
+  /* Retarget stdio to the display. */
+  if ( TEXTDISPLAY_EMSTATUS_OK != RETARGET_TextDisplayInit() ) {
+	  /* Text display initialization failed. */
+	  while ( 1 ) ;
+  }
+
+  setupPins();
+
+  const pwmDtiInit_TypeDef pwmInit =
+  {
+    .frequency     = PWM_HZ,
+    .centerAligned = true,
+    .channelMask   = (1U << LEG_A) | (1U << LEG_B),
+    .location      = BRIDGE_LOCATION,
+    .deadTimeNs    = DEAD_TIME_NS,
+    .activeLow     = false,
+    .faultEnable   = { true, false },
+    .faultPrs      = { (TIMER_PRSSEL_TypeDef)FAULT_PRS_CH, timerPRSSELCh0 },
+    .faultAction   = timerDtiFaultActionInactive,
+  };
+  deadTimeNs = pwmDtiInit(&pwmInit);
+  pwmDtiDutySetAll(duty);
+
+  printf("H-bridge %lu Hz\nDead time %lu ns\n", (unsigned long)PWM_HZ,
+         (unsigned long)deadTimeNs);
+
+  setupTick();
+
+  while (1)
+  {
+    /* TIMER0 needs HFPERCLK, EM1 is as deep as it gets */
+    EMU_EnterEM1();
+    if (!tick)
+    {
+      continue;
+    }
+    tick = false;
+
+    if (pwmDtiFault())
+    {
+      if (!faulted)
+      {
+        faulted = true;
+        printf("\nFault, gates off");
+      }
+      if (GPIO_PinInGet(FAULT_PORT, FAULT_PIN))
+      {
+        continue;
+      }
+      pwmDtiFaultClear();
+      faulted = false;
+      printf("\nFault cleared");
+    }
+
+    if ((int32_t)duty[LEG_A] + step > SWEEP_MAX || (int32_t)duty[LEG_A] + step < SWEEP_MIN)
+    {
+      step = -step;
+    }
+    duty[LEG_A] += step;
+    duty[LEG_B] = PWM_DTI_DUTY_MAX - duty[LEG_A];
+    pwmDtiDutySetAll(duty);
+  }
+}
@@ -0,0 +1,257 @@
+/**************************************************************************//**
+ * @file pwm_dti.c
+ * @brief Complementary PWM with hardware dead time on TIMER0
+ *
+ * Edge aligned PWM counts up, the output is set on overflow and cleared on
+ * compare match: duty = CCV / (TOP + 1). Center aligned PWM counts up and
+ * down, the output is on while the counter is below CCV: duty = CCV / TOP.
+ * Either way CCVB is copied to CCV on the update event, so a new duty cycle
+ * never cuts a period short.
+ *
+ * The copy is per channel. For the channels of a multi-phase bridge to
+ * change in the same period the CCVB writes must not straddle an update
+ * event, pwmDtiDutySetAll() waits while the counter is within UPDATE_GUARD
+ * counts of one.
+ *****************************************************************************/
+#include "em_device.h"
+#include "em_assert.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_timer.h"
+#include "pwm_dti.h"
+
+#define PWM_TIMER       TIMER0
+#define MAX_TOP         0xFFFF
+#define MAX_PRESCALE    timerPrescale1024
+
+/* Dead time is 1 to 64 DTI clocks, HFPERCLK divided by 1 to 1024 */
+#define DT_MAX_CLOCKS   64
+#define DT_MAX_PRESCALE timerPrescale1024
+
+/* Counts before or after an update event where the buffers are not written */
+#define UPDATE_GUARD    16
+
+static uint32_t channels;
+static bool centerAligned;
+
+/**************************************************************************//**
+ * @brief Compare value for a duty cycle at the current TOP
+ *****************************************************************************/
+static uint32_t compareValue(uint32_t dutyPermille)
+{
+  uint32_t top = PWM_TIMER->TOP;
+
+  if (dutyPermille > PWM_DTI_DUTY_MAX)
+  {
+    dutyPermille = PWM_DTI_DUTY_MAX;
+  }
+  if (centerAligned)
+  {
+    return (uint32_t)(((uint64_t)top * dutyPermille) / PWM_DTI_DUTY_MAX);
+  }
+  /* Above TOP the output is never cleared, the high side stays on */
+  return (uint32_t)(((uint64_t)(top + 1) * dutyPermille) / PWM_DTI_DUTY_MAX);
+}
+
+/**************************************************************************//**
+ * @brief Dead time setting for at least deadTimeNs, returns it in ns
+ *****************************************************************************/
+static uint32_t deadTime(TIMER_InitDTI_TypeDef *dti, uint32_t clock, uint32_t deadTimeNs)
+{
+  uint32_t cycles = (uint32_t)(((uint64_t)deadTimeNs * clock + 999999999) / 1000000000);
+  uint32_t prescale = 0;
+  uint32_t count;
+
+  if (cycles == 0)
+  {
+    cycles = 1;
+  }
+  while (((cycles + (1UL << prescale) - 1) >> prescale) > DT_MAX_CLOCKS
+         && prescale < DT_MAX_PRESCALE)
+  {
+    prescale++;
+  }
+  count = (cycles + (1UL << prescale) - 1) >> prescale;
+  if (count > DT_MAX_CLOCKS)
+  {
+    count = DT_MAX_CLOCKS;
+  }
+
+  dti->prescale = (TIMER_Prescale_TypeDef)prescale;
+  dti->riseTime = count - 1;
+  dti->fallTime = count - 1;
+
+  return (uint32_t)(((uint64_t)count << prescale) * 1000000000 / clock);
+}
+
+/**************************************************************************//**
+ * @brief Set up TIMER0 and its DTI unit and start the PWM
+ * All duty cycles start at 0, the low sides on. The pins of the location
+ * must have been set to push-pull by the caller. Returns the dead time
+ * actually used, in ns.
+ *****************************************************************************/
+uint32_t pwmDtiInit(const pwmDtiInit_TypeDef *init)
+{
+  uint32_t clock, counts, top, route, actual;
+  uint32_t prescale = 0;
+  unsigned int cc;
+
+  EFM_ASSERT(init->frequency > 0);
+  EFM_ASSERT(init->channelMask != 0 && init->channelMask < (1U << PWM_DTI_CHANNELS));
+
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  clock = CMU_ClockFreqGet(cmuClock_TIMER0);
+
+  channels      = init->channelMask;
+  centerAligned = init->centerAligned;
+
+  /* Up/down counting takes two counts per TOP for one period */
+  counts = clock / init->frequency / (centerAligned ? 2 : 1);
+  while ((counts >> prescale) > MAX_TOP && prescale < MAX_PRESCALE)
+  {
+    prescale++;
+  }
+  top = counts >> prescale;
+  if (top > MAX_TOP)
+  {
+    top = MAX_TOP;
+  }
+  if (!centerAligned)
+  {
+    top--;
+  }
+  EFM_ASSERT(top > 4 * UPDATE_GUARD);
+
+  const TIMER_Init_TypeDef timerInit =
+  {
+    .enable     = false,
+    .debugRun   = false,                   /* Stops with the core, DTI faults on halt */
+    .prescale   = (TIMER_Prescale_TypeDef)prescale,
+    .clkSel     = timerClkSelHFPerClk,
+    .fallAction = timerInputActionNone,
+    .riseAction = timerInputActionNone,
+    .mode       = centerAligned ? timerModeUpDown : timerModeUp,
+    .dmaClrAct  = false,
+    .quadModeX4 = false,
+    .oneShot    = false,
+    .sync       = false,
+  };
+  TIMER_Init(PWM_TIMER, &timerInit);
+  TIMER_TopSet(PWM_TIMER, top);
+  TIMER_CounterSet(PWM_TIMER, 0);
+
+  const TIMER_InitCC_TypeDef timerCCInit =
+  {
+    .eventCtrl = timerEventEveryEdge,
+    .edge      = timerEdgeNone,
+    .prsSel    = timerPRSSELCh0,
+    .cufoa     = timerOutputActionNone,
+    .cofoa     = timerOutputActionNone,
+    .cmoa      = timerOutputActionNone,
+    .mode      = timerCCModePWM,
+    .filter    = false,
+    .prsInput  = false,
+    .coist     = false,
+    .outInvert = false,
+  };
+
+  route = init->location;
+  for (cc = 0; cc < PWM_DTI_CHANNELS; cc++)
+  {
+    if (channels & (1U << cc))
+    {
+      TIMER_InitCC(PWM_TIMER, cc, &timerCCInit);
+      TIMER_CompareSet(PWM_TIMER, cc, 0);
+      TIMER_CompareBufSet(PWM_TIMER, cc, 0);
+      route |= (TIMER_ROUTE_CC0PEN | TIMER_ROUTE_CDTI0PEN) << cc;
+    }
+  }
+
+  TIMER_InitDTI_TypeDef dtiInit =
+  {
+    .enable                      = true,
+    .activeLowOut                = init->activeLow,
+    .invertComplementaryOut      = false,
+    .autoRestart                 = true,   /* Resume after a debugger fault */
+    .enablePrsSource             = false,
+    .prsSel                      = timerPRSSELCh0,
+    .outputsEnableMask           = (channels * TIMER_DTOGEN_DTOGCC0EN)
+                                   | (channels * TIMER_DTOGEN_DTOGCDTI0EN),
+    .enableFaultSourceCoreLockup = true,
+    .enableFaultSourceDebugger   = true,
+    .enableFaultSourcePrsSel0    = init->faultEnable[0],
+    .faultSourcePrsSel0          = init->faultPrs[0],
+    .enableFaultSourcePrsSel1    = init->faultEnable[1],
+    .faultSourcePrsSel1          = init->faultPrs[1],
+    .faultAction                 = init->faultAction,
+  };
+  actual = deadTime(&dtiInit, clock, init->deadTimeNs);
+  TIMER_InitDTI(PWM_TIMER, &dtiInit);
+
+  PWM_TIMER->ROUTE = route;
+  TIMER_Enable(PWM_TIMER, true);
+
+  return actual;
+}
+
+/**************************************************************************//**
+ * @brief Set the duty cycle of one channel from the next period on
+ *****************************************************************************/
+void pwmDtiDutySet(unsigned int cc, uint32_t dutyPermille)
+{
+  EFM_ASSERT(cc < PWM_DTI_CHANNELS && (channels & (1U << cc)));
+
+  TIMER_CompareBufSet(PWM_TIMER, cc, compareValue(dutyPermille));
+}
+
+/**************************************************************************//**
+ * @brief Set the duty cycles of all enabled channels for the same period
+ * Entries of channels that are not enabled are ignored. May wait for up to
+ * 2 * UPDATE_GUARD timer counts with interrupts disabled.
+ *****************************************************************************/
+void pwmDtiDutySetAll(const uint32_t dutyPermille[PWM_DTI_CHANNELS])
+{
+  uint32_t ccv[PWM_DTI_CHANNELS];
+  uint32_t top = PWM_TIMER->TOP;
+  uint32_t cnt;
+  unsigned int cc;
+  CORE_DECLARE_IRQ_STATE;
+
+  for (cc = 0; cc < PWM_DTI_CHANNELS; cc++)
+  {
+    ccv[cc] = compareValue(dutyPermille[cc]);
+  }
+
+  CORE_ENTER_CRITICAL();
+  do
+  {
+    cnt = PWM_TIMER->CNT;
+  } while (cnt < UPDATE_GUARD || cnt > top - UPDATE_GUARD);
+
+  for (cc = 0; cc < PWM_DTI_CHANNELS; cc++)
+  {
+    if (channels & (1U << cc))
+    {
+      PWM_TIMER->CC[cc].CCVB = ccv[cc];
+    }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * @brief Faults that have turned the outputs off, TIMER_DTFAULT_* flags
+ *****************************************************************************/
+uint32_t pwmDtiFault(void)
+{
+  return TIMER_GetDTIFault(PWM_TIMER);
+}
+
+/**************************************************************************//**
+ * @brief Let the outputs run again after a fault
+ * Only once the fault input is inactive again, the outputs start with the
+ * dead time as after an edge.
+ *****************************************************************************/
+void pwmDtiFaultClear(void)
+{
+  TIMER_ClearDTIFault(PWM_TIMER, TIMER_GetDTIFault(PWM_TIMER));
+}
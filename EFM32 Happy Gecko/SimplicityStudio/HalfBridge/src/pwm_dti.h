@@ -0,0 +1,44 @@
+/**************************************************************************//**
+ * @file pwm_dti.h
+ * @brief Complementary PWM with hardware dead time on TIMER0
+ *
+ * Each enabled CC channel drives one half-bridge: the CC output the high
+ * side and its CDTI output the low side. The dead-time insertion unit keeps
+ * both off for the dead time around every edge, and a fault on one of two
+ * PRS channels turns them off without the CPU. Duty cycle changes go
+ * through the CCVB buffers and take effect at the next period, no
+ * interrupt is used per period. Only TIMER0 has the DTI unit.
+ *****************************************************************************/
+#ifndef PWM_DTI_H
+#define PWM_DTI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_timer.h"
+
+#define PWM_DTI_CHANNELS      3
+
+/* Duty cycles are given in 1/1000 of the period the high side is on,
+ * the dead time comes off both sides */
+#define PWM_DTI_DUTY_MAX      1000
+
+typedef struct
+{
+  uint32_t frequency;         /* PWM frequency, Hz */
+  bool     centerAligned;     /* Up/down counting, edges symmetric in the period */
+  uint32_t channelMask;       /* CC channels with an output pair, bit 0 is CC0 */
+  uint32_t location;          /* TIMER_ROUTE_LOCATION_LOCn of the outputs */
+  uint32_t deadTimeNs;        /* Both outputs off around every edge */
+  bool     activeLow;         /* Gate driver inputs active low */
+  bool     faultEnable[2];    /* Turn the outputs off on PRS faults */
+  TIMER_PRSSEL_TypeDef         faultPrs[2];
+  TIMER_DtiFaultAction_TypeDef faultAction;
+} pwmDtiInit_TypeDef;
+
+uint32_t pwmDtiInit(const pwmDtiInit_TypeDef *init);
+void pwmDtiDutySet(unsigned int cc, uint32_t dutyPermille);
+void pwmDtiDutySetAll(const uint32_t dutyPermille[PWM_DTI_CHANNELS]);
+uint32_t pwmDtiFault(void);
+void pwmDtiFaultClear(void);
+
+#endif /* PWM_DTI_H */
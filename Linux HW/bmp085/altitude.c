@@ -0,0 +1,53 @@
+#include <math.h>
+#include "altitude.h"
+
+//Altitude from pressure with the international barometric formula
+//	h = 44330 * (1 - (p/p0)^(1/5.255))
+//
+//altitudePow() computes it with libm for every sample. altitudeLookup() does
+//linear interpolation in a table that altitudeInit() fills once with the same
+//formula, every 256 Pa from 300 to 1100 hPa.
+//
+//Error bound of the interpolation: |h - h_lin| <= max|h''| * step^2 / 8, with
+//	h''(p) = 44330 * a * (1 - a) * p^(a - 2) / p0^a,  a = 1/5.255
+//largest at the lowest pressure. For p = 30000 Pa and p0 = 101325 Pa this is
+//6.0e-6 m/Pa^2, so with a step of 256 Pa the error stays below 0.05 m, plus
+//0.005 m from storing whole cm. For any p0 between 90000 and 110000 Pa the
+//bound stays below 0.06 m, well under the 0.25 m RMS noise of the sensor in
+//ultra high resolution mode. Outside the table range altitudePow() is used.
+
+//Function to fill the table for a reference pressure
+//Input : int32_t p0 -> pressure at altitude 0 in Pa, MSLP for height above sea level
+void altitudeInit(struct altitudeTable *table, int32_t p0)
+{
+	int i;
+
+	table->p0 = p0;
+	for(i=0; i<ALTITUDE_ENTRIES; i++)
+		table->cm[i] = altitudePow(ALTITUDE_PMIN + (i << ALTITUDE_SHIFT), p0);
+}
+
+//Function to convert a pressure to an altitude with the table
+//Output : altitude in cm
+int32_t altitudeLookup(const struct altitudeTable *table, int32_t pa)
+{
+	int32_t offset, index, frac, low, high;
+
+	if(pa < ALTITUDE_PMIN || pa > ALTITUDE_PMAX)
+		return altitudePow(pa, table->p0);
+
+	offset = pa - ALTITUDE_PMIN;
+	index = offset >> ALTITUDE_SHIFT;
+	frac = offset & ((1 << ALTITUDE_SHIFT) - 1);
+	low = table->cm[index];
+	high = table->cm[index + 1];
+
+	return low + (((high - low) * frac) >> ALTITUDE_SHIFT);
+}
+
+//Function to convert a pressure to an altitude with libm, the reference
+//Output : altitude in cm
+int32_t altitudePow(int32_t pa, int32_t p0)
+{
+	return lround(4433000.0 * (1.0 - pow((double)pa / p0, 1.0 / 5.255)));
+}
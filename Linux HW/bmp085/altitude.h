@@ -0,0 +1,23 @@
+#ifndef ALTITUDE
+#define ALTITUDE
+
+#include <stdint.h>
+
+//Table over the range of the BMP085 (300..1100 hPa), one entry every 256 Pa
+#define ALTITUDE_PMIN			30000
+#define ALTITUDE_PMAX			110000
+#define ALTITUDE_SHIFT			8
+#define ALTITUDE_ENTRIES		(((ALTITUDE_PMAX - ALTITUDE_PMIN) >> ALTITUDE_SHIFT) + 2)
+
+//Altitude in cm for every table pressure, relative to the pressure p0
+struct altitudeTable
+{
+	int32_t p0;
+	int32_t cm[ALTITUDE_ENTRIES];
+};
+
+void altitudeInit(struct altitudeTable *table, int32_t p0);
+int32_t altitudeLookup(const struct altitudeTable *table, int32_t pa);
+int32_t altitudePow(int32_t pa, int32_t p0);
+
+#endif
@@ -0,0 +1,461 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include "/usr/include/linux/i2c-dev.h"
+#include "bmp085.h"
+
+const int bmp085PressureWaittime[4] = {4500, 7500, 13500, 25500};
+
+//Calibration and raw values of the example in the datasheet (rev 1.2 p. 13),
+//the stub returns these so the result must be 15.0 C and 69964 Pa at oss 0
+static const struct bmp085Cal datasheetCal =
+	{408, -72, -14383, 32741, 32757, 23153, 6190, 4, -32768, -8711, 2868};
+#define DATASHEET_UT			27898
+#define DATASHEET_UP			23843
+
+static int commonInit(struct bmp085 *dev, int oss);
+
+double bmp085Now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void bmp085SleepUntil(double t)
+{
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)t;
+	ts.tv_nsec = (long)((t - ts.tv_sec) * 1e9);
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+//Function to read len registers from reg on in one transfer (repeated start)
+static int i2cRead(struct bmp085 *dev, int reg, unsigned char *data, int len)
+{
+	unsigned char addr = reg;
+	struct i2c_msg msgs[2] = {
+		{BMP085_ADDR, 0, 1, &addr},
+		{BMP085_ADDR, I2C_M_RD, len, data},
+	};
+	struct i2c_rdwr_ioctl_data xfer = {msgs, 2};
+
+	if(ioctl(dev->file, I2C_RDWR, &xfer) < 0)
+		return -errno;
+	return 0;
+}
+
+static int i2cWrite(struct bmp085 *dev, int reg, unsigned char value)
+{
+	unsigned char buf[2] = {reg, value};
+	struct i2c_msg msg = {BMP085_ADDR, 0, 2, buf};
+	struct i2c_rdwr_ioctl_data xfer = {&msg, 1};
+
+	if(ioctl(dev->file, I2C_RDWR, &xfer) < 0)
+		return -errno;
+	return 0;
+}
+
+static const struct bmp085Bus i2cBus = {i2cRead, i2cWrite};
+
+static int stubRead(struct bmp085 *dev, int reg, unsigned char *data, int len)
+{
+	if(reg + len > 256)
+		return -EINVAL;
+	memcpy(data, &dev->regs[reg], len);
+	return 0;
+}
+
+//Function to get the next recorded value of a kind ('t' or 'p') from the replay
+//file, starts again at the beginning when the end is reached
+static int32_t replayNext(struct bmp085 *dev, char kind, int32_t fallback)
+{
+	char k;
+	long value;
+	int rewound = 0;
+
+	while(rewound < 2)
+	{
+		if(fscanf(dev->replay, " %c %ld", &k, &value) == 2)
+		{
+			if(k == kind)
+				return value;
+		}
+		else
+		{
+			rewind(dev->replay);
+			rewound++;
+		}
+	}
+	return fallback;
+}
+
+//Register level model of the sensor: a conversion command puts the next raw
+//value in the output registers, the way the part does after the conversion time
+static int stubWrite(struct bmp085 *dev, int reg, unsigned char value)
+{
+	int32_t raw;
+	int oss;
+
+	dev->regs[reg] = value;
+	if(reg != CONTROL)
+		return 0;
+
+	if(value == READ_TEMPERATURE)
+	{
+		raw = DATASHEET_UT;
+		if(dev->replay != NULL)
+			raw = replayNext(dev, 't', raw);
+		dev->regs[CONTROL_OUTPUT] = raw >> 8;
+		dev->regs[CONTROL_OUTPUT+1] = raw;
+	}
+	else if((value & 0x3F) == READ_PRESSURE)
+	{
+		oss = value >> 6;
+		raw = DATASHEET_UP << oss;
+		if(dev->replay != NULL)
+			raw = replayNext(dev, 'p', raw);
+		raw <<= 8 - oss;
+		dev->regs[CONTROL_OUTPUT] = raw >> 16;
+		dev->regs[CONTROL_OUTPUT+1] = raw >> 8;
+		dev->regs[CONTROL_OUTPUT+2] = raw;
+	}
+	return 0;
+}
+
+static const struct bmp085Bus stubBus = {stubRead, stubWrite};
+
+//Function to initialise a sensor on an opened /dev/i2c-N
+//Input : int oss -> one of the MODE_ defines
+int bmp085Init(struct bmp085 *dev, int file, int oss)
+{
+	memset(dev, 0, sizeof(*dev));
+	dev->file = file;
+	dev->bus = &i2cBus;
+	return commonInit(dev, oss);
+}
+
+//Function to initialise a simulated sensor that gives the datasheet example values
+int bmp085InitStub(struct bmp085 *dev, int oss)
+{
+	const struct bmp085Cal *c = &datasheetCal;
+	int16_t words[CAL_SIZE/2] = {c->ac1, c->ac2, c->ac3, c->ac4, c->ac5, c->ac6,
+		c->b1, c->b2, c->mb, c->mc, c->md};
+	int i;
+
+	memset(dev, 0, sizeof(*dev));
+	dev->file = -1;
+	dev->bus = &stubBus;
+	dev->regs[CHIPID] = BMP085_CHIP_ID;
+	for(i=0; i<CAL_SIZE/2; i++)
+	{
+		dev->regs[CAL_AC1 + 2*i] = (uint16_t)words[i] >> 8;
+		dev->regs[CAL_AC1 + 2*i + 1] = words[i] & 0xFF;
+	}
+	return commonInit(dev, oss);
+}
+
+//Function to initialise a simulated sensor that plays back raw values from a file
+//written with dev->record ("t <UT>" and "p <UP>" lines)
+int bmp085InitReplay(struct bmp085 *dev, FILE *replay, int oss)
+{
+	int res = bmp085InitStub(dev, oss);
+
+	dev->replay = replay;
+	return res;
+}
+
+static int commonInit(struct bmp085 *dev, int oss)
+{
+	unsigned char id, buf[CAL_SIZE];
+	int res;
+
+	dev->oss = oss & 3;
+	dev->autoTemperature = true;
+	dev->eoc = -1;
+
+	if((res = dev->bus->read(dev, CHIPID, &id, 1)) < 0)
+		return res;
+	if(id != BMP085_CHIP_ID)
+		return -ENODEV;
+
+	//all calibration words in one burst, they never change so keep them
+	if((res = dev->bus->read(dev, CAL_AC1, buf, CAL_SIZE)) < 0)
+		return res;
+
+	dev->cal.ac1 = (buf[0] << 8) | buf[1];
+	dev->cal.ac2 = (buf[2] << 8) | buf[3];
+	dev->cal.ac3 = (buf[4] << 8) | buf[5];
+	dev->cal.ac4 = (buf[6] << 8) | buf[7];
+	dev->cal.ac5 = (buf[8] << 8) | buf[9];
+	dev->cal.ac6 = (buf[10] << 8) | buf[11];
+	dev->cal.b1 = (buf[12] << 8) | buf[13];
+	dev->cal.b2 = (buf[14] << 8) | buf[15];
+	dev->cal.mb = (buf[16] << 8) | buf[17];
+	dev->cal.mc = (buf[18] << 8) | buf[19];
+	dev->cal.md = (buf[20] << 8) | buf[21];
+
+	return 0;
+}
+
+//Function to start a conversion without waiting for it
+//Input : int cmd -> READ_TEMPERATURE or READ_PRESSURE (the mode is added here)
+int bmp085StartConversion(struct bmp085 *dev, int cmd)
+{
+	int wait = TEMPERATURE_WAITTIME;
+	int res;
+
+	if(cmd == READ_PRESSURE)
+	{
+		cmd += dev->oss << 6;
+		wait = bmp085PressureWaittime[dev->oss];
+	}
+
+	if((res = dev->bus->write(dev, CONTROL, cmd)) < 0)
+		return res;
+
+	dev->convEnd = bmp085Now() + wait / 1e6;
+	return 0;
+}
+
+//Function to check if the running conversion is done: EOC is high or the max
+//conversion time of the mode has passed
+bool bmp085ConversionReady(struct bmp085 *dev)
+{
+	char value;
+
+	if(bmp085Now() >= dev->convEnd)
+		return true;
+	if(dev->eoc >= 0 && pread(dev->eoc, &value, 1, 0) == 1)
+		return value == '1';
+	return false;
+}
+
+//Function to sleep until the running conversion is done
+void bmp085WaitConversion(struct bmp085 *dev)
+{
+	if(dev->eoc >= 0)
+	{
+		while(!bmp085ConversionReady(dev))
+			usleep(EOC_POLL_TIME);
+	}
+	else
+	{
+		bmp085SleepUntil(dev->convEnd);
+	}
+}
+
+int bmp085FetchTemperature(struct bmp085 *dev, int32_t *ut)
+{
+	unsigned char buf[2];
+	int res;
+
+	if((res = dev->bus->read(dev, CONTROL_OUTPUT, buf, 2)) < 0)
+		return res;
+
+	*ut = (buf[0] << 8) | buf[1];
+	if(dev->record != NULL)
+		fprintf(dev->record, "t %ld\n", (long)*ut);
+	return 0;
+}
+
+int bmp085FetchPressure(struct bmp085 *dev, int32_t *up)
+{
+	unsigned char buf[3];
+	int res;
+
+	if((res = dev->bus->read(dev, CONTROL_OUTPUT, buf, 3)) < 0)
+		return res;
+
+	*up = ((buf[0] << 16) | (buf[1] << 8) | buf[2]) >> (8 - dev->oss);
+	if(dev->record != NULL)
+		fprintf(dev->record, "p %ld\n", (long)*up);
+	return 0;
+}
+
+int bmp085ReadRawTemperature(struct bmp085 *dev, int32_t *ut)
+{
+	int res;
+
+	if((res = bmp085StartConversion(dev, READ_TEMPERATURE)) < 0)
+		return res;
+	bmp085WaitConversion(dev);
+	return bmp085FetchTemperature(dev, ut);
+}
+
+int bmp085ReadRawPressure(struct bmp085 *dev, int32_t *up)
+{
+	int res;
+
+	if((res = bmp085StartConversion(dev, READ_PRESSURE)) < 0)
+		return res;
+	bmp085WaitConversion(dev);
+	return bmp085FetchPressure(dev, up);
+}
+
+//Function to use the EOC pin of the sensor instead of the max conversion times
+//Input : int pin -> GPIO number, exported and set to input through sysfs
+int bmp085UseEoc(struct bmp085 *dev, int pin)
+{
+	FILE *fp;
+	char buffer[100];
+
+	fp = fopen("/sys/class/gpio/export", "w");
+	if(fp != NULL)
+	{
+		fprintf(fp, "%d", pin);
+		fclose(fp);
+	}
+
+	sprintf(buffer, "/sys/class/gpio/gpio%d/direction", pin);
+	fp = fopen(buffer, "w");
+	if(fp == NULL)
+		return -errno;
+	fprintf(fp, "in");
+	fclose(fp);
+
+	sprintf(buffer, "/sys/class/gpio/gpio%d/value", pin);
+	if((dev->eoc = open(buffer, O_RDONLY)) < 0)
+		return -errno;
+	return 0;
+}
+
+//Function to measure the temperature
+//Output : temperature in 0.1 C
+int bmp085GetTemperature(struct bmp085 *dev, int32_t *temperature)
+{
+	int32_t ut;
+	int res;
+
+	if((res = bmp085ReadRawTemperature(dev, &ut)) < 0)
+		return res;
+
+	*temperature = bmp085CompensateTemperature(&dev->cal, ut, &dev->b5);
+	dev->b5Valid = true;
+	return 0;
+}
+
+//Function to measure the pressure, also measures the temperature first when
+//autoTemperature is set or when there is no temperature yet
+//Output : pressure in Pa
+int bmp085GetPressure(struct bmp085 *dev, int32_t *pa)
+{
+	int32_t up, temperature;
+	int res;
+
+	if(dev->autoTemperature || !dev->b5Valid)
+	{
+		if((res = bmp085GetTemperature(dev, &temperature)) < 0)
+			return res;
+	}
+	if((res = bmp085ReadRawPressure(dev, &up)) < 0)
+		return res;
+
+	*pa = bmp085CompensatePressure(&dev->cal, dev->b5, up, dev->oss);
+	return 0;
+}
+
+//Function for the dynamic measurement mode of the datasheet: the temperature is
+//measured once per second and its B5 term is reused for all pressure conversions
+//in between, which run back to back at the max conversion time of the mode.
+//Input : double seconds -> how long to run
+//Input : bmp085Sample sample -> called for every pressure sample, may be NULL
+//Output : struct bmp085Rate *rate -> achieved and theoretical sample rate, may be NULL
+int bmp085RunDynamic(struct bmp085 *dev, double seconds, bmp085Sample sample, void *user,
+	struct bmp085Rate *rate)
+{
+	int32_t up, pa, temperature = 0;
+	double start, t, nextTemperature;
+	long pressures = 0, temperatures = 0;
+	bool autoTemperature = dev->autoTemperature;
+	int res = 0;
+
+	dev->autoTemperature = false;
+	start = bmp085Now();
+	nextTemperature = start;
+
+	for(t = start; t - start < seconds; t = bmp085Now())
+	{
+		if(t >= nextTemperature)
+		{
+			if((res = bmp085GetTemperature(dev, &temperature)) < 0)
+				break;
+			temperatures++;
+			nextTemperature += DYNAMIC_TEMPERATURE_PERIOD / 1e6;
+			continue;
+		}
+
+		if((res = bmp085ReadRawPressure(dev, &up)) < 0)
+			break;
+		pa = bmp085CompensatePressure(&dev->cal, dev->b5, up, dev->oss);
+		pressures++;
+
+		if(sample != NULL)
+			sample(dev, pa, temperature, user);
+	}
+
+	dev->autoTemperature = autoTemperature;
+
+	if(rate != NULL)
+	{
+		rate->oss = dev->oss;
+		rate->pressures = pressures;
+		rate->temperatures = temperatures;
+		rate->seconds = bmp085Now() - start;
+		rate->rate = pressures / rate->seconds;
+		rate->maxRate = (DYNAMIC_TEMPERATURE_PERIOD - TEMPERATURE_WAITTIME)
+			/ (double)bmp085PressureWaittime[dev->oss];
+	}
+	return res;
+}
+
+//Datasheet temperature compensation, integer only
+//Output : temperature in 0.1 C, b5 is needed for the pressure
+int32_t bmp085CompensateTemperature(const struct bmp085Cal *cal, int32_t ut, int32_t *b5)
+{
+	int32_t x1, x2;
+
+	x1 = ((ut - (int32_t)cal->ac6) * (int32_t)cal->ac5) >> 15;
+	x2 = ((int32_t)cal->mc * 2048) / (x1 + cal->md);
+	*b5 = x1 + x2;
+
+	return (*b5 + 8) >> 4;
+}
+
+//Datasheet pressure compensation, integer only
+//Output : pressure in Pa
+int32_t bmp085CompensatePressure(const struct bmp085Cal *cal, int32_t b5, int32_t up, int oss)
+{
+	int32_t x1, x2, x3, b3, b6, p;
+	uint32_t b4, b7;
+
+	b6 = b5 - 4000;
+	x1 = (cal->b2 * ((b6 * b6) >> 12)) >> 11;
+	x2 = (cal->ac2 * b6) >> 11;
+	x3 = x1 + x2;
+	b3 = ((((int32_t)cal->ac1 * 4 + x3) << oss) + 2) / 4;
+
+	x1 = (cal->ac3 * b6) >> 13;
+	x2 = (cal->b1 * ((b6 * b6) >> 12)) >> 16;
+	x3 = ((x1 + x2) + 2) >> 2;
+	b4 = ((uint32_t)cal->ac4 * (uint32_t)(x3 + 32768)) >> 15;
+	b7 = ((uint32_t)up - b3) * (uint32_t)(50000 >> oss);
+
+	if(b7 < 0x80000000)
+		p = (b7 * 2) / b4;
+	else
+		p = (b7 / b4) * 2;
+
+	x1 = (p >> 8) * (p >> 8);
+	x1 = (x1 * 3038) >> 16;
+	x2 = (-7357 * p) >> 16;
+
+	return p + ((x1 + x2 + 3791) >> 4);
+}
@@ -0,0 +1,111 @@
+#ifndef BMP085
+#define BMP085
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Register map and modes from VHDL/BMP085.h.txt
+#define BMP085_ADDR			0x77
+#define BMP085_CHIP_ID			0x55
+
+#define CAL_AC1				0xAA	//22 bytes of calibration data up to CAL_MD
+#define CAL_MD				0xBE
+#define CAL_SIZE			22
+#define CONTROL				0xF4
+#define CONTROL_OUTPUT			0xF6	//0xF6=MSB, 0xF7=LSB, 0xF8=XLSB
+#define CHIPID				0xD0
+
+#define MODE_ULTRA_LOW_POWER		0
+#define MODE_STANDARD			1
+#define MODE_HIGHRES			2
+#define MODE_ULTRA_HIGHRES		3
+
+#define READ_TEMPERATURE		0x2E
+#define READ_PRESSURE			0x34
+
+#define MSLP				101325	//Pa
+
+//Max conversion times in us (datasheet), index is the oversampling setting
+#define TEMPERATURE_WAITTIME		4500
+#define EOC_POLL_TIME			100	//us between reads of the EOC pin
+extern const int bmp085PressureWaittime[4];
+
+#define DYNAMIC_TEMPERATURE_PERIOD	1000000	//us, temperature once per second in dynamic mode
+
+struct bmp085;
+
+//Called for every pressure sample in dynamic mode
+typedef void (*bmp085Sample)(struct bmp085 *dev, int32_t pa, int32_t temperature, void *user);
+
+//What a dynamic measurement run achieved
+struct bmp085Rate
+{
+	int oss;
+	long pressures;
+	long temperatures;
+	double seconds;
+	double rate;		//pressure samples per second
+	double maxRate;		//what the conversion times allow
+};
+
+//Register access used by the driver, either the real adapter or the stub/replay
+struct bmp085Bus
+{
+	int (*read)(struct bmp085 *dev, int reg, unsigned char *data, int len);
+	int (*write)(struct bmp085 *dev, int reg, unsigned char value);
+};
+
+struct bmp085Cal
+{
+	int16_t ac1, ac2, ac3;
+	uint16_t ac4, ac5, ac6;
+	int16_t b1, b2, mb, mc, md;
+};
+
+struct bmp085
+{
+	int file;
+	const struct bmp085Bus *bus;
+	int oss;
+	bool autoTemperature;	//measure temperature before every pressure (AUTO_UPDATE_TEMPERATURE)
+
+	struct bmp085Cal cal;
+	int32_t b5;		//temperature term, kept for the next pressure
+	bool b5Valid;
+
+	int eoc;		//sysfs value file of the EOC pin, -1 when the max times are used
+	double convEnd;		//when the running conversion is done at the latest
+
+	FILE *record;		//if set, raw UT/UP values are logged for replay
+
+	//stub and replay state
+	unsigned char regs[256];
+	FILE *replay;
+};
+
+int bmp085Init(struct bmp085 *dev, int file, int oss);
+int bmp085InitStub(struct bmp085 *dev, int oss);
+int bmp085InitReplay(struct bmp085 *dev, FILE *replay, int oss);
+
+double bmp085Now(void);
+void bmp085SleepUntil(double t);
+int bmp085UseEoc(struct bmp085 *dev, int pin);
+int bmp085StartConversion(struct bmp085 *dev, int cmd);
+bool bmp085ConversionReady(struct bmp085 *dev);
+void bmp085WaitConversion(struct bmp085 *dev);
+int bmp085FetchTemperature(struct bmp085 *dev, int32_t *ut);
+int bmp085FetchPressure(struct bmp085 *dev, int32_t *up);
+
+int bmp085ReadRawTemperature(struct bmp085 *dev, int32_t *ut);
+int bmp085ReadRawPressure(struct bmp085 *dev, int32_t *up);
+int bmp085GetTemperature(struct bmp085 *dev, int32_t *temperature);
+int bmp085GetPressure(struct bmp085 *dev, int32_t *pa);
+
+int bmp085RunDynamic(struct bmp085 *dev, double seconds, bmp085Sample sample, void *user,
+	struct bmp085Rate *rate);
+
+int32_t bmp085CompensateTemperature(const struct bmp085Cal *cal, int32_t ut, int32_t *b5);
+int32_t bmp085CompensatePressure(const struct bmp085Cal *cal, int32_t b5, int32_t up, int oss);
+
+#endif
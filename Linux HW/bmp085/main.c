@@ -0,0 +1,210 @@
+//Build: gcc main.c bmp085.c altitude.c sampler.c -lm -o bmp085
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include "bmp085.h"
+#include "altitude.h"
+#include "sampler.h"
+
+static double seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Function to compare altitudeLookup() with altitudePow() on every Pa of the range
+static void altitudeBenchmark(void)
+{
+	static struct altitudeTable table;
+	volatile int32_t sink;
+	int32_t pa, diff, maxDiff = 0;
+	double start, tPow, tLookup;
+	int round, rounds = 20;
+
+	altitudeInit(&table, MSLP);
+
+	for(pa = ALTITUDE_PMIN; pa <= ALTITUDE_PMAX; pa++)
+	{
+		diff = labs((long)(altitudeLookup(&table, pa) - altitudePow(pa, MSLP)));
+		if(diff > maxDiff)
+			maxDiff = diff;
+	}
+
+	start = seconds();
+	for(round = 0; round < rounds; round++)
+		for(pa = ALTITUDE_PMIN; pa <= ALTITUDE_PMAX; pa++)
+			sink = altitudePow(pa, MSLP);
+	tPow = seconds() - start;
+
+	start = seconds();
+	for(round = 0; round < rounds; round++)
+		for(pa = ALTITUDE_PMIN; pa <= ALTITUDE_PMAX; pa++)
+			sink = altitudeLookup(&table, pa);
+	tLookup = seconds() - start;
+	(void)sink;
+
+	printf("max error  %ld cm\n", (long)maxDiff);
+	printf("pow()      %.1f ns/sample\n", tPow * 1e9 / (rounds * (ALTITUDE_PMAX - ALTITUDE_PMIN + 1)));
+	printf("table      %.1f ns/sample\n", tLookup * 1e9 / (rounds * (ALTITUDE_PMAX - ALTITUDE_PMIN + 1)));
+}
+
+//Stands in for the other devices on the bus in the -P run
+static void otherDevices(void *user)
+{
+	(*(long *)user)++;
+}
+
+//Usage: bmp085 [-d /dev/i2c-N] [-m mode 0..3] [-n samples] [-s] [-p replayfile] [-r recordfile]
+//  -s  stub: no sensor needed, gives the datasheet example values
+//  -p  replay raw values recorded earlier with -r
+//  -y  dynamic mode: run every oversampling mode for the given seconds and report
+//      the sample rate (temperature 1 Hz, pressure as fast as the mode allows)
+//  -a  compare the altitude table with pow() over 300..1100 hPa and exit
+//  -P  like -y, but pipelined: results are read the moment they are ready and the
+//      waits are given to other devices on the bus (here a dummy that only counts)
+//  -e  GPIO number of the EOC pin, otherwise the max conversion times are used
+int main(int argc, char *argv[])
+{
+	struct bmp085 dev;
+	char *device = "/dev/i2c-1";
+	char *replayName = NULL, *recordName = NULL;
+	bool stub = false;
+	int mode = MODE_STANDARD;
+	int samples = 10;
+	double dynamic = 0, pipelined = 0;
+	int eocPin = -1;
+	long otherCalls;
+	struct sampler sampler;
+	int opt, file, res, i;
+	int32_t temperature, pressure;
+	static struct altitudeTable altitude;
+	FILE *replay = NULL, *record = NULL;
+	struct bmp085Rate rate;
+
+	while((opt = getopt(argc, argv, "d:m:n:sp:r:y:aP:e:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'd': device = optarg; break;
+			case 'm': mode = atoi(optarg); break;
+			case 'n': samples = atoi(optarg); break;
+			case 's': stub = true; break;
+			case 'p': replayName = optarg; break;
+			case 'r': recordName = optarg; break;
+			case 'y': dynamic = atof(optarg); break;
+			case 'a': altitudeBenchmark(); return 0;
+			case 'P': pipelined = atof(optarg); break;
+			case 'e': eocPin = atoi(optarg); break;
+			default:
+				fprintf(stderr, "usage: %s [-d dev] [-m mode] [-n samples] [-s] [-p replay] [-r record] [-y seconds] [-a] [-P seconds] [-e pin]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if(replayName != NULL)
+	{
+		if((replay = fopen(replayName, "r")) == NULL)
+		{
+			perror(replayName);
+			return 1;
+		}
+		res = bmp085InitReplay(&dev, replay, mode);
+	}
+	else if(stub)
+	{
+		res = bmp085InitStub(&dev, mode);
+	}
+	else
+	{
+		if((file = open(device, O_RDWR)) < 0)
+		{
+			perror(device);
+			return 1;
+		}
+		res = bmp085Init(&dev, file, mode);
+	}
+
+	if(res < 0)
+	{
+		fprintf(stderr, "BMP085 init failed (%d)\n", res);
+		return 1;
+	}
+
+	if(eocPin >= 0 && bmp085UseEoc(&dev, eocPin) < 0)
+	{
+		fprintf(stderr, "EOC pin %d not usable\n", eocPin);
+		return 1;
+	}
+
+	if(recordName != NULL)
+		dev.record = record = fopen(recordName, "w");
+
+	if(dynamic > 0)
+	{
+		printf("mode  pressures  temperatures  rate (Hz)  max (Hz)\n");
+		for(i=MODE_ULTRA_LOW_POWER; i<=MODE_ULTRA_HIGHRES; i++)
+		{
+			dev.oss = i;
+			if(bmp085RunDynamic(&dev, dynamic, NULL, NULL, &rate) < 0)
+			{
+				fprintf(stderr, "BMP085 read failed\n");
+				break;
+			}
+			printf("%4d  %9ld  %12ld  %9.1f  %8.1f\n", rate.oss, rate.pressures,
+				rate.temperatures, rate.rate, rate.maxRate);
+		}
+		samples = 0;
+	}
+
+	if(pipelined > 0)
+	{
+		samplerInit(&sampler);
+		samplerAdd(&sampler, &dev);
+		sampler.idle = otherDevices;
+		sampler.idleUser = &otherCalls;
+
+		printf("mode  pressures  temperatures  rate (Hz)  max (Hz)  other (Hz)\n");
+		for(i=MODE_ULTRA_LOW_POWER; i<=MODE_ULTRA_HIGHRES; i++)
+		{
+			dev.oss = i;
+			otherCalls = 0;
+			if(samplerRun(&sampler, pipelined, &rate) < 0)
+			{
+				fprintf(stderr, "BMP085 read failed\n");
+				break;
+			}
+			printf("%4d  %9ld  %12ld  %9.1f  %8.1f  %10.0f\n", rate.oss, rate.pressures,
+				rate.temperatures, rate.rate, rate.maxRate, otherCalls / rate.seconds);
+		}
+		samples = 0;
+	}
+
+	altitudeInit(&altitude, MSLP);
+
+	//the temperature is measured just before, no need for a second one
+	dev.autoTemperature = false;
+
+	for(i=0; i<samples; i++)
+	{
+		if(bmp085GetTemperature(&dev, &temperature) < 0 || bmp085GetPressure(&dev, &pressure) < 0)
+		{
+			fprintf(stderr, "BMP085 read failed\n");
+			break;
+		}
+		printf("T = %ld.%ld C\n", (long)temperature / 10, labs((long)temperature % 10));
+		printf("p = %ld Pa\n", (long)pressure);
+		printf("h = %ld cm\n", (long)altitudeLookup(&altitude, pressure));
+		printf("-----\n");
+	}
+
+	if(record != NULL)
+		fclose(record);
+	if(replay != NULL)
+		fclose(replay);
+	return 0;
+}
@@ -0,0 +1,141 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "sampler.h"
+
+//Pipelined sampling: a conversion is started, the result is read as soon as
+//the sensor is done (EOC pin, or the max conversion time of the mode) and the
+//next conversion is started right away. While the sensors are converting the
+//idle callback is called once, if it fits before the first result is due, so
+//other devices on the bus are serviced without slowing the sensors down. The
+//rest of the wait is slept: polling EOC, or until the max conversion time.
+//Like bmp085RunDynamic() the temperature is only converted once per second.
+
+void samplerInit(struct sampler *s)
+{
+	memset(s, 0, sizeof(*s));
+}
+
+int samplerAdd(struct sampler *s, struct bmp085 *dev)
+{
+	if(s->count == SAMPLER_MAX)
+		return -ENOSPC;
+	s->dev[s->count++] = dev;
+	return 0;
+}
+
+//Function to read the finished conversion of a sensor and start the next one
+static int samplerService(struct sampler *s, struct bmp085 *dev, int *cmd,
+	double *nextTemperature, int32_t *temperature, struct bmp085Rate *rate)
+{
+	int32_t raw, pa;
+	int res;
+
+	if(*cmd == READ_TEMPERATURE)
+	{
+		if((res = bmp085FetchTemperature(dev, &raw)) < 0)
+			return res;
+		*temperature = bmp085CompensateTemperature(&dev->cal, raw, &dev->b5);
+		dev->b5Valid = true;
+		rate->temperatures++;
+	}
+	else
+	{
+		if((res = bmp085FetchPressure(dev, &raw)) < 0)
+			return res;
+		pa = bmp085CompensatePressure(&dev->cal, dev->b5, raw, dev->oss);
+		rate->pressures++;
+		if(s->sample != NULL)
+			s->sample(dev, pa, *temperature, s->sampleUser);
+	}
+
+	*cmd = READ_PRESSURE;
+	if(bmp085Now() >= *nextTemperature)
+	{
+		*cmd = READ_TEMPERATURE;
+		*nextTemperature += DYNAMIC_TEMPERATURE_PERIOD / 1e6;
+	}
+	return bmp085StartConversion(dev, *cmd);
+}
+
+//Function to sample all sensors for a while
+//Output : struct bmp085Rate rates[] -> one per sensor, may be NULL
+int samplerRun(struct sampler *s, double seconds, struct bmp085Rate *rates)
+{
+	int cmd[SAMPLER_MAX];
+	double nextTemperature[SAMPLER_MAX];
+	int32_t temperature[SAMPLER_MAX];
+	struct bmp085Rate rate[SAMPLER_MAX];
+	double start, t, earliest;
+	bool eoc = false, idled = false;
+	int i, res = 0;
+
+	memset(rate, 0, sizeof(rate));
+	start = bmp085Now();
+
+	//the first result of every sensor has to be a temperature
+	for(i=0; i<s->count; i++)
+	{
+		cmd[i] = READ_TEMPERATURE;
+		nextTemperature[i] = start + DYNAMIC_TEMPERATURE_PERIOD / 1e6;
+		temperature[i] = 0;
+		if(s->dev[i]->eoc >= 0)
+			eoc = true;
+		if((res = bmp085StartConversion(s->dev[i], READ_TEMPERATURE)) < 0)
+			return res;
+	}
+
+	while(bmp085Now() - start < seconds)
+	{
+		earliest = start + seconds;
+		for(i=0; i<s->count; i++)
+		{
+			if(bmp085ConversionReady(s->dev[i]))
+			{
+				res = samplerService(s, s->dev[i], &cmd[i], &nextTemperature[i],
+					&temperature[i], &rate[i]);
+				if(res < 0)
+					return res;
+				idled = false;
+			}
+			if(s->dev[i]->convEnd < earliest)
+				earliest = s->dev[i]->convEnd;
+		}
+
+		t = bmp085Now();
+		if(s->idle != NULL && !idled && t + s->idleTime < earliest)
+		{
+			//once per wait, calling it again would spin until the deadline
+			//and keep an EOC result waiting
+			s->idle(s->idleUser);
+			s->idleCalls++;
+			idled = true;
+			//running average, so one slow call does not block the idle work for long
+			s->idleTime += (bmp085Now() - t - s->idleTime) / 8;
+		}
+		else if(eoc)
+		{
+			if(earliest - t > EOC_POLL_TIME / 1e6)
+				usleep(EOC_POLL_TIME);
+		}
+		else
+		{
+			bmp085SleepUntil(earliest);
+		}
+	}
+
+	if(rates != NULL)
+	{
+		t = bmp085Now() - start;
+		for(i=0; i<s->count; i++)
+		{
+			rates[i] = rate[i];
+			rates[i].oss = s->dev[i]->oss;
+			rates[i].seconds = t;
+			rates[i].rate = rate[i].pressures / t;
+			rates[i].maxRate = (DYNAMIC_TEMPERATURE_PERIOD - TEMPERATURE_WAITTIME)
+				/ (double)bmp085PressureWaittime[s->dev[i]->oss];
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef SAMPLER
+#define SAMPLER
+
+#include "bmp085.h"
+
+#define SAMPLER_MAX			4	//sensors, each on its own adapter (fixed address 0x77)
+
+//Work for another device on the same bus, done while the sensors convert
+typedef void (*samplerIdle)(void *user);
+
+struct sampler
+{
+	struct bmp085 *dev[SAMPLER_MAX];
+	int count;
+
+	bmp085Sample sample;
+	void *sampleUser;
+	samplerIdle idle;
+	void *idleUser;
+
+	double idleTime;	//how long one idle call takes, to know if it fits in a wait
+	long idleCalls;
+};
+
+void samplerInit(struct sampler *s);
+int samplerAdd(struct sampler *s, struct bmp085 *dev);
+int samplerRun(struct sampler *s, double seconds, struct bmp085Rate *rates);
+
+#endif
@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include "/usr/include/linux/i2c-dev.h"
+#include "i2c_async.h"
+
+static void *i2cWorker(void *arg);
+static void executeBatch(struct i2cAsync *bus, struct i2cRequest *req);
+static void completeRequest(struct i2cAsync *bus, struct i2cRequest *req);
+
+//Function to start the worker thread that owns the adapter
+//Input : int file -> opened /dev/i2c-N
+//Input : int autoIncrement -> bit to set in the register address for bursts, 0 if the
+//        slave increments by itself, merging of adjacent reads is only done when not 0
+int i2cAsyncStart(struct i2cAsync *bus, int file, int autoIncrement)
+{
+	memset(bus, 0, sizeof(*bus));
+	bus->file = file;
+	bus->autoIncrement = autoIncrement;
+	bus->running = true;
+
+	pthread_mutex_init(&bus->lock, NULL);
+	pthread_cond_init(&bus->work, NULL);
+	pthread_cond_init(&bus->done, NULL);
+
+	if(pthread_create(&bus->worker, NULL, i2cWorker, bus) != 0)
+	{
+		bus->running = false;
+		return -1;
+	}
+	return 0;
+}
+
+//Function to stop the worker, requests already queued are still executed.
+//Completions that no longer fit in the ring are dropped.
+void i2cAsyncStop(struct i2cAsync *bus)
+{
+	pthread_mutex_lock(&bus->lock);
+	bus->running = false;
+	pthread_cond_broadcast(&bus->work);
+	pthread_cond_broadcast(&bus->done);
+	pthread_mutex_unlock(&bus->lock);
+
+	pthread_join(bus->worker, NULL);
+}
+
+//Function to queue count requests at once, so the worker sees them together and
+//can put them in the same I2C_RDWR call
+int i2cAsyncSubmitBatch(struct i2cAsync *bus, struct i2cRequest *req, int count)
+{
+	int i;
+
+	for(i=0; i<count; i++)
+	{
+		if(req[i].len < 1 || req[i].len >= I2C_BATCH_BYTES)
+			return -EINVAL;
+	}
+
+	pthread_mutex_lock(&bus->lock);
+	if(!bus->running)
+	{
+		pthread_mutex_unlock(&bus->lock);
+		return -EPIPE;
+	}
+
+	for(i=0; i<count; i++)
+	{
+		req[i].next = NULL;
+		if(bus->tail == NULL)
+			bus->head = &req[i];
+		else
+			bus->tail->next = &req[i];
+		bus->tail = &req[i];
+	}
+	pthread_cond_signal(&bus->work);
+	pthread_mutex_unlock(&bus->lock);
+
+	return 0;
+}
+
+int i2cAsyncSubmit(struct i2cAsync *bus, struct i2cRequest *req)
+{
+	return i2cAsyncSubmitBatch(bus, req, 1);
+}
+
+//Function to collect a finished request that had no callback
+//Input : bool wait -> block until one is available
+//Output : the request, or NULL if none (or the worker stopped)
+struct i2cRequest *i2cAsyncComplete(struct i2cAsync *bus, bool wait)
+{
+	struct i2cRequest *req = NULL;
+
+	pthread_mutex_lock(&bus->lock);
+	while(wait && bus->running && bus->ringHead == bus->ringTail)
+		pthread_cond_wait(&bus->done, &bus->lock);
+
+	if(bus->ringHead != bus->ringTail)
+	{
+		req = bus->ring[bus->ringTail % I2C_RING_SIZE];
+		bus->ringTail++;
+		pthread_cond_broadcast(&bus->done);
+	}
+	pthread_mutex_unlock(&bus->lock);
+
+	return req;
+}
+
+static void *i2cWorker(void *arg)
+{
+	struct i2cAsync *bus = arg;
+	struct i2cRequest *batch;
+
+	pthread_mutex_lock(&bus->lock);
+	while(1)
+	{
+		while(bus->running && bus->head == NULL)
+			pthread_cond_wait(&bus->work, &bus->lock);
+
+		//stopped and nothing left to do
+		if(bus->head == NULL)
+			break;
+
+		//take everything that is queued, new requests start a new list
+		batch = bus->head;
+		bus->head = NULL;
+		bus->tail = NULL;
+		pthread_mutex_unlock(&bus->lock);
+
+		executeBatch(bus, batch);
+
+		pthread_mutex_lock(&bus->lock);
+	}
+	pthread_mutex_unlock(&bus->lock);
+
+	return NULL;
+}
+
+//Function to run a list of requests with as few I2C_RDWR calls as possible.
+//Every request becomes one write message (register + data) or a write/read pair
+//(register, then repeated start and read). A read of the same slave that continues
+//where the previous read stopped is added to that read message instead.
+static void executeBatch(struct i2cAsync *bus, struct i2cRequest *req)
+{
+	struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+	struct i2c_rdwr_ioctl_data xfer;
+	unsigned char regs[I2C_RDWR_IOCTL_MAX_MSGS];
+	unsigned char buf[I2C_BATCH_BYTES];
+	struct i2cRequest *first, *prev, *next;
+	int nmsgs, used, lastRead, result;
+
+	while(req != NULL)
+	{
+		first = req;
+		prev = NULL;
+		nmsgs = 0;
+		used = 0;
+		lastRead = -1;
+
+		while(req != NULL)
+		{
+			if(req->read && lastRead >= 0 && bus->autoIncrement
+				&& prev->addr == req->addr && prev->reg + prev->len == req->reg
+				&& used + req->len <= I2C_BATCH_BYTES)
+			{
+				msgs[lastRead].len += req->len;
+				regs[lastRead-1] |= bus->autoIncrement;
+				used += req->len;
+			}
+			else if(req->read)
+			{
+				if(nmsgs + 2 > I2C_RDWR_IOCTL_MAX_MSGS || used + req->len > I2C_BATCH_BYTES)
+					break;
+
+				regs[nmsgs] = req->reg;
+				if(req->len > 1)
+					regs[nmsgs] |= bus->autoIncrement;
+				msgs[nmsgs].addr = req->addr;
+				msgs[nmsgs].flags = 0;
+				msgs[nmsgs].len = 1;
+				msgs[nmsgs].buf = &regs[nmsgs];
+				nmsgs++;
+
+				msgs[nmsgs].addr = req->addr;
+				msgs[nmsgs].flags = I2C_M_RD;
+				msgs[nmsgs].len = req->len;
+				msgs[nmsgs].buf = &buf[used];
+				lastRead = nmsgs;
+				nmsgs++;
+
+				used += req->len;
+			}
+			else
+			{
+				if(nmsgs + 1 > I2C_RDWR_IOCTL_MAX_MSGS || used + req->len + 1 > I2C_BATCH_BYTES)
+					break;
+
+				buf[used] = req->reg;
+				if(req->len > 1)
+					buf[used] |= bus->autoIncrement;
+				memcpy(&buf[used+1], req->data, req->len);
+
+				msgs[nmsgs].addr = req->addr;
+				msgs[nmsgs].flags = 0;
+				msgs[nmsgs].len = req->len + 1;
+				msgs[nmsgs].buf = &buf[used];
+				lastRead = -1;
+				nmsgs++;
+
+				used += req->len + 1;
+			}
+
+			prev = req;
+			req = req->next;
+		}
+
+		xfer.msgs = msgs;
+		xfer.nmsgs = nmsgs;
+		result = 0;
+		if(ioctl(bus->file, I2C_RDWR, &xfer) < 0)
+			result = -errno;
+		bus->transfers++;
+
+		//the data of the requests sits in buf in the same order as the list
+		used = 0;
+		for(; first != req; first = next)
+		{
+			next = first->next;
+			if(first->read)
+			{
+				if(result == 0)
+					memcpy(first->data, &buf[used], first->len);
+				used += first->len;
+			}
+			else
+			{
+				used += first->len + 1;
+			}
+			first->result = result;
+			bus->requests++;
+			completeRequest(bus, first);
+		}
+	}
+}
+
+static void completeRequest(struct i2cAsync *bus, struct i2cRequest *req)
+{
+	if(req->callback != NULL)
+	{
+		req->callback(req, req->user);
+		return;
+	}
+
+	pthread_mutex_lock(&bus->lock);
+	while(bus->running && bus->ringHead - bus->ringTail == I2C_RING_SIZE)
+		pthread_cond_wait(&bus->done, &bus->lock);
+
+	//stopped and nobody collecting, drop it rather than block the join
+	if(bus->ringHead - bus->ringTail < I2C_RING_SIZE)
+	{
+		bus->ring[bus->ringHead % I2C_RING_SIZE] = req;
+		bus->ringHead++;
+	}
+	pthread_cond_broadcast(&bus->done);
+	pthread_mutex_unlock(&bus->lock);
+}
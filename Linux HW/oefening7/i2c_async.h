@@ -0,0 +1,59 @@
+#ifndef I2C_ASYNC
+#define I2C_ASYNC
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#define I2C_RING_SIZE		64	//completions waiting to be collected, power of 2
+#define I2C_BATCH_BYTES		256	//scratch space for one coalesced I2C_RDWR call
+
+struct i2cRequest;
+
+//Called from the worker thread when a request has been executed
+//Input : req -> the finished request, req->result is 0 or -errno
+//Input : user -> the pointer that was given with the request
+typedef void (*i2cCallback)(struct i2cRequest *req, void *user);
+
+//One read or write of len bytes starting at register reg of slave addr.
+//The storage belongs to the caller and must stay valid until completion.
+struct i2cRequest
+{
+	int addr;
+	int reg;
+	bool read;
+	unsigned char *data;
+	int len;
+	i2cCallback callback;	//NULL -> completion goes to the completion ring
+	void *user;
+	int result;
+
+	struct i2cRequest *next;
+};
+
+struct i2cAsync
+{
+	int file;
+	int autoIncrement;	//or'ed into reg for bursts, 0x80 for the L3G4200D
+	bool running;
+
+	pthread_t worker;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+
+	struct i2cRequest *head, *tail;
+
+	struct i2cRequest *ring[I2C_RING_SIZE];
+	unsigned int ringHead, ringTail;
+
+	unsigned long requests;	//requests executed
+	unsigned long transfers;	//I2C_RDWR calls needed for them
+};
+
+int i2cAsyncStart(struct i2cAsync *bus, int file, int autoIncrement);
+void i2cAsyncStop(struct i2cAsync *bus);
+int i2cAsyncSubmit(struct i2cAsync *bus, struct i2cRequest *req);
+int i2cAsyncSubmitBatch(struct i2cAsync *bus, struct i2cRequest *req, int count);
+struct i2cRequest *i2cAsyncComplete(struct i2cAsync *bus, bool wait);
+
+#endif
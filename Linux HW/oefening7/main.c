@@ -1,10 +1,14 @@
+//Build: gcc main.c i2c_async.c -lpthread -o oefening7
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include "/usr/include/linux/i2c-dev.h"
 #include <stdlib.h>
 #include <fcntl.h>
 #include <math.h>
 #include <time.h>
+#include "i2c_async.h"
 
 void sensorInit(int file);
 int convertData(int decNumber);
@@ -17,10 +21,12 @@ int main(void)
 	int file;
 	int res;
 	int slaveAddr = 0x69;
-	int x_component_addr = 0x28; //and also 0x29
-	int y_component_addr = 0x2A; //and also 0x2B
-	int z_component_addr = 0x2C; //ans also 0x2D
+	int x_component_addr = 0x28; //x, y and z low/high bytes from 0x28 up to 0x2D
 	int x, y, z , x_H, x_L, y_H, y_L, z_H, z_L;
+	int i, err;
+	struct i2cAsync bus;
+	struct i2cRequest reads[6], *done;
+	unsigned char raw[6];
 	time_t new_t=0, prev_t;
 	double x_angle=0, y_angle=0, z_angle=0, diff_t;
 	
@@ -31,23 +37,61 @@ int main(void)
 		return 0;
 
 	sensorInit(file);
+
+	//0x80 in the sub-address makes the L3G4200D auto-increment
+	if(i2cAsyncStart(&bus, file, 0x80) < 0)
+		return 0;
+
 	prev_t = new_t;
 	time(&new_t);
 	diff_t = difftime(new_t, prev_t);
 	while(1)
 	{
-		x_L = i2c_smbus_read_byte_data(file, x_component_addr);
-		x_H = i2c_smbus_read_byte_data(file, x_component_addr+1);
+		//queue the six output registers together, the worker merges them
+		//into one burst read
+		for(i=0; i<6; i++)
+		{
+			reads[i].addr = slaveAddr;
+			reads[i].reg = x_component_addr + i;
+			reads[i].read = true;
+			reads[i].data = &raw[i];
+			reads[i].len = 1;
+			reads[i].callback = NULL;
+		}
+		if((err = i2cAsyncSubmitBatch(&bus, reads, 6)) < 0)
+		{
+			printf("i2c submit failed: %s\n", strerror(-err));
+			break;
+		}
+
+		//all six must have made it, otherwise raw[] holds old bytes
+		err = 0;
+		for(i=0; i<6; i++)
+		{
+			done = i2cAsyncComplete(&bus, true);
+			if(done == NULL)
+				err = -EPIPE;
+			else if(done->result < 0)
+				err = done->result;
+		}
+		if(err < 0)
+		{
+			printf("i2c read failed: %s\n", strerror(-err));
+			continue;
+		}
+
+		x_L = raw[0];
+		x_H = raw[1];
 		x = (x_H << 8) + x_L;
 		x = convertData(x)* 0.00875;
 		
-		y_L = i2c_smbus_read_byte_data(file, y_component_addr);
-		y_H = i2c_smbus_read_byte_data(file, y_component_addr+1);
+		y_L = raw[2];
+		y_H = raw[3];
 		y = (y_H << 8) + y_L;
 		y = convertData(y) * 0.00875;
 		
-		z_L = i2c_smbus_read_byte_data(file, z_component_addr);
-		z_H = i2c_smbus_read_byte_data(file, z_component_addr+1);
+		z_L = raw[4];
+		z_H = raw[5];
 		z = (z_H << 8) + z_L;
 		z = convertData(z) * 0.00875;		
 		
@@ -72,7 +116,7 @@ int main(void)
 	
 	}
 	
-	
+	i2cAsyncStop(&bus);
 	return 0;
 }
 